@@ -19,6 +19,7 @@ TJpg_Decoder TJpgDec;
 TJpg_Decoder::TJpg_Decoder(){
   // Setup a pointer to this class for static functions
   thisPtr = this;
+  memset(&_tblCache, 0, sizeof(_tblCache));
 }
 
 /***************************************************************************************
@@ -37,6 +38,77 @@ void TJpg_Decoder::setSwapBytes(bool swapBytes){
   _swap = swapBytes;
 }
 
+/***************************************************************************************
+** Function name:           setStreamMode
+** Description:             Reuse the decoder tables between frames of a motion JPEG
+***************************************************************************************/
+void TJpg_Decoder::setStreamMode(bool stream){
+  _stream = stream;
+  _tblCache.nseg = 0;
+}
+
+/***************************************************************************************
+** Function name:           setDecodeLevel
+** Description:             Select the tjpgd optimization level (1 or 2)
+***************************************************************************************/
+void TJpg_Decoder::setDecodeLevel(uint8_t level){
+  _level = level;
+  _tblCache.nseg = 0;
+}
+
+/***************************************************************************************
+** Function name:           setTableClip
+** Description:             Use the 1KB table for saturation arithmetic
+***************************************************************************************/
+void TJpg_Decoder::setTableClip(bool tblclip){
+  _tblclip = tblclip;
+}
+
+/***************************************************************************************
+** Function name:           setWorkspace
+** Description:             Use a caller supplied workspace (nullptr: built-in workspace)
+***************************************************************************************/
+void TJpg_Decoder::setWorkspace(uint8_t *buf, uint32_t size){
+  if (buf == nullptr || size < TJPGD_WORKSPACE_SIZE) {
+    buf = workspace;
+    size = TJPGD_WORKSPACE_SIZE;
+  }
+  _workspace = buf;
+  _workspaceSize = size;
+  _tblCache.nseg = 0;
+}
+
+/***************************************************************************************
+** Function name:           prepare
+** Description:             Parse the jpg header, reusing the cached tables in stream mode
+***************************************************************************************/
+JRESULT TJpg_Decoder::prepare(JDEC* jdec){
+  JRESULT jresult;
+  uint32_t start = micros();
+
+  jdec->hdrlen = 0;
+  // Level 2 only fits into a large workspace
+  jdec->level = (_level >= 2 && _workspaceSize >= TJPGD_WORKSPACE_SIZE_LUT) ? 2 : 1;
+  jdec->tblclip = _tblclip;
+  if (_stream) {
+    jresult = jd_prepare_cached(jdec, jd_input, _workspace, _workspaceSize, 0, &_tblCache);
+  }
+  else {
+    // The tables in the workspace are overwritten
+    _tblCache.nseg = 0;
+    jresult = jd_prepare(jdec, jd_input, _workspace, _workspaceSize, 0);
+  }
+
+  prepareMicros = micros() - start;
+  headerBytes = jdec->hdrlen;
+  tableSegs = _tblCache.nseg;
+  tableHits = _stream ? _tblCache.nhit : 0;
+  decodeLevel = jdec->level;
+  workspaceUsed = _workspaceSize - jdec->sz_pool;
+
+  return jresult;
+}
+
 /***************************************************************************************
 ** Function name:           setJpgScale
 ** Description:             Set the reduction scale factor (1, 2, 4 or 8)
@@ -75,7 +147,7 @@ void TJpg_Decoder::setCallback(SketchCallback sketchCallback)
 ** Function name:           jd_input (declared static)
 ** Description:             Called by tjpgd.c to get more data
 ***************************************************************************************/
-unsigned int TJpg_Decoder::jd_input(JDEC* jdec, uint8_t* buf, unsigned int len)
+size_t TJpg_Decoder::jd_input(JDEC* jdec, uint8_t* buf, size_t len)
 {
   TJpg_Decoder *thisPtr = TJpgDec.thisPtr;
   jdec = jdec; // Supress warning
@@ -87,8 +159,18 @@ unsigned int TJpg_Decoder::jd_input(JDEC* jdec, uint8_t* buf, unsigned int len)
       len = thisPtr->array_size - thisPtr->array_index;
     }
 
-    // If buf is valid then copy len bytes to buffer
-    if (buf) memcpy_P(buf, (const uint8_t *)(thisPtr->array_data + thisPtr->array_index), len);
+    // If buf is valid then copy len bytes to buffer, continuing into the second segment if needed
+    if (buf) {
+      uint32_t first = 0;
+      if (thisPtr->array_index < thisPtr->array_split) {
+        first = thisPtr->array_split - thisPtr->array_index;
+        if (first > len) first = len;
+        memcpy_P(buf, (const uint8_t *)(thisPtr->array_data + thisPtr->array_index), first);
+      }
+      if (len > first) {
+        memcpy(buf + first, thisPtr->array_data2 + (thisPtr->array_index + first - thisPtr->array_split), len - first);
+      }
+    }
 
     // Move pointer
     thisPtr->array_index += len;
@@ -292,7 +374,7 @@ JRESULT TJpg_Decoder::drawFsJpg(int32_t x, int32_t y, fs::File inFile) {
 
   jpgFile = inFile;
 
-  jresult = jd_prepare(&jdec, jd_input, workspace, TJPGD_WORKSPACE_SIZE, (unsigned int)0);
+  jresult = prepare(&jdec);
 
   // Extract image and render
   if (jresult == JDR_OK) {
@@ -352,7 +434,7 @@ JRESULT TJpg_Decoder::getFsJpgSize(uint16_t *w, uint16_t *h, fs::File inFile) {
 
   jpgFile = inFile;
 
-  jresult = jd_prepare(&jdec, jd_input, workspace, TJPGD_WORKSPACE_SIZE, 0);
+  jresult = prepare(&jdec);
 
   if (jresult == JDR_OK) {
     *w = jdec.width;
@@ -419,7 +501,7 @@ JRESULT TJpg_Decoder::drawSdJpg(int32_t x, int32_t y, File inFile) {
 
   jpgSdFile = inFile;
 
-  jresult = jd_prepare(&jdec, jd_input, workspace, TJPGD_WORKSPACE_SIZE, 0);
+  jresult = prepare(&jdec);
 
   // Extract image and render
   if (jresult == JDR_OK) {
@@ -481,7 +563,7 @@ JRESULT TJpg_Decoder::getSdJpgSize(uint16_t *w, uint16_t *h, File inFile) {
 
   jpgSdFile = inFile;
 
-  jresult = jd_prepare(&jdec, jd_input, workspace, TJPGD_WORKSPACE_SIZE, 0);
+  jresult = prepare(&jdec);
 
   if (jresult == JDR_OK) {
     *w = jdec.width;
@@ -501,13 +583,24 @@ JRESULT TJpg_Decoder::getSdJpgSize(uint16_t *w, uint16_t *h, File inFile) {
 ** Description:             Draw a jpg saved in a FLASH memory array
 ***************************************************************************************/
 JRESULT TJpg_Decoder::drawJpg(int32_t x, int32_t y, const uint8_t jpeg_data[], uint32_t  data_size) {
+  return drawJpg(x, y, jpeg_data, data_size, nullptr, 0);
+}
+
+/***************************************************************************************
+** Function name:           drawJpg
+** Description:             Draw a jpg split into two memory segments (e.g. a ring buffer)
+***************************************************************************************/
+JRESULT TJpg_Decoder::drawJpg(int32_t x, int32_t y, const uint8_t jpeg_data1[], uint32_t  data1_size,
+                              const uint8_t jpeg_data2[], uint32_t  data2_size) {
   JDEC jdec;
   JRESULT jresult = JDR_OK;
 
   jpg_source = TJPG_ARRAY;
   array_index = 0;
-  array_data  = jpeg_data;
-  array_size  = data_size;
+  array_data  = jpeg_data1;
+  array_data2 = jpeg_data2;
+  array_split = data1_size;
+  array_size  = data1_size + data2_size;
 
   jpeg_x = x;
   jpeg_y = y;
@@ -515,7 +608,7 @@ JRESULT TJpg_Decoder::drawJpg(int32_t x, int32_t y, const uint8_t jpeg_data[], u
   jdec.swap = _swap;
 
   // Analyse input data
-  jresult = jd_prepare(&jdec, jd_input, workspace, TJPGD_WORKSPACE_SIZE, 0);
+  jresult = prepare(&jdec);
 
   // Extract image and render
   if (jresult == JDR_OK) {
@@ -539,10 +632,12 @@ JRESULT TJpg_Decoder::getJpgSize(uint16_t *w, uint16_t *h, const uint8_t jpeg_da
   jpg_source = TJPG_ARRAY;
   array_index = 0;
   array_data  = jpeg_data;
+  array_data2 = nullptr;
+  array_split = data_size;
   array_size  = data_size;
 
   // Analyse input data
-  jresult = jd_prepare(&jdec, jd_input, workspace, TJPGD_WORKSPACE_SIZE, 0);
+  jresult = prepare(&jdec);
 
   if (jresult == JDR_OK) {
     *w = jdec.width;
@@ -63,7 +63,7 @@ public:
   ~TJpg_Decoder();
 
   static int jd_output(JDEC* jdec, void* bitmap, JRECT* jrect);
-  static unsigned int jd_input(JDEC* jdec, uint8_t* buf, unsigned int len);
+  static size_t jd_input(JDEC* jdec, uint8_t* buf, size_t len);
 
   void setJpgScale(uint8_t scale);
   void setCallback(SketchCallback sketchCallback);
@@ -98,16 +98,43 @@ public:
 #endif
 
   JRESULT drawJpg(int32_t x, int32_t y, const uint8_t array[], uint32_t  array_size);
+  JRESULT drawJpg(int32_t x, int32_t y, const uint8_t array1[], uint32_t  array1_size,
+                  const uint8_t array2[], uint32_t  array2_size);
   JRESULT getJpgSize(uint16_t *w, uint16_t *h, const uint8_t array[], uint32_t  array_size);
 
   void setSwapBytes(bool swap);
 
+  // Keep the Huffman/quantizer tables between frames of a motion JPEG stream and
+  // rebuild them only when the table segments change. Frames without DHT decode
+  // with the default tables. Do not mix with other users of the workspace.
+  void setStreamMode(bool stream);
+
+  // Decode level 1 (32-bit barrel shifter) or 2 (+ table Huffman decoding, needs
+  // TJPGD_WORKSPACE_SIZE_LUT bytes of workspace, otherwise level 1 is used) and
+  // table saturation. The workspace can be supplied by the caller, nullptr
+  // selects the built-in one (TJPGD_WORKSPACE_SIZE bytes).
+  void setDecodeLevel(uint8_t level);
+  void setTableClip(bool tblclip);
+  void setWorkspace(uint8_t *buf, uint32_t size);
+
   bool _swap = false;
 
   const uint8_t* array_data  = nullptr;
   uint32_t array_index = 0;
   uint32_t array_size  = 0;
 
+  // Optional second segment, used when the jpg wraps around the end of a ring buffer
+  const uint8_t* array_data2 = nullptr;
+  uint32_t array_split = 0;
+
+  // Header parse statistics of the last jd_prepare
+  uint32_t prepareMicros = 0;
+  uint32_t headerBytes = 0;
+  uint8_t  tableSegs = 0;  // Table segments (DHT/DQT) in the header cache
+  uint8_t  tableHits = 0;  // Table segments reused from the previous frame
+  uint8_t  decodeLevel = 0;    // Level used by the last jd_prepare
+  uint32_t workspaceUsed = 0;  // Workspace bytes used by the last jd_prepare
+
   // Must align workspace to a 32 bit boundary
   uint8_t workspace[TJPGD_WORKSPACE_SIZE] __attribute__((aligned(4)));
 
@@ -121,6 +148,17 @@ public:
   SketchCallback tft_output = nullptr;
 
   TJpg_Decoder *thisPtr = nullptr;
+
+private:
+  JRESULT prepare(JDEC* jdec);
+
+  bool _stream = false;
+  JDCACHE _tblCache;
+
+  uint8_t _level = 1;
+  bool _tblclip = false;
+  uint8_t *_workspace = workspace;
+  uint32_t _workspaceSize = TJPGD_WORKSPACE_SIZE;
 };
 
 extern TJpg_Decoder TJpgDec;
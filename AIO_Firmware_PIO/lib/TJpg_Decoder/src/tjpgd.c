@@ -65,13 +65,59 @@ static const uint16_t Ipsf[64] = {	/* See also aa_idct.png */
 
 
 
+/*------------------------------------------------*/
+/* Default huffman tables (ITU-T T.81 Annex K.3)   */
+/* used by abbreviated streams without DHT (MJPEG) */
+/*------------------------------------------------*/
+
+static const uint8_t Dht_default[416] = {	/* Content of a DHT segment */
+	/* DC table 0 (luminance) */
+	0x00,
+	0x00, 0x01, 0x05, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B,
+	/* DC table 1 (chrominance) */
+	0x01,
+	0x00, 0x03, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B,
+	/* AC table 0 (luminance) */
+	0x10,
+	0x00, 0x02, 0x01, 0x03, 0x03, 0x02, 0x04, 0x03, 0x05, 0x05, 0x04, 0x04, 0x00, 0x00, 0x01, 0x7D,
+	0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+	0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xA1, 0x08, 0x23, 0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0,
+	0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0A, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28,
+	0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+	0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+	0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+	0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7,
+	0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5,
+	0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2,
+	0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+	0xF9, 0xFA,
+	/* AC table 1 (chrominance) */
+	0x11,
+	0x00, 0x02, 0x01, 0x02, 0x04, 0x04, 0x03, 0x04, 0x07, 0x05, 0x04, 0x04, 0x00, 0x01, 0x02, 0x77,
+	0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+	0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xA1, 0xB1, 0xC1, 0x09, 0x23, 0x33, 0x52, 0xF0,
+	0x15, 0x62, 0x72, 0xD1, 0x0A, 0x16, 0x24, 0x34, 0xE1, 0x25, 0xF1, 0x17, 0x18, 0x19, 0x1A, 0x26,
+	0x27, 0x28, 0x29, 0x2A, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+	0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+	0x69, 0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+	0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5,
+	0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3,
+	0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA,
+	0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+	0xF9, 0xFA
+};
+
+
+
 /*---------------------------------------------*/
 /* Conversion table for fast clipping process  */
 /*---------------------------------------------*/
 
 #if JD_TBLCLIP
 
-#define BYTECLIP(v) Clip8[(unsigned int)(v) & 0x3FF]
+#define TBLCLIP(v) Clip8[(unsigned int)(v) & 0x3FF]
 
 static const uint8_t Clip8[1024] = {
 	/* 0..255 */
@@ -112,7 +158,7 @@ static const uint8_t Clip8[1024] = {
 	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
 };
 
-#else	/* JD_TBLCLIP */
+#endif	/* JD_TBLCLIP */
 
 static uint8_t BYTECLIP (int val)
 {
@@ -121,6 +167,10 @@ static uint8_t BYTECLIP (int val)
 	return (uint8_t)val;
 }
 
+#if JD_TBLCLIP
+#define RGBCLIP(v) (tblclip ? TBLCLIP(v) : BYTECLIP(v))	/* Saturation selected by jd->tblclip */
+#else
+#define RGBCLIP(v) BYTECLIP(v)
 #endif
 
 
@@ -236,7 +286,7 @@ static JRESULT create_huffman_tbl (	/* 0:OK, !0:Failed */
 			pd[i] = d;
 		}
 #if JD_FASTDECODE == 2
-		{	/* Create fast huffman decode table */
+		if (jd->level == 2) {	/* Create fast huffman decode table */
 			unsigned int span, td, ti;
 			uint16_t *tbl_ac = 0;
 			uint8_t *tbl_dc = 0;
@@ -275,6 +325,129 @@ static JRESULT create_huffman_tbl (	/* 0:OK, !0:Failed */
 
 
 
+/*-----------------------------------------------------------------------*/
+/* Table cache for motion JPEG streams                                   */
+/*-----------------------------------------------------------------------*/
+
+static uint32_t seg_hash (	/* FNV-1a fingerprint of a table segment */
+	uint8_t marker,			/* Segment marker (0xC4:DHT, 0xDB:DQT) */
+	const uint8_t* data,	/* Segment content */
+	size_t ndata			/* Size of the segment content */
+)
+{
+	uint32_t h = 2166136261UL ^ marker ^ (uint32_t)ndata << 8;
+
+
+	while (ndata--) {
+		h = (h ^ *data++) * 16777619UL;
+	}
+	return h;
+}
+
+
+static void drop_tables (	/* Discard the tables allocated at or after the current pool position */
+	JDEC* jd,				/* Pointer to the decompressor object */
+	JDCACHE* tc,			/* Table cache */
+	unsigned int nseg		/* Number of table segments to be left in the cache */
+)
+{
+	unsigned int i, j;
+	uint8_t *tail = (uint8_t*)jd->pool;
+
+
+	for (i = 0; i < 2; i++) {
+		for (j = 0; j < 2; j++) {
+			if (jd->huffbits[i][j] && jd->huffbits[i][j] >= tail) {
+				jd->huffbits[i][j] = 0; jd->huffcode[i][j] = 0; jd->huffdata[i][j] = 0;
+			}
+		}
+	}
+	for (i = 0; i < 4; i++) {
+		if (jd->qttbl[i] && (uint8_t*)jd->qttbl[i] >= tail) jd->qttbl[i] = 0;
+	}
+	tc->nseg = (uint8_t)nseg;
+}
+
+
+static JRESULT create_tables (	/* 0:OK, !0:Failed */
+	JDEC* jd,				/* Pointer to the decompressor object */
+	JDCACHE* tc,			/* Table cache (null:no cache) */
+	unsigned int* iseg,		/* Index of the table segment in this frame */
+	uint8_t marker,			/* Segment marker (0xC4:DHT, 0xDB:DQT) */
+	const uint8_t* data,	/* Segment content */
+	size_t ndata			/* Size of the segment content */
+)
+{
+	JRESULT rc;
+	uint32_t h = 0;
+
+
+	if (tc) {
+		h = seg_hash(marker, data, ndata);
+		if (*iseg < tc->nseg) {
+			if (tc->hash[*iseg] == h) {	/* Same segment as the previous frame: the tables are still in the pool */
+				jd->pool = (uint8_t*)tc->pool + tc->used[*iseg];
+				jd->sz_pool = tc->sz_pool - tc->used[*iseg];
+				(*iseg)++;
+				tc->nhit++;
+				return JDR_OK;
+			}
+			drop_tables(jd, tc, *iseg);	/* Tables changed: rebuild from this segment */
+		}
+	}
+
+	rc = (marker == 0xDB) ? create_qt_tbl(jd, data, ndata) : create_huffman_tbl(jd, data, ndata);
+	if (rc) return rc;
+
+	if (tc) {
+		if (*iseg < JD_CACHE_SEG) {	/* Register the segment */
+			tc->hash[*iseg] = h;
+			tc->used[*iseg] = (size_t)((uint8_t*)jd->pool - (uint8_t*)tc->pool);
+			tc->nseg = (uint8_t)++(*iseg);
+		} else {					/* Too many table segments to be cached */
+			tc->nseg = 0;
+		}
+	}
+	return JDR_OK;
+}
+
+
+static void save_tables (	/* Save the table pointers for the next frame */
+	JDEC* jd,				/* Pointer to the decompressor object */
+	JDCACHE* tc				/* Table cache */
+)
+{
+	memcpy(tc->huffbits, jd->huffbits, sizeof jd->huffbits);
+	memcpy(tc->huffcode, jd->huffcode, sizeof jd->huffcode);
+	memcpy(tc->huffdata, jd->huffdata, sizeof jd->huffdata);
+	memcpy(tc->qttbl, jd->qttbl, sizeof jd->qttbl);
+#if JD_FASTDECODE == 2
+	memcpy(tc->longofs, jd->longofs, sizeof jd->longofs);
+	memcpy(tc->hufflut_ac, jd->hufflut_ac, sizeof jd->hufflut_ac);
+	memcpy(tc->hufflut_dc, jd->hufflut_dc, sizeof jd->hufflut_dc);
+#endif
+}
+
+
+static void load_tables (	/* Restore the table pointers of the previous frame */
+	JDEC* jd,				/* Pointer to the decompressor object */
+	JDCACHE* tc				/* Table cache */
+)
+{
+	memcpy(jd->huffbits, tc->huffbits, sizeof jd->huffbits);
+	memcpy(jd->huffcode, tc->huffcode, sizeof jd->huffcode);
+	memcpy(jd->huffdata, tc->huffdata, sizeof jd->huffdata);
+	memcpy(jd->qttbl, tc->qttbl, sizeof jd->qttbl);
+#if JD_FASTDECODE == 2
+	memcpy(jd->longofs, tc->longofs, sizeof jd->longofs);
+	memcpy(jd->hufflut_ac, tc->hufflut_ac, sizeof jd->hufflut_ac);
+	memcpy(jd->hufflut_dc, tc->hufflut_dc, sizeof jd->hufflut_dc);
+#endif
+}
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Extract a huffman decoded data from input stream                      */
 /*-----------------------------------------------------------------------*/
@@ -367,34 +540,37 @@ static int huffext (	/* >=0: decoded data, <0: error code */
 	jd->wreg = w;
 
 #if JD_FASTDECODE == 2
-	/* Table serch for the short codes */
-	d = (unsigned int)(w >> (wbit - HUFF_BIT));	/* Short code as table index */
-	if (cls) {	/* AC element */
-		d = jd->hufflut_ac[id][d];	/* Table decode */
-		if (d != 0xFFFF) {	/* It is done if hit in short code */
-			jd->dbit = wbit - (d >> 8);	/* Snip the code length */
-			return d & 0xFF;	/* b7..0: zero run and following data bits */
-		}
-	} else {	/* DC element */
-		d = jd->hufflut_dc[id][d];	/* Table decode */
-		if (d != 0xFF) {	/* It is done if hit in short code */
-			jd->dbit = wbit - (d >> 4);	/* Snip the code length  */
-			return d & 0xF;	/* b3..0: following data bits */
+	if (jd->level == 2) {
+		/* Table serch for the short codes */
+		d = (unsigned int)(w >> (wbit - HUFF_BIT));	/* Short code as table index */
+		if (cls) {	/* AC element */
+			d = jd->hufflut_ac[id][d];	/* Table decode */
+			if (d != 0xFFFF) {	/* It is done if hit in short code */
+				jd->dbit = wbit - (d >> 8);	/* Snip the code length */
+				return d & 0xFF;	/* b7..0: zero run and following data bits */
+			}
+		} else {	/* DC element */
+			d = jd->hufflut_dc[id][d];	/* Table decode */
+			if (d != 0xFF) {	/* It is done if hit in short code */
+				jd->dbit = wbit - (d >> 4);	/* Snip the code length  */
+				return d & 0xF;	/* b3..0: following data bits */
+			}
 		}
-	}
 
-	/* Incremental serch for the codes longer than HUFF_BIT */
-	hb = jd->huffbits[id][cls] + HUFF_BIT;				/* Bit distribution table */
-	hc = jd->huffcode[id][cls] + jd->longofs[id][cls];	/* Code word table */
-	hd = jd->huffdata[id][cls] + jd->longofs[id][cls];	/* Data table */
-	bl = HUFF_BIT + 1;
-#else
-	/* Incremental serch for all codes */
-	hb = jd->huffbits[id][cls];	/* Bit distribution table */
-	hc = jd->huffcode[id][cls];	/* Code word table */
-	hd = jd->huffdata[id][cls];	/* Data table */
-	bl = 1;
+		/* Incremental serch for the codes longer than HUFF_BIT */
+		hb = jd->huffbits[id][cls] + HUFF_BIT;				/* Bit distribution table */
+		hc = jd->huffcode[id][cls] + jd->longofs[id][cls];	/* Code word table */
+		hd = jd->huffdata[id][cls] + jd->longofs[id][cls];	/* Data table */
+		bl = HUFF_BIT + 1;
+	} else
 #endif
+	{
+		/* Incremental serch for all codes */
+		hb = jd->huffbits[id][cls];	/* Bit distribution table */
+		hc = jd->huffcode[id][cls];	/* Code word table */
+		hd = jd->huffdata[id][cls];	/* Data table */
+		bl = 1;
+	}
 	for ( ; bl <= 16; bl++) {	/* Incremental search */
 		nc = *hb++;
 		if (nc) {
@@ -798,6 +974,9 @@ static JRESULT mcu_output (
 	jd_yuv_t *py, *pc;
 	uint8_t *pix;
 	JRECT rect;
+#if JD_TBLCLIP
+	const uint8_t tblclip = jd->tblclip;
+#endif
 
 
 	mx = jd->msx * 8; my = jd->msy * 8;					/* MCU size (pixel) */
@@ -812,7 +991,28 @@ static JRESULT mcu_output (
 	rect.top = y; rect.bottom = y + ry - 1;
 
 
-	if (!JD_USE_SCALE || jd->scale != 3) {	/* Not for 1/8 scaling */
+	if (JD_USE_SCALE && JD_FORMAT != 2 && jd->scale == 1) {	/* For only 1/2 scaling (average Y/C components of each 2x2 square before color conversion) */
+		unsigned int cx, cy;
+
+		pix = (uint8_t*)jd->workbuf;
+		cx = (mx == 16) ? 0 : 1;	/* Offset to the next chroma sample in the square */
+		cy = (my == 16) ? 0 : 8;
+		for (iy = 0; iy < my; iy += 2) {
+			for (ix = 0; ix < mx; ix += 2) {
+				py = jd->mcubuf + (iy & 7) * 8 + (ix & 7);	/* Y block of the square */
+				if (ix >= 8) py += 64;
+				if (iy >= 8) py += 64 * 2;
+				pc = jd->mcubuf + mx * my + (iy >> (my == 16)) * 8 + (ix >> (mx == 16));
+				yy = (py[0] + py[1] + py[8] + py[9] + 2) >> 2;
+				cb = ((pc[0] + pc[cx] + pc[cy] + pc[cx + cy] + 2) >> 2) - 128;
+				cr = ((pc[64] + pc[64 + cx] + pc[64 + cy] + pc[64 + cx + cy] + 2) >> 2) - 128;
+				*pix++ = /*R*/ RGBCLIP(yy + ((int)(1.402 * CVACC) * cr) / CVACC);
+				*pix++ = /*G*/ RGBCLIP(yy - ((int)(0.344 * CVACC) * cb + (int)(0.714 * CVACC) * cr) / CVACC);
+				*pix++ = /*B*/ RGBCLIP(yy + ((int)(1.772 * CVACC) * cb) / CVACC);
+			}
+		}
+
+	} else if (!JD_USE_SCALE || jd->scale != 3) {	/* Not for 1/8 scaling */
 		pix = (uint8_t*)jd->workbuf;
 
 		if (JD_FORMAT != 2) {	/* RGB output (build an RGB MCU from Y/C component) */
@@ -835,9 +1035,9 @@ static JRESULT mcu_output (
 						pc++;						/* Step forward chroma pointer every pixel */
 					}
 					yy = *py++;			/* Get Y component */
-					*pix++ = /*R*/ BYTECLIP(yy + ((int)(1.402 * CVACC) * cr) / CVACC);
-					*pix++ = /*G*/ BYTECLIP(yy - ((int)(0.344 * CVACC) * cb + (int)(0.714 * CVACC) * cr) / CVACC);
-					*pix++ = /*B*/ BYTECLIP(yy + ((int)(1.772 * CVACC) * cb) / CVACC);
+					*pix++ = /*R*/ RGBCLIP(yy + ((int)(1.402 * CVACC) * cr) / CVACC);
+					*pix++ = /*G*/ RGBCLIP(yy - ((int)(0.344 * CVACC) * cb + (int)(0.714 * CVACC) * cr) / CVACC);
+					*pix++ = /*B*/ RGBCLIP(yy + ((int)(1.772 * CVACC) * cb) / CVACC);
 				}
 			}
 		} else {	/* Monochrome output (build a grayscale MCU from Y comopnent) */
@@ -902,9 +1102,9 @@ static JRESULT mcu_output (
 				yy = *py;	/* Get Y component */
 				py += 64;
 				if (JD_FORMAT != 2) {
-					*pix++ = /*R*/ BYTECLIP(yy + ((int)(1.402 * CVACC) * cr / CVACC));
-					*pix++ = /*G*/ BYTECLIP(yy - ((int)(0.344 * CVACC) * cb + (int)(0.714 * CVACC) * cr) / CVACC);
-					*pix++ = /*B*/ BYTECLIP(yy + ((int)(1.772 * CVACC) * cb / CVACC));
+					*pix++ = /*R*/ RGBCLIP(yy + ((int)(1.402 * CVACC) * cr / CVACC));
+					*pix++ = /*G*/ RGBCLIP(yy - ((int)(0.344 * CVACC) * cb + (int)(0.714 * CVACC) * cr) / CVACC);
+					*pix++ = /*B*/ RGBCLIP(yy + ((int)(1.772 * CVACC) * cb / CVACC));
 				} else {
 					*pix++ = yy;
 				}
@@ -971,31 +1171,44 @@ static JRESULT mcu_output (
 #define	LDB_WORD(ptr)		(uint16_t)(((uint16_t)*((uint8_t*)(ptr))<<8)|(uint16_t)*(uint8_t*)((ptr)+1))
 
 
-JRESULT jd_prepare (
+static JRESULT prepare (
 	JDEC* jd,				/* Blank decompressor object */
 	size_t (*infunc)(JDEC*, uint8_t*, size_t),	/* JPEG strem input function */
 	void* pool,				/* Working buffer for the decompression session */
 	size_t sz_pool,			/* Size of working buffer */
-	void* dev				/* I/O device identifier for the session */
+	void* dev,				/* I/O device identifier for the session */
+	JDCACHE* tc				/* Table cache (null:no cache) */
 )
 {
 	uint8_t *seg, b;
 	uint16_t marker;
-	unsigned int n, i, ofs;
+	unsigned int n, i, ofs, iseg, ndht;
 	size_t len;
 	JRESULT rc;
 
   uint8_t tmp = jd->swap; // Copy the swap flag
+	uint8_t level = jd->level, tblclip = jd->tblclip;	/* Runtime options given by the caller */
 	memset(jd, 0, sizeof (JDEC));	/* Clear decompression object (this might be a problem if machine's null pointer is not all bits zero) */
 	jd->pool = pool;		/* Work memroy */
 	jd->sz_pool = sz_pool;	/* Size of given work memory */
 	jd->infunc = infunc;	/* Stream input function */
 	jd->device = dev;		/* I/O device identifier */
   jd->swap = tmp; // Restore the swap flag
+	jd->level = (JD_FASTDECODE == 2 && level >= 2) ? 2 : (JD_FASTDECODE ? 1 : 0);	/* Level 2 only if compiled in */
+	jd->tblclip = JD_TBLCLIP ? (tblclip ? 1 : 0) : 0;
 
 	jd->inbuf = seg = alloc_pool(jd, JD_SZBUF);		/* Allocate stream input buffer */
 	if (!seg) return JDR_MEM1;
 
+	iseg = ndht = 0;
+	if (tc) {
+		tc->nhit = 0;
+		if (tc->pool != pool || tc->sz_pool != sz_pool || tc->level != jd->level) {	/* Cached tables are not in this pool */
+			tc->pool = pool; tc->sz_pool = sz_pool; tc->level = jd->level; tc->nseg = 0;
+		}
+		if (tc->nseg) load_tables(jd, tc);	/* Tables of the previous frame (reused if the segments match) */
+	}
+
 	ofs = marker = 0;		/* Find SOI marker */
 	do {
 		if (jd->infunc(jd, seg, 1) != 1) return JDR_INP;	/* Err: SOI was not detected */
@@ -1049,15 +1262,16 @@ JRESULT jd_prepare (
 			if (len > JD_SZBUF) return JDR_MEM2;
 			if (jd->infunc(jd, seg, len) != len) return JDR_INP;	/* Load segment data */
 
-			rc = create_huffman_tbl(jd, seg, len);	/* Create huffman tables */
+			rc = create_tables(jd, tc, &iseg, 0xC4, seg, len);	/* Create huffman tables */
 			if (rc) return rc;
+			ndht++;
 			break;
 
 		case 0xDB:	/* DQT - Define Quaitizer Tables */
 			if (len > JD_SZBUF) return JDR_MEM2;
 			if (jd->infunc(jd, seg, len) != len) return JDR_INP;	/* Load segment data */
 
-			rc = create_qt_tbl(jd, seg, len);	/* Create de-quantizer tables */
+			rc = create_tables(jd, tc, &iseg, 0xDB, seg, len);	/* Create de-quantizer tables */
 			if (rc) return rc;
 			break;
 
@@ -1068,6 +1282,20 @@ JRESULT jd_prepare (
 			if (!jd->width || !jd->height) return JDR_FMT1;	/* Err: Invalid image size */
 			if (seg[0] != jd->ncomp) return JDR_FMT3;		/* Err: Wrong color components */
 
+			if (!ndht) {	/* Abbreviated stream without DHT (motion JPEG) */
+				rc = create_tables(jd, tc, &iseg, 0xC4, Dht_default, sizeof Dht_default);	/* Use default huffman tables (matched as an implicit segment) */
+				if (rc) return rc;
+			}
+			if (tc && iseg < tc->nseg) drop_tables(jd, tc, iseg);	/* Discard the cached tables not defined in this frame */
+			for (i = 0; i < jd->ncomp; i++) {
+				n = i ? 1 : 0;
+				if (!jd->huffbits[n][0] || !jd->huffbits[n][1]) {	/* DHT without the tables for this component */
+					rc = create_tables(jd, tc, &iseg, 0xC4, Dht_default, sizeof Dht_default);	/* Use default huffman tables */
+					if (rc) return rc;
+					break;
+				}
+			}
+
 			/* Check if all tables corresponding to each components have been loaded */
 			for (i = 0; i < jd->ncomp; i++) {
 				b = seg[2 + 2 * i];	/* Get huffman table ID */
@@ -1090,8 +1318,10 @@ JRESULT jd_prepare (
 			if (!jd->workbuf) return JDR_MEM1;			/* Err: not enough memory */
 			jd->mcubuf = alloc_pool(jd, (n + 2) * 64 * sizeof (jd_yuv_t));	/* Allocate MCU working buffer */
 			if (!jd->mcubuf) return JDR_MEM1;			/* Err: not enough memory */
+			if (tc) save_tables(jd, tc);
 
 			/* Align stream read offset to JD_SZBUF */
+			jd->hdrlen = ofs;
 			if (ofs %= JD_SZBUF) {
 				jd->dctr = jd->infunc(jd, seg + ofs, (size_t)(JD_SZBUF - ofs));
 			}
@@ -1124,42 +1354,111 @@ JRESULT jd_prepare (
 
 
 
+JRESULT jd_prepare (
+	JDEC* jd,				/* Blank decompressor object */
+	size_t (*infunc)(JDEC*, uint8_t*, size_t),	/* JPEG strem input function */
+	void* pool,				/* Working buffer for the decompression session */
+	size_t sz_pool,			/* Size of working buffer */
+	void* dev				/* I/O device identifier for the session */
+)
+{
+	return prepare(jd, infunc, pool, sz_pool, dev, 0);
+}
+
+
+/* Same as jd_prepare() but the tables created by the previous frame are reused */
+/* when the table segments are identical (the pool must not be used by others)  */
+JRESULT jd_prepare_cached (
+	JDEC* jd,				/* Blank decompressor object */
+	size_t (*infunc)(JDEC*, uint8_t*, size_t),	/* JPEG strem input function */
+	void* pool,				/* Working buffer for the decompression session */
+	size_t sz_pool,			/* Size of working buffer */
+	void* dev,				/* I/O device identifier for the session */
+	JDCACHE* tc				/* Table cache (cleared by the caller before the first use) */
+)
+{
+	JRESULT rc;
+
+
+	rc = prepare(jd, infunc, pool, sz_pool, dev, tc);
+	if (rc != JDR_OK) tc->nseg = 0;	/* Tables in the pool may be broken */
+	return rc;
+}
+
+
+
+
 /*-----------------------------------------------------------------------*/
-/* Start to decompress the JPEG picture                                  */
+/* Start to decompress the JPEG picture row by row                       */
 /*-----------------------------------------------------------------------*/
 
-JRESULT jd_decomp (
+JRESULT jd_decomp_begin (
 	JDEC* jd,								/* Initialized decompression object */
-	int (*outfunc)(JDEC*, void*, JRECT*),	/* RGB output function */
 	uint8_t scale							/* Output de-scaling factor (0 to 3) */
 )
 {
-	unsigned int x, y, mx, my;
-	uint16_t rst, rsc;
-	JRESULT rc;
-
-
 	if (scale > (JD_USE_SCALE ? 3 : 0)) return JDR_PAR;
 	jd->scale = scale;
 
-	mx = jd->msx * 8; my = jd->msy * 8;			/* Size of the MCU (pixel) */
-
 	jd->dcv[2] = jd->dcv[1] = jd->dcv[0] = 0;	/* Initialize DC values */
-	rst = rsc = 0;
-
-	rc = JDR_OK;
-	for (y = 0; y < jd->height; y += my) {		/* Vertical loop of MCUs */
-		for (x = 0; x < jd->width; x += mx) {	/* Horizontal loop of MCUs */
-			if (jd->nrst && rst++ == jd->nrst) {	/* Process restart interval if enabled */
-				rc = restart(jd, rsc++);
-				if (rc != JDR_OK) return rc;
-				rst = 1;
-			}
-			rc = mcu_load(jd);					/* Load an MCU (decompress huffman coded stream, dequantize and apply IDCT) */
-			if (rc != JDR_OK) return rc;
-			rc = mcu_output(jd, outfunc, x, y);	/* Output the MCU (YCbCr to RGB, scaling and output) */
+	jd->rst = jd->rsc = 0;
+	jd->rowy = 0;
+
+	return JDR_OK;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Decompress the next MCU row                                           */
+/*-----------------------------------------------------------------------*/
+
+JRESULT jd_decomp_row (
+	JDEC* jd,								/* Object started by jd_decomp_begin() */
+	int (*outfunc)(JDEC*, void*, JRECT*)	/* RGB output function */
+)
+{
+	unsigned int x, mx;
+	JRESULT rc;
+
+
+	if (jd->rowy >= jd->height) return JDR_PAR;	/* No more rows */
+	mx = jd->msx * 8;							/* Width of the MCU (pixel) */
+
+	for (x = 0; x < jd->width; x += mx) {	/* Horizontal loop of MCUs */
+		if (jd->nrst && jd->rst++ == jd->nrst) {	/* Process restart interval if enabled */
+			rc = restart(jd, jd->rsc++);
 			if (rc != JDR_OK) return rc;
+			jd->rst = 1;
 		}
+		rc = mcu_load(jd);					/* Load an MCU (decompress huffman coded stream, dequantize and apply IDCT) */
+		if (rc != JDR_OK) return rc;
+		rc = mcu_output(jd, outfunc, x, jd->rowy);	/* Output the MCU (YCbCr to RGB, scaling and output) */
+		if (rc != JDR_OK) return rc;
+	}
+	jd->rowy += jd->msy * 8;					/* Height of the MCU (pixel) */
+
+	return JDR_OK;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Start to decompress the JPEG picture                                  */
+/*-----------------------------------------------------------------------*/
+
+JRESULT jd_decomp (
+	JDEC* jd,								/* Initialized decompression object */
+	int (*outfunc)(JDEC*, void*, JRECT*),	/* RGB output function */
+	uint8_t scale							/* Output de-scaling factor (0 to 3) */
+)
+{
+	JRESULT rc;
+
+
+	rc = jd_decomp_begin(jd, scale);
+	while (rc == JDR_OK && jd->rowy < jd->height) {	/* Vertical loop of MCUs */
+		rc = jd_decomp_row(jd, outfunc);
 	}
 
 	return rc;
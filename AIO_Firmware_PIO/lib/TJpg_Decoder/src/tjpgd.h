@@ -87,13 +87,46 @@ struct JDEC {
 	size_t (*infunc)(JDEC*, uint8_t*, size_t);	/* Pointer to jpeg stream input function */
 	void* device;				/* Pointer to I/O device identifiler for the session */
 	uint8_t swap;       /* Added by Bodmer to control byte swapping */
+	uint8_t level;				/* Optimization level used by this session, 1 or 2 (set before jd_prepare) */
+	uint8_t tblclip;			/* Use table conversion for saturation (set before jd_prepare) */
+	size_t hdrlen;				/* Number of header bytes in front of the scan data */
+	uint16_t rowy;				/* Top of the next MCU row to be decoded by jd_decomp_row() */
+	uint16_t rst, rsc;			/* Restart interval counters kept between MCU rows */
 };
 
 
 
+/* Table cache for motion JPEG streams (tables are kept in the pool between frames) */
+#define JD_CACHE_SEG	8		/* Max number of table segments (DHT/DQT) to be cached */
+
+typedef struct {
+	void* pool;					/* Memory pool holding the cached tables */
+	size_t sz_pool;				/* Size of the memory pool */
+	uint8_t level;				/* Optimization level the tables were created for */
+	uint8_t nseg;				/* Number of cached table segments (0:empty) */
+	uint8_t nhit;				/* Number of table segments reused by the last jd_prepare_cached() */
+	uint32_t hash[JD_CACHE_SEG];	/* Fingerprint of each table segment */
+	size_t used[JD_CACHE_SEG];	/* Pool usage after the tables of each segment were created */
+	uint8_t* huffbits[2][2];	/* Table pointers of the last frame */
+	uint16_t* huffcode[2][2];
+	uint8_t* huffdata[2][2];
+	int32_t* qttbl[4];
+#if JD_FASTDECODE == 2
+	uint8_t longofs[2][2];
+	uint16_t* hufflut_ac[2];
+	uint8_t* hufflut_dc[2];
+#endif
+} JDCACHE;
+
+
+
 /* TJpgDec API functions */
 JRESULT jd_prepare (JDEC* jd, size_t (*infunc)(JDEC*,uint8_t*,size_t), void* pool, size_t sz_pool, void* dev);
+JRESULT jd_prepare_cached (JDEC* jd, size_t (*infunc)(JDEC*,uint8_t*,size_t), void* pool, size_t sz_pool, void* dev, JDCACHE* tc);
 JRESULT jd_decomp (JDEC* jd, int (*outfunc)(JDEC*,void*,JRECT*), uint8_t scale);
+/* Row by row decompression (the caller decodes one MCU row at a time until jd->rowy >= jd->height) */
+JRESULT jd_decomp_begin (JDEC* jd, uint8_t scale);
+JRESULT jd_decomp_row (JDEC* jd, int (*outfunc)(JDEC*,void*,JRECT*));
 
 
 #ifdef __cplusplus
@@ -18,13 +18,13 @@
 /  1: Enable
 */
 
-#define JD_TBLCLIP		0
+#define JD_TBLCLIP		1
 /* Use table conversion for saturation arithmetic. A bit faster, but increases 1 KB of code size.
 /  0: Disable
-/  1: Enable
+/  1: Enable (compiled in, selected per session with JDEC.tblclip)
 */
 
-#define JD_FASTDECODE	1
+#define JD_FASTDECODE	2
 /* Optimization level
 /  0: Basic optimization. Suitable for 8/16-bit MCUs.
 /     Workspace of 3100 bytes needed.
@@ -32,13 +32,19 @@
 /     Workspace of 3480 bytes needed.
 /  2: + Table conversion for huffman decoding (wants 6 << HUFF_BIT bytes of RAM).
 /     Workspace of 9644 bytes needed.
+/  With 2, each session selects level 1 or 2 with JDEC.level, so the table
+/  conversion only costs RAM where the caller gives the larger workspace.
 */
 
 // Do not change this, it is the minimum size in bytes of the workspace needed by the decoder
 #if JD_FASTDECODE == 0
  #define TJPGD_WORKSPACE_SIZE 3100
-#elif JD_FASTDECODE == 1
+#else
  #define TJPGD_WORKSPACE_SIZE 3500
-#elif JD_FASTDECODE == 2
- #define TJPGD_WORKSPACE_SIZE (3500 + 6144)
-#endif
\ No newline at end of file
+#endif
+// Workspace needed by a level 2 session
+#if JD_FASTDECODE == 2
+ #define TJPGD_WORKSPACE_SIZE_LUT (3500 + 6144)
+#else
+ #define TJPGD_WORKSPACE_SIZE_LUT TJPGD_WORKSPACE_SIZE
+#endif
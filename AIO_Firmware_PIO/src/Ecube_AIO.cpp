@@ -12,6 +12,9 @@
 
 #include "driver/lv_port_indev.h"
 #include "driver/lv_port_fs.h"
+#include "driver/lv_port_jpeg.h"
+#include "driver/lv_port_img_cache.h"
+#include "app/media_player/thumb_cache.h"
 
 #include "common.h"
 #include "sys/app_controller.h"
@@ -28,18 +31,6 @@ bool isCheckAction = false;
 ImuAction *act_info;           // 存放mpu6050返回的数据
 AppController *app_controller; // APP控制器
 
-TaskHandle_t handleTaskLvgl;
-
-void TaskLvglUpdate(void *parameter)
-{
-    // ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
-    for (;;)
-    {
-        AIO_LVGL_OPERATE_LOCK(lv_timer_handler();)
-        vTaskDelay(5);
-    }
-}
-
 TimerHandle_t xTimerAction = NULL;
 void actionCheckHandle(TimerHandle_t xTimer)
 {
@@ -108,23 +99,10 @@ void setup()
     tf.init();
 
     lv_fs_fatfs_init();
-
-    // Update display in parallel thread.
-    // BaseType_t taskLvglReturned = xTaskCreate(
-    //     TaskLvglUpdate,
-    //     "LvglThread",
-    //     8 * 1024,
-    //     nullptr,
-    //     TASK_LVGL_PRIORITY,
-    //     &handleTaskLvgl);
-    // if (taskLvglReturned != pdPASS)
-    // {
-    //     Serial.println("taskLvglReturned != pdPASS");
-    // }
-    // else
-    // {
-    //     Serial.println("taskLvglReturned == pdPASS");
-    // }
+    lv_port_jpeg_init(); // LVGL显示jpg图片
+    ThumbCache::initDecoder(); // 缩略图（".thumb"后缀）
+    lv_port_img_cache_init(); // 最后注册 图片先经过缓存
+    lv_port_img_cache_set_budget(app_controller->sys_cfg.img_cache_kb * 1024U);
 
 #if LV_USE_LOG
     lv_log_register_print_cb(my_print);
@@ -219,6 +197,9 @@ void setup()
                                 200 / portTICK_PERIOD_MS,
                                 pdTRUE, (void *)0, actionCheckHandle);
     xTimerStart(xTimerAction, 0);
+
+    // 之后由渲染任务刷新LVGL（创建失败时仍在loop()中刷新）
+    screen.startTask();
 }
 
 void loop()
@@ -243,7 +224,8 @@ void loop()
         isCheckAction = false;
         act_info = mpu.getAction();
     }
-    app_controller->main_process(act_info); // 运行当前进程
+    // 运行当前进程 APP中的LVGL操作与渲染任务互斥（APP等待时用screen.lvglDelay让出）
+    AIO_LVGL_OPERATE_LOCK(app_controller->main_process(act_info);)
     // Serial.println(ambLight.getLux() / 50.0);
     // rgb.setBrightness(ambLight.getLux() / 500.0);
 }
@@ -48,7 +48,7 @@ static int LHLXW_init(AppController *sys){
 
 static void LHLXW_process(AppController *sys,const ImuAction *action){
     while(1){
-        lv_timer_handler();
+        screen.lvglDelay(0);//让出LVGL锁 由渲染任务按帧刷新
 
         /* MPU6050数据获取 */
         if (isCheckAction){
@@ -65,18 +65,12 @@ static void LHLXW_process(AppController *sys,const ImuAction *action){
             lhlxw_run->option_num++;
             if(lhlxw_run->option_num==5)lhlxw_run->option_num = 0;
             SWITCH_OPTION(true,lhlxw_run->option_num);
-            for(uint16_t i=0;i<400;i++){
-                lv_task_handler();
-                delay(1);
-            }
+            screen.lvglDelay(400);//期间由渲染任务刷新屏幕，让操作者可以看到已执行动作
         }else if(TURN_LEFT == act_info->active){
             lhlxw_run->option_num--;
             if(lhlxw_run->option_num>5)lhlxw_run->option_num = 4;
             SWITCH_OPTION(false,lhlxw_run->option_num);
-            for(uint16_t i=0;i<400;i++){
-                lv_task_handler();
-                delay(1);
-            }
+            screen.lvglDelay(400);//期间由渲染任务刷新屏幕，让操作者可以看到已执行动作
         }else if(act_info->active == UP){
             if(lhlxw_run->option_num == 4)
                 emoji_process(lhlxw_run->LV_LHLXW_GUI_OBJ);
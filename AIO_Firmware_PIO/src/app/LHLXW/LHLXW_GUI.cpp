@@ -1,6 +1,7 @@
 #include "LHLXW_GUI.h"
 #include "LHLXW_StartAnim.h"
 #include "arduino.h"
+#include "common.h"
 
 LV_FONT_DECLARE(APP_OPTION_ico);//定义选项字符
 
@@ -137,10 +138,7 @@ void LHLXW_GUI_DeInit(void){
     lv_scr_load_anim(lhlxw_run->LV_BACKUP_OBJ, LV_SCR_LOAD_ANIM_OUT_BOTTOM, 573, 0, false);//调用系统退出函数之前，一定要等待动画结束否则会导致系统重启
 
     /* 这里加延时是为了防止动画执行完成前就调用系统退出函数或者删除动画对象导致系统出错 */
-    for(uint16_t i=0;i<573;i++){
-        lv_task_handler();
-        delay(1);
-    }
+    screen.waitAnim(1000);//让渲染任务刷新屏幕直到动画结束
     /* 如果要手动删除对象，那么一定要在对象的动画执行完了再删除，否则会有问题*/
     lv_obj_clean(lhlxw_run->LV_LHLXW_GUI_OBJ); //删除对象的所有子项
     lv_obj_del(lhlxw_run->LV_LHLXW_GUI_OBJ); //删除对象（实测会释放内存，不会造成内存泄漏）
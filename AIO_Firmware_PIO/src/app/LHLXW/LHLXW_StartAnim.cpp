@@ -1,5 +1,6 @@
 #include "LHLXW_StartAnim.h"
 #include "arduino.h"
+#include "common.h"
 
 #define LCD_W 240
 #define LCD_H 240
@@ -113,18 +114,12 @@ void startLog(lv_obj_t *ym){
     
     /* 等待动画结束 */
     /* 也可以用lv_anim_set_ready_cb函数实现 */
-    for(uint16_t i=0;i<2000;i++){
-        lv_task_handler();
-        delay(1);
-    }
+    screen.waitAnim(2000);//让渲染任务刷新屏幕直到动画结束
     /* 丝滑过度到表情菜单，同时删除旧屏幕(这里不用此函数自带的删除，等执行完后手动删除) */
     lv_scr_load_anim(ym, LV_SCR_LOAD_ANIM_OUT_BOTTOM, 573, 0, false);//上翻动画，切换到此页面
 
     /* 这里加延时是为了防止动画执行完成前就删除动画对象导致系统出错 */
-    for(uint16_t i=0;i<573;i++){
-        lv_task_handler();
-        delay(1);
-    }
+    screen.waitAnim(1000);//让渲染任务刷新屏幕直到动画结束
 
     /* 删除启动log动画所有部件 */
     lv_obj_clean(LOG_SCR);
@@ -22,10 +22,8 @@ void codeRain_process(lv_obj_t * ym){
   lv_obj_set_style_bg_color(obj,lv_color_hex(0),LV_STATE_DEFAULT);
   lv_scr_load_anim(obj, LV_SCR_LOAD_ANIM_OUT_BOTTOM, 573, 0, false);
   /* 延时999ms，防止同时退出app */
-  for(uint16_t i=0;i<573;i++){
-      lv_timer_handler();//让LVGL更新屏幕，让操作者可以看到已执行动作
-      delay(1);//
-  }
+  screen.waitAnim(1000);//让渲染任务刷新屏幕直到动画结束
+  screen.lendDrawBuf("codeRain");//此后直接操作屏幕，不需要LVGL的绘制缓冲
   matrix_effect->init(tft,codeSizeFont);
   unsigned long tempD = 0;
   while(1){
@@ -39,13 +37,11 @@ void codeRain_process(lv_obj_t * ym){
 
     /* MPU6050动作响应 */
     if (RETURN == act_info->active){
+        screen.returnDrawBuf("codeRain");//退出动画前还给LVGL
         lv_scr_load_anim(ym, LV_SCR_LOAD_ANIM_OUT_TOP, 573, 0, false);//调用系统退出函数之前，一定要等待动画结束否则会导致系统重启
         lv_obj_invalidate(lv_scr_act());//哪怕缓存没变，也让lvgl下次更新全部屏幕
         /* 延时999ms，防止同时退出app */
-        for(uint16_t i=0;i<898+500;i++){
-            lv_timer_handler();//让LVGL更新屏幕，让操作者可以看到已执行动作
-            delay(1);//
-        }
+        screen.lvglDelay(999+500);//期间由渲染任务刷新屏幕，让操作者可以看到已执行动作
         lv_obj_clean(obj);
         lv_obj_del(obj);
         delete matrix_effect;
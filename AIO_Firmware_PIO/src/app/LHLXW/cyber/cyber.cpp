@@ -148,11 +148,6 @@ void cyber_pros(lv_obj_t *ym){
         Serial.println("0:lack of memory");
         while(1);
     }  
-    cy_r->testBuf = (uint8_t *)malloc(240 * 240); //动态分配一块屏幕分辨率大小的空间
-    if(cy_r->testBuf == NULL){
-        Serial.println("1:lack of memory");
-        while(1);
-    }  
     cy_r->pic1 = (uint8_t *)malloc(40*48); //动态分配一块图片大小的内存
     if(cy_r->pic1 == NULL){
         Serial.println("-1:lack of memory");
@@ -201,10 +196,15 @@ void cyber_pros(lv_obj_t *ym){
     lv_obj_t *obj = lv_obj_create(NULL);
     lv_obj_set_style_bg_color(obj,lv_color_hex(0),LV_STATE_DEFAULT);
     lv_scr_load_anim(obj, LV_SCR_LOAD_ANIM_OUT_BOTTOM, 673, 0, false);
-    for(uint16_t i=0;i<873;i++){
-        lv_timer_handler();//让LVGL更新屏幕，让操作者可以看到已执行动作
-        delay(1);//
-    }
+    screen.waitAnim(873);//让渲染任务刷新屏幕直到动画结束
+
+    /* 此后直接操作屏幕，屏幕缓冲区使用从LVGL借来的内存 */
+    screen.lendDrawBuf("cyber");
+    cy_r->testBuf = (uint8_t *)malloc(240 * 240); //动态分配一块屏幕分辨率大小的空间
+    if(cy_r->testBuf == NULL){
+        Serial.println("1:lack of memory");
+        while(1);
+    }  
     
 //     testBuf_fill(0);
 //     lv_scr_load_anim(ym, LV_SCR_LOAD_ANIM_OUT_TOP, 599, 0, false);//调用系统退出函数之前，一定要等待动画结束否则会导致系统重启
@@ -249,19 +249,18 @@ void cyber_pros(lv_obj_t *ym){
             else delay(700);                
         } 
     }
+    free(cy_r->testBuf);//释放57600字节内存
+    cy_r->testBuf = NULL;
+    screen.returnDrawBuf("cyber");//退出动画前还给LVGL
 
     lv_scr_load_anim(ym, LV_SCR_LOAD_ANIM_OUT_TOP, 599, 0, false);//调用系统退出函数之前，一定要等待动画结束否则会导致系统重启
     lv_obj_invalidate(lv_scr_act());//哪怕缓存没变，也让lvgl下次更新全部屏幕
     /* 延时999ms，防止同时退出app */
-    for(uint16_t i=0;i<598+500;i++){
-        lv_timer_handler();//让LVGL更新屏幕，让操作者可以看到已执行动作
-        delay(1);//
-    }
+    screen.lvglDelay(598+500);//期间由渲染任务刷新屏幕，让操作者可以看到已执行动作
     lv_obj_clean(obj);
     lv_obj_del(obj);
 
     
-    free(cy_r->testBuf);//释放57600字节内存
     free(cy_r->pic2);//释放1920字节内存
     free(cy_r->pic1);//释放1920字节内存
     free(cy_r);
@@ -15,13 +15,14 @@ emoji功能依赖于media_player APP中的视频播放库
 
 SD卡存放说明(emoji相关功能):
 ./LH&LXW/emoji/videos/videox.mjpeg 存放要播放的视频（大小240x240）(x为0~99)
-./LH&LXW/emoji/images/imagex.bin   存放要播放的视频的封面（大小60x60）(x为0~99)
+./LH&LXW/emoji/images/imagex.bin   存放要播放的视频的封面（大小60x60）(x为0~99)（可选）
 ./LH&LXW/emoji/emoji_num.txt        存放要播放的视频数(00~99) 例如7个视频，写07
 
-./LH&LXW/emoji/videos/中的视频数必须等于./LH&LXW/emoji/images/中的封面数
-同时必须等于./LH&LXW/emoji/emoji_num.txt中用户输入的视频个数
+./LH&LXW/emoji/videos/中的视频数必须等于./LH&LXW/emoji/emoji_num.txt中用户输入的视频个数
 
 封面要由lvgl官网img工具工具生成，多功能上位机无法生成
+没有imagex.bin时自动使用视频第一帧的缩略图（首次进入时生成，保存在SD卡的/thumb.cache中）
+所以第3~6步可以省略
 
 所以将此功能当作视频播放器的时候，添加自定义视频的步骤如下：
 1.获取视频，用多功能上位机转为240x240的mjpeg格式（参数推荐用默认的）
@@ -60,6 +61,8 @@ static void emoji_init(void){
     emj_run->emoji_Maxnum += (dataFile.read() - '0');//总共有多少个表情（SPIFFS不会用，所以人为输入个数，即读取SD卡配置文件)
     Serial.print(emj_run->emoji_Maxnum);
     dataFile.close();//读取完毕后，关闭文件
+    g_mediaBufPool.begin("emoji enter");//切换表情时复用视频缓冲，退出时才释放
+    g_thumbCache.begin("emoji enter");//封面缩略图
     EMOJI_GUI_Init();
 }
 
@@ -68,13 +71,33 @@ static void close_player(void){
     delete emj_run->emoji_docoder;
     emj_run->emoji_file.close();
 }
-/* 开启播放 */
-static void start_player(void){
+/* 打开当前选中表情的视频文件 */
+static void open_emoji_file(void){
     char *path = (char*)malloc(38);//必须用char*类型，不能用uint8_t*
     sprintf(path,"/LH&LXW/emoji/videos/video%d.mjpeg",emj_run->emoji_var);//图标路径
     emj_run->emoji_file = tf.open(path);
+    free(path);
+}
+/* 开启播放 */
+static void start_player(void){
+    open_emoji_file();
     emj_run->emoji_docoder = new MjpegPlayDocoder(&emj_run->emoji_file, true);
-    free(path);  
+}
+/* 切换到当前选中的表情：不重建解码器，复用缓冲与DMA，只重新打开文件 */
+static void switch_player(void){
+    emj_run->emoji_file.close();
+    open_emoji_file();
+    if(!emj_run->emoji_docoder->video_switch(&emj_run->emoji_file)){
+        close_player();//切换失败（例如内存不足）时重新创建
+        start_player();
+    }
+}
+/* 当前表情从头循环播放 */
+static void loop_player(void){
+    if(!emj_run->emoji_docoder->video_rewind()){
+        close_player();
+        start_player();
+    }
 }
 void emoji_process(lv_obj_t *ym)
 {
@@ -84,9 +107,9 @@ void emoji_process(lv_obj_t *ym)
     act_info->isValid = 0;
     while(1){
         /* 表情选择时才刷新lvgl */
-        if(emj_run->emoji_mode)lv_timer_handler();
+        if(emj_run->emoji_mode)screen.lvglDelay(0);//让出LVGL锁 由渲染任务按帧刷新
         else{
-            if(emj_run->emoji_file.available()){
+            if(!emj_run->emoji_docoder->video_is_end()){
                 emj_run->emoji_docoder->video_play_screen();// 播放一帧数据
             }else{
                 /* 判断有没有超过3333ms */
@@ -95,9 +118,10 @@ void emoji_process(lv_obj_t *ym)
                     emj_run->emoji_var ++;
                     if(emj_run->emoji_var > emj_run->emoji_Maxnum)emj_run->emoji_var = 1;
                     *timCont = millis();
+                    switch_player();
+                }else{
+                    loop_player();//无缝循环，不重新打开文件
                 }
-                close_player();
-                start_player();
                 emj_run->emoji_docoder->video_play_screen();//立即播放一帧数据
             }
         }
@@ -114,12 +138,11 @@ void emoji_process(lv_obj_t *ym)
                 EMOJI_GUI_DeInit(ym);//退出APP时有LVGL动画，故要等动画结束才能调用系统退出函数，所以UI退出不能放在LHLXW_exit_callback中
                 lv_obj_invalidate(lv_scr_act());//哪怕缓存没变，也让lvgl下次更新全部屏幕
                 /* 延时999ms，防止同时退出app */
-                for(uint16_t i=0;i<898;i++){
-                    lv_timer_handler();//让LVGL更新屏幕，让操作者可以看到已执行动作
-                    delay(1);//
-                }
+                screen.lvglDelay(999);//期间由渲染任务刷新屏幕，让操作者可以看到已执行动作
                 // close_player();//此处一定是关闭播放状态的，再调用系统必崩
                 free(emj_run);//释放内存
+                g_mediaBufPool.end("emoji exit");
+                g_thumbCache.end("emoji exit");
                 return;//退出此功能
             }
             /* 表情播放时，后仰退出表情播放 */
@@ -128,10 +151,7 @@ void emoji_process(lv_obj_t *ym)
                 close_player();//关闭播放
                 lv_obj_invalidate(lv_scr_act());//哪怕缓存没变，也让lvgl下次更新全部屏幕
                 /* 延时999ms，防止同时退出emoji功能 */
-                for(uint16_t i=0;i<898;i++){
-                    lv_timer_handler();//让LVGL更新屏幕，让操作者可以看到已执行动作
-                    delay(1);//
-                }
+                screen.lvglDelay(999);//期间由渲染任务刷新屏幕，让操作者可以看到已执行动作
             }
         }else if(TURN_RIGHT == act_info->active && emj_run->mpu6050key_var != 1){
             if(emj_run->emoji_mode)
@@ -141,13 +161,10 @@ void emoji_process(lv_obj_t *ym)
                 emj_run->emoji_var ++;
                 if(emj_run->emoji_var > emj_run->emoji_Maxnum)emj_run->emoji_var = 1;
                 *timCont = millis();//重新开始计时
-                close_player();
-                start_player();
-            }
-            for(uint16_t i=0;i<388;i++){
-                if(emj_run->emoji_mode)lv_timer_handler();//
-                delay(1);//
+                switch_player();
             }
+            if(emj_run->emoji_mode)screen.lvglDelay(388);//表情选择时才刷新lvgl
+            else delay(388);//播放时不能让LVGL覆盖画面
         }else if(TURN_LEFT == act_info->active && emj_run->mpu6050key_var != 2){
             if(emj_run->emoji_mode)
                 emj_run->mpu6050key_var = 2;    
@@ -156,13 +173,10 @@ void emoji_process(lv_obj_t *ym)
                 emj_run->emoji_var --;
                 if(emj_run->emoji_var < 1)emj_run->emoji_var = emj_run->emoji_Maxnum;
                 *timCont = millis();//重新开始计时
-                close_player();
-                start_player();
-            }
-            for(uint16_t i=0;i<388;i++){
-                if(emj_run->emoji_mode)lv_timer_handler();//
-                delay(1);//
+                switch_player();
             }
+            if(emj_run->emoji_mode)screen.lvglDelay(388);//表情选择时才刷新lvgl
+            else delay(388);//播放时不能让LVGL覆盖画面
         }else if(act_info->active == UP){
             if(emj_run->emoji_mode){
                 start_player();
@@ -4,6 +4,7 @@
 #include "lvgl.h"
 #include "sys/app_controller.h"
 #include "../../media_player/docoder.h"//解码器父类
+#include "../../media_player/thumb_cache.h"//封面缩略图
 
 
 struct EMOJI_RUN{
@@ -16,6 +17,8 @@ struct EMOJI_RUN{
     lv_obj_t *EMOJI_GUI_OBJ;//EMOJI UI界面
     lv_indev_t * indev_mpu6050key;//输入设备指针
     lv_group_t *optionListGroup;//APP 选项列表 组，用来关联输入设备
+    uint16_t *thumbPixels;//一次读出的所有封面缩略图（没有imagex.bin的表情）
+    lv_img_dsc_t *thumbDsc;//每张缩略图对应的图片描述
 };
 void emoji_process(lv_obj_t *ym);
 
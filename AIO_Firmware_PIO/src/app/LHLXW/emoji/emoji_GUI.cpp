@@ -62,10 +62,48 @@ void EMOJI_GUI_Init(void){
     emj_run->optionListGroup= lv_group_create();//创建一个组
     lv_indev_set_group(emj_run->indev_mpu6050key, emj_run->optionListGroup);//输入设备与组关联
     
-    char *path = (char*)malloc(38);//必须用char*类型，不能用uint8_t*
+    char *path = (char*)malloc(48);//必须用char*类型，不能用uint8_t*
     lv_obj_t *option_obj;//按钮部件
     lv_obj_t *optionImg_obj;//图片部件  直接用图片按钮部件无法被选中
 
+    /* 没有自制封面的表情用视频第一帧的缩略图：在缓存文件中一次顺序读出，之后重绘不再读SD卡 */
+    bool *has_cover = (bool*)calloc(emj_run->emoji_Maxnum,sizeof(bool));
+    char (*thumb_path)[40] = (char(*)[40])malloc(emj_run->emoji_Maxnum*40);
+    const char **thumb_list = (const char**)malloc(emj_run->emoji_Maxnum*sizeof(char*));
+    uint8_t thumb_num = 0;
+    for(uint8_t i = 0;i<emj_run->emoji_Maxnum; i++){
+        sprintf(path,"/LH&LXW/emoji/images/image%d.bin",i+1);
+        has_cover[i] = SD.exists(path);
+        if(!has_cover[i] && thumb_path != NULL && thumb_list != NULL){
+            sprintf(thumb_path[thumb_num],"/LH&LXW/emoji/videos/video%d.mjpeg",i+1);
+            thumb_list[thumb_num] = thumb_path[thumb_num];
+            thumb_num++;
+        }
+    }
+    if(thumb_num > 0){
+        emj_run->thumbPixels = (uint16_t*)malloc(thumb_num*THUMB_PIXEL_SIZE);
+        emj_run->thumbDsc = (lv_img_dsc_t*)calloc(thumb_num,sizeof(lv_img_dsc_t));
+        if(emj_run->thumbPixels == NULL || emj_run->thumbDsc == NULL){//内存不足时按原来的方式逐张读取
+            free(emj_run->thumbPixels);
+            free(emj_run->thumbDsc);
+            emj_run->thumbPixels = NULL;
+            emj_run->thumbDsc = NULL;
+        }else{
+            uint32_t ok_num = g_thumbCache.get_batch(thumb_list,thumb_num,emj_run->thumbPixels);
+            Serial.printf("emoji covers: %u/%u thumbnails preloaded\n",ok_num,thumb_num);
+            for(uint8_t k = 0;k<thumb_num; k++){
+                emj_run->thumbDsc[k].header.cf = LV_IMG_CF_TRUE_COLOR;
+                emj_run->thumbDsc[k].header.w = THUMB_SIZE;
+                emj_run->thumbDsc[k].header.h = THUMB_SIZE;
+                emj_run->thumbDsc[k].data_size = THUMB_PIXEL_SIZE;
+                emj_run->thumbDsc[k].data = (const uint8_t*)(emj_run->thumbPixels + k*THUMB_SIZE*THUMB_SIZE);
+            }
+        }
+    }
+    free(thumb_path);
+    free(thumb_list);
+    thumb_num = 0;
+
     for(uint8_t i = 0;i<emj_run->emoji_Maxnum; i++){
         option_obj = lv_btn_create(emj_run->EMOJI_GUI_OBJ);//基于空页面创建按钮部件
         lv_obj_set_size(option_obj,60,60);//设置大小
@@ -77,16 +115,21 @@ void EMOJI_GUI_Init(void){
 
         optionImg_obj = lv_img_create(option_obj);//基于按钮部件创建图片部件
         lv_obj_align(optionImg_obj,LV_ALIGN_CENTER,0,-1);//在按钮部件中心位置往上便宜1
-        sprintf(path,"S:/LH&LXW/emoji/images/image%d.bin",i+1);//图标路径
-        lv_img_set_src(optionImg_obj,path);//设置图片源
+        if(has_cover[i]){
+            sprintf(path,"S:/LH&LXW/emoji/images/image%d.bin",i+1);//自制的封面优先
+            lv_img_set_src(optionImg_obj,path);//设置图片源
+        }else if(emj_run->thumbDsc != NULL){
+            lv_img_set_src(optionImg_obj,&emj_run->thumbDsc[thumb_num++]);//已读出的缩略图
+        }else{
+            sprintf(path,"S:/LH&LXW/emoji/videos/video%d.mjpeg" THUMB_SRC_SUFFIX,i+1);//没有封面时用视频第一帧的缩略图
+            lv_img_set_src(optionImg_obj,path);//设置图片源
+        }
     }
+    free(has_cover);
     lv_group_set_focus_cb(emj_run->optionListGroup,(lv_group_focus_cb_t)focus_alter_cb);
     lv_scr_load_anim(emj_run->EMOJI_GUI_OBJ, LV_SCR_LOAD_ANIM_OUT_BOTTOM, 580, 0, false);//调用系统退出函数之前，一定要等待动画结束否则会导致系统重启
     /* 这里加延时是为了防止动画执行完成前就调用系统退出函数或者删除动画对象导致系统出错 */
-    for(uint16_t i=0;i<780;i++){
-        lv_task_handler();
-        delay(1);
-    }
+    screen.waitAnim(780);//让渲染任务刷新屏幕直到动画结束
     free(path);
 }
 
@@ -98,11 +141,12 @@ void EMOJI_GUI_DeInit(lv_obj_t *ym){
     lv_scr_load_anim(ym, LV_SCR_LOAD_ANIM_OUT_TOP, 580, 0, false);//调用系统退出函数之前，一定要等待动画结束否则会导致系统重启
 
     /* 这里加延时是为了防止动画执行完成前就调用系统退出函数或者删除动画对象导致系统出错 */
-    for(uint16_t i=0;i<780;i++){
-        lv_task_handler();
-        delay(1);
-    }
+    screen.waitAnim(780);//让渲染任务刷新屏幕直到动画结束
     /* 如果要手动删除对象，那么一定要在对象的动画执行完了再删除，否则会有问题*/
     lv_obj_clean(emj_run->EMOJI_GUI_OBJ); //删除对象的所有子项
     lv_obj_del(emj_run->EMOJI_GUI_OBJ); //删除对象（实测会释放内存，不会造成内存泄漏）
+    free(emj_run->thumbPixels);//图片部件删除后才能释放缩略图
+    free(emj_run->thumbDsc);
+    emj_run->thumbPixels = NULL;
+    emj_run->thumbDsc = NULL;
 }
@@ -303,7 +303,7 @@ static void anniversary_process(AppController *sys,
     //              APP_MESSAGE_WIFI_CONN, (void *)run_data->val1, NULL);
 
     // 程序需要时可以适当加延时
-    delay(300);
+    screen.lvglDelay(300);
 }
 
 static void anniversary_background_task(AppController *sys,
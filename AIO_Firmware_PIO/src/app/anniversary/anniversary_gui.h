@@ -8,10 +8,6 @@ extern "C"
 
 #include "time.h"
 #include "lvgl.h"
-#define ANIEND                      \
-    while (lv_anim_count_running()) \
-        lv_task_handler(); //等待动画完成
-
     void anniversary_gui_init(void);
     void display_anniversary(const char *file_name, lv_scr_load_anim_t anim_type, struct tm *target_date, int anniversary_day_count, const char *event_name);
     void anniversary_gui_display_date(struct tm* target, int anniversary_day_count, const char *event_name);
@@ -7,10 +7,6 @@ extern "C"
 #endif
 
 #include "lvgl.h"
-#define ANIEND                      \
-    while (lv_anim_count_running()) \
-        lv_task_handler(); //等待动画完成
-
     void example_gui_init(void);
     void display_example(const char *file_name, lv_scr_load_anim_t anim_type);
     void example_gui_del(void);
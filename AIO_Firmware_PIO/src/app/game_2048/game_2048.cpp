@@ -19,18 +19,6 @@ void taskOne(void *parameter)
     vTaskDelete(NULL);
 }
 
-void taskTwo(void *parameter)
-{
-    while (1)
-    {
-        // LVGL任务主函数
-        AIO_LVGL_OPERATE_LOCK(lv_task_handler();)
-        vTaskDelay(5 / portTICK_PERIOD_MS);
-    }
-    Serial.println("Ending lv_task_handler");
-    vTaskDelete(NULL);
-}
-
 GAME2048 game;
 
 struct Game2048AppRunData
@@ -41,12 +29,39 @@ struct Game2048AppRunData
     int *moveRecord;
     BaseType_t xReturned_task_one = pdFALSE;
     TaskHandle_t xHandle_task_one = NULL;
-    BaseType_t xReturned_task_two = pdFALSE;
-    TaskHandle_t xHandle_task_two = NULL;
 };
 
 static Game2048AppRunData *run_data = NULL;
 
+// 以下UI操作投递给LVGL渲染任务执行
+static void ui_show_board(void *param)
+{
+    showBoard(run_data->pBoard);
+}
+
+static void ui_born(void *param)
+{
+    born((int)(intptr_t)param);
+}
+
+static void ui_show_anim(void *param)
+{
+    showAnim(run_data->moveRecord, (int)(intptr_t)param);
+}
+
+static void ui_show_new_born(void *param)
+{
+    showNewBorn((int)(intptr_t)param, run_data->pBoard);
+}
+
+static void game_2048_move_ui(int direction)
+{
+    // 移动动画结束后再出生新的棋子
+    screen.post(ui_show_anim, (void *)(intptr_t)direction);
+    screen.lvglDelay(700);
+    screen.post(ui_show_new_born, (void *)(intptr_t)game.addRandom());
+}
+
 static int game_2048_init(AppController *sys)
 {
     // 初始化运行时的参数
@@ -67,23 +82,15 @@ static int game_2048_init(AppController *sys)
     //     1,                            /*任务的优先级*/
     //     &run_data->xHandle_task_one); /*任务句柄*/
 
-    run_data->xReturned_task_two = xTaskCreate(
-        taskTwo,                      /*任务函数*/
-        "TaskTwo",                    /*带任务名称的字符串*/
-        8 * 1024,                     /*堆栈大小，单位为字节*/
-        NULL,                         /*作为任务输入传递的参数*/
-        1,                            /*任务的优先级*/
-        &run_data->xHandle_task_two); /*任务句柄*/
-
     // 刷新棋盘显示
     int new1 = game.addRandom();
     int new2 = game.addRandom();
-    AIO_LVGL_OPERATE_LOCK(showBoard(run_data->pBoard);)
+    screen.post(ui_show_board);
     // 棋子出生动画
-    AIO_LVGL_OPERATE_LOCK(born(new1);)
-    AIO_LVGL_OPERATE_LOCK(born(new2);)
+    screen.post(ui_born, (void *)(intptr_t)new1);
+    screen.post(ui_born, (void *)(intptr_t)new2);
     // 防止进入游戏时，误触发了向上
-    vTaskDelay(1000 / portTICK_PERIOD_MS);
+    screen.lvglDelay(1000);
     return 0;
 }
 
@@ -102,9 +109,7 @@ static void game_2048_process(AppController *sys,
         game.moveRight();
         if (game.comparePre() == 0)
         {
-            AIO_LVGL_OPERATE_LOCK(showAnim(run_data->moveRecord, 4);)
-            delay(700);
-            AIO_LVGL_OPERATE_LOCK(showNewBorn(game.addRandom(), run_data->pBoard);)
+            game_2048_move_ui(4);
         }
     }
     else if (TURN_LEFT == act_info->active)
@@ -112,9 +117,7 @@ static void game_2048_process(AppController *sys,
         game.moveLeft();
         if (game.comparePre() == 0)
         {
-            AIO_LVGL_OPERATE_LOCK(showAnim(run_data->moveRecord, 3);)
-            delay(700);
-            AIO_LVGL_OPERATE_LOCK(showNewBorn(game.addRandom(), run_data->pBoard);)
+            game_2048_move_ui(3);
         }
     }
     else if (UP == act_info->active)
@@ -122,9 +125,7 @@ static void game_2048_process(AppController *sys,
         game.moveUp();
         if (game.comparePre() == 0)
         {
-            AIO_LVGL_OPERATE_LOCK(showAnim(run_data->moveRecord, 1);)
-            delay(700);
-            AIO_LVGL_OPERATE_LOCK(showNewBorn(game.addRandom(), run_data->pBoard);)
+            game_2048_move_ui(1);
         }
     }
     else if (DOWN == act_info->active)
@@ -132,9 +133,7 @@ static void game_2048_process(AppController *sys,
         game.moveDown();
         if (game.comparePre() == 0)
         {
-            AIO_LVGL_OPERATE_LOCK(showAnim(run_data->moveRecord, 2);)
-            delay(700);
-            AIO_LVGL_OPERATE_LOCK(showNewBorn(game.addRandom(), run_data->pBoard);)
+            game_2048_move_ui(2);
         }
     }
 
@@ -150,7 +149,7 @@ static void game_2048_process(AppController *sys,
     }
 
     // 程序需要时可以适当加延时
-    delay(300);
+    screen.lvglDelay(300);
 }
 
 static void game_2048_background_task(AppController *sys,
@@ -167,12 +166,6 @@ static int game_2048_exit_callback(void *param)
     {
         vTaskDelete(run_data->xHandle_task_one);
     }
-    if (run_data->xReturned_task_two == pdPASS)
-    {
-        vTaskDelete(run_data->xHandle_task_two);
-    }
-
-    xSemaphoreGive(lvgl_mutex);
 
     game_2048_gui_del();
 
@@ -317,7 +317,7 @@ static void heartbeat_process(AppController *sys,
     display_heartbeat("heartbeat", anim_type);
     heartbeat_set_send_recv_cnt_label(run_data->send_cnt, run_data->recv_cnt);
     display_heartbeat_img();
-    delay(30);
+    screen.lvglDelay(30);
 }
 
 static void heartbeat_background_task(AppController *sys,
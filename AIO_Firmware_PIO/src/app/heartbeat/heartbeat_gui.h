@@ -12,10 +12,6 @@ enum S_R_TYPE{
     RECV,
     HEART,
 };
-#define ANIEND                      \
-    while (lv_anim_count_running()) \
-        lv_task_handler(); //等待动画完成
-
     void heartbeat_gui_init(void);
     void display_heartbeat(const char *file_name, lv_scr_load_anim_t anim_type);
     void heartbeat_gui_del(void);
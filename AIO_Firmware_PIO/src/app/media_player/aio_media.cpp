@@ -0,0 +1,29 @@
+#include "aio_media.h"
+#include "mjpeg_index.h"
+#include "common.h"
+
+bool aio_media_read_head(File *file, AioMediaHead *head)
+{
+    memset(head, 0, sizeof(AioMediaHead));
+    file->seek(0);
+    if (sizeof(AioMediaHead) != file->read((uint8_t *)head, sizeof(AioMediaHead)) ||
+        AIO_MEDIA_MAGIC != head->magic || AIO_MEDIA_VERSION != head->version ||
+        head->head_size < sizeof(AioMediaHead))
+    {
+        Serial.println(F("AIO media head invalid"));
+        return false;
+    }
+    if (0 == head->width || 0 == head->height ||
+        head->width > tft->width() || head->height > tft->height())
+    {
+        Serial.printf("AIO media size %ux%u not supported\n", head->width, head->height);
+        return false;
+    }
+    if (head->table_offset + head->frame_num * sizeof(MjpegFrameEntry) > file->size() ||
+        head->data_offset > file->size())
+    {
+        Serial.println(F("AIO media frame table invalid"));
+        return false;
+    }
+    return true;
+}
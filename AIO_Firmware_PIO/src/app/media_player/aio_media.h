@@ -0,0 +1,37 @@
+#ifndef AIO_MEDIA_H
+#define AIO_MEDIA_H
+
+#include <SD.h>
+
+// 自描述的视频容器（.aio 由 tools/aio_packer.py 生成）
+// 文件结构：AioMediaHead + frame_num 个 MjpegFrameEntry（帧表）+ 帧数据
+// 旧的 .mjpeg/.rgb 裸数据文件仍按原方式播放
+#define AIO_MEDIA_MAGIC 0x564F4941 // "AIOV"
+#define AIO_MEDIA_VERSION 1
+
+enum AIO_MEDIA_CODEC
+{
+    AIO_CODEC_MJPEG = 1,  // 每帧为一张完整的jpeg
+    AIO_CODEC_RGB565 = 2, // 每帧为 width*height 个RGB565像素（高字节在前）
+};
+
+struct AioMediaHead
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t head_size; // 头的大小（之后的版本可以追加字段）
+    uint16_t width;
+    uint16_t height;
+    uint8_t fps;   // 视频帧率（0表示未知）
+    uint8_t codec; // AIO_MEDIA_CODEC
+    uint16_t reserved;
+    uint32_t frame_num;      // 总帧数
+    uint32_t max_frame_size; // 最大的一帧的大小
+    uint32_t table_offset;   // 帧表在文件中的位置
+    uint32_t data_offset;    // 第一帧在文件中的位置
+};
+
+// 读取并校验文件头（文件指针会移动到头之后）
+bool aio_media_read_head(File *file, AioMediaHead *head);
+
+#endif
@@ -2,6 +2,11 @@
 #define PLAYER_H
 
 #include <SD.h>
+#include "mjpeg_index.h"
+#include "play_clock.h"
+#include "aio_media.h"
+#include "media_buffer_pool.h"
+#include <AnimatedGIF.h>
 
 class PlayDocoderBase
 {
@@ -10,8 +15,18 @@ public:
     virtual bool video_start() { return true; };
     virtual bool video_play_screen() { return true; };
     virtual bool video_end() { return true; };
+    virtual bool video_is_end() { return false; }; // 当前视频是否已经播放完毕
+    virtual bool video_seek(uint32_t frame) { return false; }; // 跳转到指定帧（需要帧索引）
+    virtual uint32_t video_get_frame() { return 0; };           // 最近显示的帧号
+    virtual void video_set_fps(uint8_t fps){};                  // 播放帧率 超前时等待 落后时丢帧（0不控制）
+    virtual void video_set_low_power(bool isLowPower){};        // 低功耗模式（降低分辨率解码 输出时放大）
+    virtual bool video_rewind() { return false; };              // 回到第一帧循环播放（保留缓冲与文件）
+    // 切换到另一个已打开的视频文件（复用缓冲与解码对象 file需在播放期间一直有效）
+    virtual bool video_switch(File *file, const AioMediaHead *head = NULL) { return false; };
 };
 
+#define RGB_STRIP_HEIGHT 60 // DMA模式下每次读取并发送的行数（可改为20/30/40/80对比每帧耗时）
+
 class RgbPlayDocoder : public PlayDocoderBase
 {
 private:
@@ -19,13 +34,203 @@ private:
     bool m_isUseDMA;
     uint8_t *m_displayBuf;
     uint8_t *m_displayBufWithDma[2];
+    uint32_t m_bufSize;     // 已分配的每个缓冲的大小（切换视频时够用则复用）
+    uint16_t m_width;       // 视频宽高（旧的.rgb文件固定为240*240）
+    uint16_t m_height;
+    uint16_t m_offsetX;     // 视频居中显示的偏移
+    uint16_t m_offsetY;
+    uint32_t m_frameSize;   // 一帧的大小
+    uint32_t m_dataOffset;  // 第一帧在文件中的位置
+    uint8_t m_fileFps;      // 文件中记录的帧率（0表示未知）
+    uint8_t m_targetFps;    // 设置的播放帧率（0表示按文件中记录的帧率）
+    uint16_t m_stripSetting; // 设置的每条行数
+    uint16_t m_stripHeight; // DMA模式下每条的行数（不超过视频高度）
+    bool m_dmaBufferSel;    // 下一条使用的缓冲
+    bool m_isDmaBusy;       // 已发起的DMA尚未确认发送完毕
+    PlayClock m_clock;      // 播放时钟
+    uint32_t m_frameNo;     // 下一帧的帧号
+    bool m_isLastSkip;      // 上一帧因落后而跳过（不连续跳过两帧）
+
+    // 耗时统计
+    uint32_t m_frameCount;
+    uint32_t m_frameMicros; // 每帧的总耗时
+    uint32_t m_readMicros;  // 读SD卡的耗时
+    uint32_t m_waitMicros;  // 等待上一条DMA发送完毕的耗时
 
 public:
-    RgbPlayDocoder(File *file, bool isUseDMA = false);
+    RgbPlayDocoder(File *file, bool isUseDMA = false, uint16_t stripHeight = RGB_STRIP_HEIGHT,
+                   const AioMediaHead *head = NULL);
     virtual ~RgbPlayDocoder();
     virtual bool video_start();
     virtual bool video_play_screen();
     virtual bool video_end();
+    virtual bool video_is_end();
+    virtual void video_set_fps(uint8_t fps);
+    virtual bool video_rewind();
+    virtual bool video_switch(File *file, const AioMediaHead *head = NULL);
+
+private:
+    void set_media(File *file, const AioMediaHead *head);
+    bool alloc_buf();
+    void free_buf();
+    void dma_fence();
+    void time_statistics();
+};
+
+// 分块差分的RGB565视频（.trgb 由 tools/rgb_tile_encoder.py 生成）
+// 文件结构：TileVideoHead + frame_num 个帧
+// 帧结构：TileFrameHead + run_num 个变化块段（TileRunHead + RLE编码的像素）
+// 每个块段是同一行中连续变化的若干个块 像素按块段矩形逐行排列
+// RLE：控制字节最高位为1时 下一个像素重复 (c&0x7F)+1 次 否则后面跟 c+1 个原样像素
+#define TILE_VIDEO_MAGIC 0x42475254 // "TRGB"
+#define TILE_VIDEO_VERSION 1
+#define TILE_FRAME_KEY 0x01 // 关键帧（包含所有的块）
+
+struct TileVideoHead
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t width;     // 视频宽（块大小的整数倍）
+    uint16_t height;    // 视频高（块大小的整数倍）
+    uint8_t tile_size;  // 块的边长（像素）
+    uint8_t fps;        // 视频原始帧率
+    uint32_t frame_num; // 总帧数
+};
+
+struct TileFrameHead
+{
+    uint32_t size;    // 帧头之后的数据大小
+    uint16_t run_num; // 变化块段的个数
+    uint8_t flags;    // TILE_FRAME_KEY 等
+    uint8_t reserved;
+};
+
+struct TileRunHead
+{
+    uint8_t x;     // 起始块的列号
+    uint8_t y;     // 块的行号
+    uint8_t count; // 连续的块数
+};
+
+class TileRgbPlayDocoder : public PlayDocoderBase
+{
+private:
+    File *m_pFile;
+    TileVideoHead m_head;
+    uint16_t m_offsetX; // 视频居中显示的偏移
+    uint16_t m_offsetY;
+    uint8_t *m_readBuf; // SD卡读取缓冲
+    uint32_t m_readPos;
+    uint32_t m_readLen;
+    uint16_t *m_runBufWithDma[2]; // 块段解码缓冲（交替使用 解码一段的同时DMA发送另一段）
+    uint32_t m_runBufSize;        // 每个块段缓冲的大小（切换视频时够用则复用）
+    bool m_runBufSel;
+    bool m_isEnd;
+    uint8_t m_targetFps; // 设置的播放帧率（0表示按视频自身的帧率）
+    PlayClock m_clock;  // 播放时钟
+    uint32_t m_frameNo; // 下一帧的帧号
+
+    // 帧率统计
+    uint32_t m_frameCount;
+    uint32_t m_tileCount; // 统计周期内刷新的块数
+    unsigned long m_fpsStartMillis;
+
+public:
+    TileRgbPlayDocoder(File *file);
+    virtual ~TileRgbPlayDocoder();
+    virtual bool video_start();
+    virtual bool video_play_screen();
+    virtual bool video_end();
+    virtual bool video_is_end();
+    virtual uint32_t video_get_frame();
+    virtual void video_set_fps(uint8_t fps);
+    virtual bool video_rewind();
+    virtual bool video_switch(File *file, const AioMediaHead *head = NULL);
+
+private:
+    void free_run_buf();
+    bool read_bytes(uint8_t *dst, uint32_t len);
+    bool decode_run(const TileRunHead *run, uint16_t *dst);
+    void fps_statistics();
+};
+
+// GIF动画（AnimatedGIF边读SD卡边解码 每帧只推送该帧的矩形区域）
+class GifPlayDocoder : public PlayDocoderBase
+{
+private:
+    File *m_pFile;
+    AnimatedGIF *m_gif;  // 解码器对象较大（约20KB） 从缓冲池分配
+    bool m_isEnd;
+    bool m_tftSwapStatus; // 调色板已是屏幕的字节序 播放时关闭TFT的字节交换 退出时还原
+    int16_t m_offsetX;    // 画布居中显示的偏移（画布比屏幕大时为负数）
+    int16_t m_offsetY;
+    uint16_t m_canvasWidth;
+    uint16_t m_canvasHeight;
+    // 行缓冲：帧矩形中连续的若干行拼成一条后DMA发送（两条交替使用）
+    uint16_t *m_lineBufWithDma[2];
+    uint16_t m_lineBufWidth; // 行缓冲的宽度（切换文件时够用则复用）
+    bool m_lineBufSel;
+    int16_t m_stripX;     // 当前条带的屏幕坐标
+    int16_t m_stripY;
+    uint16_t m_stripW;
+    uint16_t m_stripRows; // 已拼接的行数（0表示条带为空）
+    uint16_t m_stripMaxRows;
+    // 画面缓存：屏幕上可见的画布部分的当前画面 透明像素从这里取上一帧的颜色
+    // 分配失败时为NULL（整屏的画布需要115KB） 带透明的行按不透明段逐段推送
+    uint16_t *m_screenBuf;
+    uint32_t m_screenBufSize; // 已分配的大小（切换文件时够用则复用）
+    int16_t m_screenBufX;     // 画面缓存左上角的屏幕坐标
+    int16_t m_screenBufY;
+    uint16_t m_screenBufW;
+    uint8_t m_fps;              // 非0时按固定帧率播放 0按文件中每帧的延时
+    unsigned long m_nextMillis; // 下一帧的显示时间
+    unsigned long m_startMillis; // 开始播放的时间（短动画循环播放）
+    uint32_t m_frameNo;
+
+    // 帧率统计
+    uint32_t m_frameCount;
+    uint32_t m_decodeMicros; // 解码并推屏的累计耗时
+    uint32_t m_pixelCount;   // 推送的像素数
+    uint32_t m_pushCount;    // 发起的DMA传输次数
+    unsigned long m_fpsStartMillis;
+
+    static File *s_openFile; // AnimatedGIF打开文件时使用的已打开文件
+
+public:
+    GifPlayDocoder(File *file);
+    virtual ~GifPlayDocoder();
+    virtual bool video_start();
+    virtual bool video_play_screen();
+    virtual bool video_end();
+    virtual bool video_is_end();
+    virtual void video_set_fps(uint8_t fps);
+    virtual bool video_rewind();
+    virtual bool video_switch(File *file, const AioMediaHead *head = NULL);
+
+private:
+    void free_line_buf();
+    void free_screen_buf();
+    static void *gif_open(const char *name, int32_t *size);
+    static void gif_close(void *handle);
+    static int32_t gif_read(GIFFILE *pFile, uint8_t *buf, int32_t len);
+    static int32_t gif_seek(GIFFILE *pFile, int32_t pos);
+    static void gif_draw(GIFDRAW *pDraw);
+    void draw_line(GIFDRAW *pDraw);
+    void push_runs(int16_t x, int16_t y, const uint8_t *src, uint16_t w,
+                   const uint16_t *palette, uint8_t transparent);
+    void strip_flush();
+    void fps_statistics();
+};
+
+#define MJPEG_PIPE_FRAME_NUM 3 // 流水线模式下最多排队等待解码的帧数
+
+// jpeg帧在环形缓冲中的位置（位置为累计写入的字节数 对缓冲大小取模即为下标）
+struct MjpegFrameSpan
+{
+    uint32_t start;    // 帧的起始位置
+    uint32_t size;     // 帧的大小
+    uint32_t frame_no; // 帧号
+    bool is_decode;    // false 表示只需释放这段空间（被丢弃的超大帧）
 };
 
 class MjpegPlayDocoder : public PlayDocoderBase
@@ -33,22 +238,120 @@ class MjpegPlayDocoder : public PlayDocoderBase
 public:
     File *m_pFile;
     static bool m_isUseDMA; // 是否使用DMA
-    uint8_t *m_displayBuf;  // 显示的
-    int32_t m_bufSaveTail;  // 指向 m_displayBuf 中所保存的最后一个数据所在下标
-    uint8_t *m_jpegBuf;     // 用来给 jpeg 图片做缓冲，将此提交给jpeg解码器解码
     bool m_tftSwapStatus;   // 由于jpeg图片解码后需要互换高低位才可以使用tft_espi进行显示
     // 由此保存环境当前的高低位置换，以便退出视频播放的时候还原回去。
     static uint8_t *m_displayBufWithDma[2];
     static bool m_dmaBufferSel;
+    uint32_t m_dmaBufSize; // 每个DMA缓冲的大小（切换视频时够用则复用）
+    // 条带DMA：一行MCU先拼接到条带缓冲中 整行一次发送
+    static uint16_t m_stripX;      // 条带的起始坐标
+    static uint16_t m_stripY;
+    static uint16_t m_stripW;      // 已拼接的宽度（0表示条带为空）
+    static uint16_t m_stripH;
+    static uint16_t m_stripStride; // 条带缓冲每行的像素数
+    static uint16_t m_stripMaxH;   // 条带缓冲的行数
+    static uint32_t m_pushCount;   // 发起的DMA传输次数（统计用）
+    // 像素放大：解码输出的坐标左移 m_zoomShift 后加上偏移即为屏幕坐标
+    static uint8_t m_zoomShift;    // 1: 每个像素放大为2*2
+    static int16_t m_outX;         // 视频在屏幕上的偏移
+    static int16_t m_outY;
+
+    // 视频信息（.aio容器从文件头获取 旧的.mjpeg文件固定为240*240）
+    bool m_isContainer;
+    AioMediaHead m_mediaHead;
+    uint16_t m_width;
+    uint16_t m_height;
+    uint16_t m_offsetX; // 视频居中显示的偏移
+    uint16_t m_offsetY;
+    uint8_t m_fileFps;  // 文件中记录的帧率（0表示未知）
+    uint8_t m_targetFps; // 设置的播放帧率（0表示按文件中记录的帧率）
+    uint8_t *m_jpgWorkspace; // 解码器的工作区（优化级别2需要较大的工作区）
+    bool m_isSmall;          // 视频不超过屏幕的一半（例如120*120） 始终放大两倍显示
+    volatile bool m_isLowPower; // 低功耗模式 大视频以1/2分辨率解码后放大显示（在帧之间生效）
+    uint8_t m_jpgScale;         // 当前的解码缩小倍数（1或2）
+
+    // 环形缓冲 帧在其中切分后直接交给解码器（不再拷贝）
+    uint8_t *m_ringBuf;
+    uint32_t m_ringSize;          // 环形缓冲大小（2的幂 有帧索引时按最大帧分配）
+    uint32_t m_ringMask;
+    uint32_t m_maxFrameSize;      // 可播放的最大帧
+    volatile uint32_t m_ringHead; // 写入位置
+    volatile uint32_t m_ringTail; // 释放位置（之前的数据已解码完毕 可被覆盖）
+    uint32_t m_scanPos;           // 下一个待查找结束标志的位置
+    uint32_t m_frameStart;        // 当前帧的起始位置
+    bool m_isOversize;            // 当前帧超过 m_maxFrameSize 正在丢弃
+    uint32_t m_oversizeStart;     // 被丢弃帧的起始位置（用于生成索引）
+
+    // 流水线模式（读卡任务与解码任务分别运行在两个核上）
+    bool m_isPipeline;                // 是否使用双核流水线播放
+    volatile bool m_pipeStop;         // 通知读卡与解码任务退出
+    volatile bool m_pipeEnd;          // 文件已读完且所有帧已经解码完毕
+    QueueHandle_t m_frameQueue;       // 已切分好等待解码的帧
+    SemaphoreHandle_t m_spaceSem;     // 解码任务释放环形缓冲空间时释放
+    SemaphoreHandle_t m_frameDoneSem; // 每解码完一帧释放一次
+    SemaphoreHandle_t m_taskExitSem;  // 任务退出时释放
+    TaskHandle_t m_readTask;
+    TaskHandle_t m_decodeTask;
+
+    // 帧索引（没有索引时顺序扫描0xFFD9 并在首次完整播放时生成索引）
+    MjpegIndex m_index;
+    uint32_t m_readFrame;             // 下一个要读取的帧号
+    volatile uint32_t m_showFrame;    // 最近显示的帧号
+    volatile int32_t m_seekFrame;     // 跳转请求（-1表示没有请求）
+    PlayClock m_clock;                // 播放时钟（按帧率控制每帧的显示时间）
+    bool m_isLastSkip;                // 上一帧因落后而跳过解码（不连续跳过两帧）
+    uint32_t m_dropCount;             // 累计丢弃的帧数
+
+    // 帧率统计
+    uint32_t m_frameCount;
+    unsigned long m_fpsStartMillis;
+    uint32_t m_scanMicros; // 查找结束标志的累计耗时
+    uint32_t m_readBytes;  // 从SD卡读取的累计字节数
+    uint32_t m_drawMicros; // 解码并推屏的累计耗时
+    uint32_t m_headerMicros; // 解析jpeg头（建表）的累计耗时
+    uint32_t m_headerBytes;  // jpeg头（扫描数据之前）的累计字节数
+    uint32_t m_tableSegs;    // 累计的表段（DHT/DQT）数
+    uint32_t m_tableHits;    // 其中复用上一帧的表段数
 
 public:
-    MjpegPlayDocoder(File *file, bool isUseDMA = false);
+    MjpegPlayDocoder(File *file, bool isUseDMA = false, bool isPipeline = false,
+                     const AioMediaHead *head = NULL);
     virtual ~MjpegPlayDocoder();
-    uint32_t readJpegFromFile(File *file);
     bool static tft_output(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap);
+    static void strip_flush();
     virtual bool video_start();
     virtual bool video_play_screen();
     virtual bool video_end();
+    virtual bool video_is_end();
+    virtual bool video_seek(uint32_t frame);
+    virtual uint32_t video_get_frame();
+    virtual void video_set_fps(uint8_t fps);
+    virtual void video_set_low_power(bool isLowPower);
+    virtual bool video_rewind();
+    virtual bool video_switch(File *file, const AioMediaHead *head = NULL);
+
+private:
+    void set_media(File *file, const AioMediaHead *head);
+    bool open_stream();
+    void reset_play();
+    bool alloc_dma_buf();
+    void free_dma_buf();
+    static void push_block(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap);
+    static void zoom_copy(uint16_t *dst, uint16_t stride, const uint16_t *src, uint16_t w, uint16_t h);
+    void update_scale();
+    bool read_frame(MjpegFrameSpan *span);
+    bool split_frame(MjpegFrameSpan *span);
+    bool find_eoi(uint32_t *eoi);
+    uint32_t ring_fill(uint32_t len);
+    bool ring_wait_space(uint32_t len);
+    bool present_frame(const MjpegFrameSpan *span);
+    void draw_frame(const MjpegFrameSpan *span);
+    void release_frame(const MjpegFrameSpan *span);
+    bool pipeline_start();
+    void pipeline_end();
+    void fps_statistics();
+    static void read_task(void *parameter);
+    static void decode_task(void *parameter);
 };
 
 #endif
\ No newline at end of file
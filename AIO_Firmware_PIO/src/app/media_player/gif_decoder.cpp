@@ -0,0 +1,489 @@
+#include "docoder.h"
+#include "common.h"
+#include <new>
+
+#define GIF_STRIP_ROWS 8              // 每条拼接的最大行数（两条交替DMA发送）
+#define GIF_MIN_DELAY_MS 20           // 帧延时小于此值时按100ms播放（与浏览器相同）
+#define GIF_DEFAULT_DELAY_MS 100
+#define GIF_MAX_LATE_MS 500           // 落后超过此时间则重新对齐时间（避免一直追帧）
+#define GIF_WAIT_SLICE_MS 20          // 每次最多等待的时间（长延时的帧期间仍然响应操作）
+#define GIF_MIN_PLAY_MILLIS 10000UL   // 短动画循环播放至少这么久后再切换
+#define GIF_FPS_REPORT_FRAMES 100     // 每播放多少帧打印一次帧率
+
+File *GifPlayDocoder::s_openFile = NULL;
+
+GifPlayDocoder::GifPlayDocoder(File *file)
+{
+    m_pFile = file;
+    m_gif = NULL;
+    m_isEnd = false;
+    m_offsetX = 0;
+    m_offsetY = 0;
+    m_canvasWidth = 0;
+    m_canvasHeight = 0;
+    m_lineBufWithDma[0] = NULL;
+    m_lineBufWithDma[1] = NULL;
+    m_lineBufWidth = 0;
+    m_lineBufSel = false;
+    m_stripX = 0;
+    m_stripY = 0;
+    m_stripW = 0;
+    m_stripRows = 0;
+    m_stripMaxRows = GIF_STRIP_ROWS;
+    m_screenBuf = NULL;
+    m_screenBufSize = 0;
+    m_screenBufX = 0;
+    m_screenBufY = 0;
+    m_screenBufW = 0;
+    m_fps = 0;
+    m_nextMillis = GET_SYS_MILLIS();
+    m_startMillis = GET_SYS_MILLIS();
+    m_frameNo = 0;
+    m_frameCount = 0;
+    m_decodeMicros = 0;
+    m_pixelCount = 0;
+    m_pushCount = 0;
+    m_fpsStartMillis = GET_SYS_MILLIS();
+    // 调色板直接生成大端的RGB565 推屏时不需要再交换字节
+    m_tftSwapStatus = tft->getSwapBytes();
+    tft->setSwapBytes(false);
+    video_start();
+}
+
+GifPlayDocoder::~GifPlayDocoder(void)
+{
+    Serial.println(F("~GifPlayDocoder"));
+    // 释放资源
+    video_end();
+    tft->setSwapBytes(m_tftSwapStatus);
+}
+
+void *GifPlayDocoder::gif_open(const char *name, int32_t *size)
+{
+    // 文件已由播放器打开（可能是预读好的文件） 这里直接使用
+    *size = s_openFile->size();
+    return s_openFile;
+}
+
+void GifPlayDocoder::gif_close(void *handle)
+{
+    // 文件由播放器关闭
+}
+
+int32_t GifPlayDocoder::gif_read(GIFFILE *pFile, uint8_t *buf, int32_t len)
+{
+    File *file = (File *)pFile->fHandle;
+    if (len > pFile->iSize - pFile->iPos)
+    {
+        len = pFile->iSize - pFile->iPos;
+    }
+    if (len <= 0)
+    {
+        return 0;
+    }
+    int32_t read_size = file->read(buf, len);
+    pFile->iPos = file->position();
+    return read_size > 0 ? read_size : 0;
+}
+
+int32_t GifPlayDocoder::gif_seek(GIFFILE *pFile, int32_t pos)
+{
+    File *file = (File *)pFile->fHandle;
+    file->seek(pos);
+    pFile->iPos = file->position();
+    return pFile->iPos;
+}
+
+bool GifPlayDocoder::video_start()
+{
+    m_isEnd = false;
+    m_frameNo = 0;
+    if (NULL == m_gif)
+    {
+        void *mem = g_mediaBufPool.alloc(sizeof(AnimatedGIF), false);
+        if (NULL == mem)
+        {
+            Serial.printf("GIF decoder malloc %u failed\n", sizeof(AnimatedGIF));
+            m_isEnd = true;
+            return false;
+        }
+        m_gif = new (mem) AnimatedGIF();
+        m_gif->begin(GIF_PALETTE_RGB565_BE);
+    }
+    s_openFile = m_pFile;
+    int ret = m_gif->open(m_pFile->name(), gif_open, gif_close, gif_read, gif_seek, gif_draw);
+    s_openFile = NULL;
+    if (!ret)
+    {
+        Serial.printf("GIF open failed (%d)\n", m_gif->getLastError());
+        m_isEnd = true;
+        return false;
+    }
+
+    m_canvasWidth = m_gif->getCanvasWidth();
+    m_canvasHeight = m_gif->getCanvasHeight();
+    m_offsetX = ((int16_t)tft->width() - (int16_t)m_canvasWidth) / 2;
+    m_offsetY = ((int16_t)tft->height() - (int16_t)m_canvasHeight) / 2;
+    // 每帧只绘制变化的矩形 画布小于屏幕时开始时清一次屏
+    if (m_canvasWidth < tft->width() || m_canvasHeight < tft->height())
+    {
+        tft->fillScreen(TFT_BLACK);
+    }
+
+    // 一条最宽为屏幕上可见的画布宽度 切换文件时已有的缓冲够用就继续使用
+    uint16_t strip_width = m_canvasWidth < tft->width() ? m_canvasWidth : tft->width();
+    if (strip_width > m_lineBufWidth)
+    {
+        free_line_buf();
+        m_lineBufWithDma[0] = (uint16_t *)g_mediaBufPool.alloc(strip_width * GIF_STRIP_ROWS * 2, true);
+        m_lineBufWithDma[1] = (uint16_t *)g_mediaBufPool.alloc(strip_width * GIF_STRIP_ROWS * 2, true);
+        m_lineBufWidth = strip_width;
+    }
+    if (NULL == m_lineBufWithDma[0] || NULL == m_lineBufWithDma[1])
+    {
+        Serial.println(F("GIF line buffer malloc failed"));
+        m_isEnd = true;
+        return false;
+    }
+
+    // 画面缓存与清屏后的屏幕一样从黑色开始 不够用时重新分配
+    uint16_t screen_height = m_canvasHeight < tft->height() ? m_canvasHeight : tft->height();
+    uint32_t screen_size = (uint32_t)strip_width * screen_height * 2;
+    if (screen_size > m_screenBufSize)
+    {
+        free_screen_buf();
+        m_screenBuf = (uint16_t *)g_mediaBufPool.alloc(screen_size, false);
+        m_screenBufSize = NULL == m_screenBuf ? 0 : screen_size;
+    }
+    m_screenBufX = m_offsetX > 0 ? m_offsetX : 0;
+    m_screenBufY = m_offsetY > 0 ? m_offsetY : 0;
+    m_screenBufW = strip_width;
+    if (NULL != m_screenBuf)
+    {
+        memset(m_screenBuf, 0, screen_size);
+    }
+    else
+    {
+        Serial.printf("GIF screen buffer %u failed, transparent lines pushed in runs\n", screen_size);
+    }
+    tft->initDMA();
+    m_startMillis = GET_SYS_MILLIS();
+    m_nextMillis = m_startMillis;
+    Serial.printf("GIF %ux%u\n", m_canvasWidth, m_canvasHeight);
+    return true;
+}
+
+void GifPlayDocoder::gif_draw(GIFDRAW *pDraw)
+{
+    // AnimatedGIF每解码一行调用一次
+    ((GifPlayDocoder *)pDraw->pUser)->draw_line(pDraw);
+}
+
+void GifPlayDocoder::draw_line(GIFDRAW *pDraw)
+{
+    int16_t y = m_offsetY + pDraw->iY + pDraw->y;
+    int16_t x = m_offsetX + pDraw->iX;
+    int16_t w = pDraw->iWidth;
+    uint8_t *src = pDraw->pPixels;
+    if (y < 0 || y >= tft->height())
+    {
+        return;
+    }
+    // 裁掉屏幕外的部分
+    if (x < 0)
+    {
+        src -= x;
+        w += x;
+        x = 0;
+    }
+    if (x + w > tft->width())
+    {
+        w = tft->width() - x;
+    }
+    if (w <= 0)
+    {
+        return;
+    }
+
+    // 处置方式2（恢复为背景）：透明像素直接画成背景色
+    if (2 == pDraw->ucDisposalMethod && pDraw->ucHasTransparency)
+    {
+        for (int16_t i = 0; i < w; ++i)
+        {
+            if (src[i] == pDraw->ucTransparent)
+            {
+                src[i] = pDraw->ucBackground;
+            }
+        }
+        pDraw->ucHasTransparency = 0;
+    }
+
+    const uint16_t *palette = pDraw->pPalette;
+    uint16_t *screen = NULL == m_screenBuf ? NULL
+                                           : m_screenBuf + (y - m_screenBufY) * m_screenBufW + (x - m_screenBufX);
+    if (pDraw->ucHasTransparency && NULL == screen)
+    {
+        // 没有画面缓存：透明像素保留屏幕上上一帧的画面 只推送不透明的像素段
+        strip_flush();
+        push_runs(x, y, src, w, palette, pDraw->ucTransparent);
+        return;
+    }
+
+    // 不连续（换了帧矩形）时 先发送已拼接的条带
+    if (m_stripRows > 0 && (x != m_stripX || w != m_stripW || y != m_stripY + m_stripRows))
+    {
+        strip_flush();
+    }
+    if (0 == m_stripRows)
+    {
+        m_stripX = x;
+        m_stripY = y;
+        m_stripW = w;
+    }
+    // 正在DMA发送的是另一个缓冲（发送前会等待上一次完成） 这里可以直接写入
+    uint16_t *dst = m_lineBufWithDma[m_lineBufSel] + m_stripRows * w;
+    if (pDraw->ucHasTransparency)
+    {
+        // 透明像素取画面缓存中上一帧的颜色 合成后与不透明的行一样拼接发送
+        uint8_t transparent = pDraw->ucTransparent;
+        for (int16_t i = 0; i < w; ++i)
+        {
+            if (src[i] != transparent)
+            {
+                screen[i] = palette[src[i]];
+            }
+            dst[i] = screen[i];
+        }
+    }
+    else
+    {
+        for (int16_t i = 0; i < w; ++i)
+        {
+            dst[i] = palette[src[i]];
+        }
+        if (NULL != screen)
+        {
+            memcpy(screen, dst, w * 2);
+        }
+    }
+    if (++m_stripRows == m_stripMaxRows)
+    {
+        strip_flush();
+    }
+}
+
+void GifPlayDocoder::push_runs(int16_t x, int16_t y, const uint8_t *src, uint16_t w,
+                               const uint16_t *palette, uint8_t transparent)
+{
+    uint16_t i = 0;
+    while (i < w)
+    {
+        while (i < w && src[i] == transparent)
+        {
+            ++i;
+        }
+        uint16_t start = i;
+        uint16_t *dst = m_lineBufWithDma[m_lineBufSel];
+        while (i < w && src[i] != transparent)
+        {
+            dst[i - start] = palette[src[i]];
+            ++i;
+        }
+        if (i > start)
+        {
+            tft->pushImageDMA(x + start, y, i - start, 1, dst, nullptr);
+            m_lineBufSel = !m_lineBufSel;
+            m_pixelCount += i - start;
+            ++m_pushCount;
+        }
+    }
+}
+
+void GifPlayDocoder::strip_flush(void)
+{
+    // 发送已拼接的条带（一帧解码结束时也需要调用 发送最后一条）
+    if (0 == m_stripRows)
+    {
+        return;
+    }
+    tft->pushImageDMA(m_stripX, m_stripY, m_stripW, m_stripRows, m_lineBufWithDma[m_lineBufSel], nullptr);
+    m_lineBufSel = !m_lineBufSel;
+    m_pixelCount += m_stripW * m_stripRows;
+    ++m_pushCount;
+    m_stripRows = 0;
+}
+
+bool GifPlayDocoder::video_play_screen(void)
+{
+    if (m_isEnd)
+    {
+        return false;
+    }
+
+    // 超前时分段等待 一帧的延时可能很长
+    unsigned long now = GET_SYS_MILLIS();
+    if ((long)(m_nextMillis - now) > 0)
+    {
+        unsigned long wait = m_nextMillis - now;
+        delay(wait < GIF_WAIT_SLICE_MS ? wait : GIF_WAIT_SLICE_MS);
+        if ((long)(m_nextMillis - GET_SYS_MILLIS()) > 0)
+        {
+            return true;
+        }
+    }
+
+    int delay_ms = 0;
+    unsigned long decode_start = micros();
+    m_stripRows = 0;
+    int ret = m_gif->playFrame(false, &delay_ms, this);
+    strip_flush();
+    m_decodeMicros += micros() - decode_start;
+    if (ret < 0)
+    {
+        Serial.printf("GIF decode failed (%d)\n", m_gif->getLastError());
+        m_isEnd = true;
+        return false;
+    }
+    ++m_frameNo;
+
+    // 按每帧的延时播放（设置了帧率时按固定帧率）
+    if (0 != m_fps)
+    {
+        delay_ms = 1000 / m_fps;
+    }
+    else if (delay_ms < GIF_MIN_DELAY_MS)
+    {
+        delay_ms = GIF_DEFAULT_DELAY_MS;
+    }
+    now = GET_SYS_MILLIS();
+    if ((long)(now - m_nextMillis) > GIF_MAX_LATE_MS)
+    {
+        m_nextMillis = now;
+    }
+    m_nextMillis += delay_ms;
+
+    if (0 == ret)
+    {
+        // 最后一帧已显示 短动画从头循环 播放够时间后切换到下一个文件
+        if (GET_SYS_MILLIS() - m_startMillis < GIF_MIN_PLAY_MILLIS)
+        {
+            m_gif->reset();
+        }
+        else
+        {
+            m_isEnd = true;
+        }
+    }
+    fps_statistics();
+    return true;
+}
+
+void GifPlayDocoder::fps_statistics(void)
+{
+    // 每 GIF_FPS_REPORT_FRAMES 帧打印一次平均帧率、解码耗时以及平均每帧推送的像素数
+    if (++m_frameCount < GIF_FPS_REPORT_FRAMES)
+    {
+        return;
+    }
+    unsigned long cost = GET_SYS_MILLIS() - m_fpsStartMillis;
+    if (cost > 0)
+    {
+        Serial.printf("GIF %uMHz: %.2f fps draw %u us/frame %u px/frame (canvas %u) %u dma/frame\n",
+                      getCpuFrequencyMhz(),
+                      m_frameCount * 1000.0 / cost,
+                      m_decodeMicros / m_frameCount,
+                      m_pixelCount / m_frameCount,
+                      m_canvasWidth * m_canvasHeight,
+                      m_pushCount / m_frameCount);
+    }
+    m_frameCount = 0;
+    m_decodeMicros = 0;
+    m_pixelCount = 0;
+    m_pushCount = 0;
+    m_fpsStartMillis = GET_SYS_MILLIS();
+}
+
+bool GifPlayDocoder::video_end(void)
+{
+    m_pFile = NULL;
+    m_isEnd = true;
+    // 需要等待DMA发送完毕才可以释放缓冲
+    tft->dmaWait();
+    if (NULL != m_gif)
+    {
+        m_gif->close();
+        m_gif->~AnimatedGIF();
+        g_mediaBufPool.free(m_gif);
+        m_gif = NULL;
+    }
+    free_line_buf();
+    free_screen_buf();
+    return true;
+}
+
+void GifPlayDocoder::free_line_buf(void)
+{
+    tft->dmaWait();
+    for (int i = 0; i < 2; ++i)
+    {
+        if (NULL != m_lineBufWithDma[i])
+        {
+            g_mediaBufPool.free(m_lineBufWithDma[i]);
+            m_lineBufWithDma[i] = NULL;
+        }
+    }
+    m_lineBufWidth = 0;
+}
+
+void GifPlayDocoder::free_screen_buf(void)
+{
+    if (NULL != m_screenBuf)
+    {
+        g_mediaBufPool.free(m_screenBuf);
+        m_screenBuf = NULL;
+    }
+    m_screenBufSize = 0;
+}
+
+bool GifPlayDocoder::video_rewind(void)
+{
+    // 从第一帧重新播放 解码对象、缓冲与文件继续使用
+    if (NULL == m_pFile || NULL == m_gif)
+    {
+        return false;
+    }
+    tft->dmaWait();
+    m_gif->reset();
+    m_isEnd = false;
+    m_frameNo = 0;
+    m_startMillis = GET_SYS_MILLIS();
+    m_nextMillis = m_startMillis;
+    return true;
+}
+
+bool GifPlayDocoder::video_switch(File *file, const AioMediaHead *head)
+{
+    // 切换到另一个GIF 不重新创建解码对象（约20KB） 缓冲够用时直接复用
+    if (NULL == file)
+    {
+        return false;
+    }
+    tft->dmaWait();
+    if (NULL != m_gif)
+    {
+        m_gif->close();
+    }
+    m_pFile = file;
+    return video_start();
+}
+
+bool GifPlayDocoder::video_is_end(void)
+{
+    return NULL == m_pFile || m_isEnd;
+}
+
+void GifPlayDocoder::video_set_fps(uint8_t fps)
+{
+    // 0表示按文件中每帧的延时播放
+    m_fps = fps;
+}
@@ -0,0 +1,158 @@
+#include "media_buffer_pool.h"
+
+MediaBufferPool g_mediaBufPool;
+
+MediaBufferPool::MediaBufferPool()
+{
+    memset(m_blocks, 0, sizeof(m_blocks));
+    m_refCount = 0;
+    m_usedSize = 0;
+    m_peakSize = 0;
+}
+
+void MediaBufferPool::begin(const char *tag)
+{
+    if (0 == m_refCount)
+    {
+        m_peakSize = m_usedSize;
+    }
+    ++m_refCount;
+    report(tag);
+}
+
+void MediaBufferPool::end(const char *tag)
+{
+    if (m_refCount > 0)
+    {
+        --m_refCount;
+    }
+    if (0 == m_refCount)
+    {
+        trim();
+    }
+    report(tag);
+}
+
+MediaBufferPool::PoolBlock *MediaBufferPool::find_block(void *buf)
+{
+    for (int i = 0; i < MEDIA_POOL_BLOCK_NUM; ++i)
+    {
+        if (NULL != m_blocks[i].buf && buf == m_blocks[i].buf)
+        {
+            return &m_blocks[i];
+        }
+    }
+    return NULL;
+}
+
+void *MediaBufferPool::alloc(uint32_t size, bool isDma)
+{
+    // 优先复用大小足够的最小空闲块（DMA块也可以用作普通缓冲）
+    PoolBlock *best = NULL;
+    PoolBlock *empty = NULL;
+    for (int i = 0; i < MEDIA_POOL_BLOCK_NUM; ++i)
+    {
+        PoolBlock *block = &m_blocks[i];
+        if (NULL == block->buf)
+        {
+            if (NULL == empty)
+            {
+                empty = block;
+            }
+            continue;
+        }
+        if (block->isUsed || block->size < size || (isDma && !block->isDma))
+        {
+            continue;
+        }
+        if (NULL == best || block->size < best->size)
+        {
+            best = block;
+        }
+    }
+
+    if (NULL == best)
+    {
+        uint32_t caps = isDma ? MALLOC_CAP_DMA : MALLOC_CAP_8BIT;
+        void *buf = heap_caps_malloc(size, caps);
+        if (NULL == buf)
+        {
+            // 内存不足时释放池中空闲的块后重试
+            trim();
+            buf = heap_caps_malloc(size, caps);
+        }
+        if (NULL == buf)
+        {
+            Serial.printf("MediaBufferPool alloc %u failed\n", size);
+            return NULL;
+        }
+        if (NULL == empty)
+        {
+            // 池已满 不放入池中（释放时直接还给堆）
+            return buf;
+        }
+        best = empty;
+        best->buf = buf;
+        best->size = size;
+        best->isDma = isDma;
+    }
+
+    best->isUsed = true;
+    m_usedSize += best->size;
+    if (m_usedSize > m_peakSize)
+    {
+        m_peakSize = m_usedSize;
+    }
+    return best->buf;
+}
+
+void MediaBufferPool::free(void *buf)
+{
+    if (NULL == buf)
+    {
+        return;
+    }
+    PoolBlock *block = find_block(buf);
+    if (NULL == block)
+    {
+        ::free(buf);
+        return;
+    }
+    if (block->isUsed)
+    {
+        block->isUsed = false;
+        m_usedSize -= block->size;
+    }
+    if (0 == m_refCount)
+    {
+        // 没有APP在使用缓冲池 直接还给堆
+        ::free(block->buf);
+        memset(block, 0, sizeof(PoolBlock));
+    }
+}
+
+void MediaBufferPool::trim()
+{
+    for (int i = 0; i < MEDIA_POOL_BLOCK_NUM; ++i)
+    {
+        if (NULL != m_blocks[i].buf && !m_blocks[i].isUsed)
+        {
+            ::free(m_blocks[i].buf);
+            memset(&m_blocks[i], 0, sizeof(PoolBlock));
+        }
+    }
+}
+
+void MediaBufferPool::report(const char *tag)
+{
+    uint32_t pool_size = 0;
+    for (int i = 0; i < MEDIA_POOL_BLOCK_NUM; ++i)
+    {
+        pool_size += m_blocks[i].size;
+    }
+    Serial.printf("MediaBufferPool %s: pool %u used %u peak %u, free heap %u largest %u dma largest %u\n",
+                  tag, pool_size, m_usedSize, m_peakSize,
+                  heap_caps_get_free_size(MALLOC_CAP_8BIT),
+                  heap_caps_get_largest_free_block(MALLOC_CAP_8BIT),
+                  heap_caps_get_largest_free_block(MALLOC_CAP_DMA));
+}
@@ -0,0 +1,41 @@
+#ifndef MEDIA_BUFFER_POOL_H
+#define MEDIA_BUFFER_POOL_H
+
+#include <Arduino.h>
+
+#define MEDIA_POOL_BLOCK_NUM 8 // 缓冲池最多管理的内存块数
+
+// 视频播放相关的缓冲池（媒体播放器与LHLXW表情播放共用）
+// 在 begin() 与 end() 之间释放的缓冲不会还给堆 下一个视频直接复用
+// 避免切换视频时反复申请释放大块内存（DMA缓冲）导致堆碎片化 end()时才全部释放
+class MediaBufferPool
+{
+private:
+    struct PoolBlock
+    {
+        void *buf;
+        uint32_t size;
+        bool isDma;  // DMA可用的内存（也可以当普通内存使用）
+        bool isUsed; // 正在被使用
+    };
+    PoolBlock m_blocks[MEDIA_POOL_BLOCK_NUM];
+    uint8_t m_refCount; // 正在使用缓冲池的APP数
+    uint32_t m_usedSize; // 正在使用的大小
+    uint32_t m_peakSize; // 使用的峰值
+
+public:
+    MediaBufferPool();
+    void begin(const char *tag); // APP进入时调用
+    void end(const char *tag);   // APP退出时调用 最后一个退出时释放所有内存
+    void *alloc(uint32_t size, bool isDma);
+    void free(void *buf);
+    void trim();                 // 释放所有未使用的内存块
+    void report(const char *tag);
+
+private:
+    PoolBlock *find_block(void *buf);
+};
+
+extern MediaBufferPool g_mediaBufPool;
+
+#endif
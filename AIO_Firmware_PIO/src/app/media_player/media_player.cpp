@@ -5,6 +5,7 @@
 #include "driver/sd_card.h"
 #include "docoder.h"
 #include "DMADrawer.h"
+#include "prefetch_file.h"
 
 #define MEDIA_PLAYER_APP_NAME "Media"
 
@@ -13,6 +14,10 @@
 #define MOVIE_PATH "/movie"
 #define NO_TRIGGER_ENTER_FREQ_160M 90000UL // 无操作规定时间后进入设置160M主频（90s）
 #define NO_TRIGGER_ENTER_FREQ_80M 120000UL // 无操作规定时间后进入设置160M主频（120s）
+#define HALF_RES_BELOW_FREQ 240            // 主频低于该值时视频以1/2分辨率解码后放大显示（0不使用）
+#define MEDIA_RESUME_NUM 8                 // 记录续播位置的视频个数
+#define MEDIA_PREFETCH_DELAY 1000UL        // 开始播放多久后预读下一个视频（避免与当前视频开头的读取争抢SD卡）
+#define MEDIA_SWITCH_DEBOUNCE 400UL        // 切换视频后多久内忽略新的切换动作（避免手抖）
 
 // 天气的持久化配置
 #define MEDIA_CONFIG_PATH "/media.cfg"
@@ -20,6 +25,7 @@ struct MP_Config
 {
     uint8_t switchFlag; // 是否自动播放下一个（0不切换 1自动切换）
     uint8_t powerFlag;  // 功耗控制（0低发热 1性能优先）
+    uint8_t targetFps;  // 播放帧率 超前时等待 落后时丢帧（0不控制播放速度）
 };
 
 static void write_config(MP_Config *cfg)
@@ -33,6 +39,9 @@ static void write_config(MP_Config *cfg)
     memset(tmp, 0, 16);
     snprintf(tmp, 16, "%u\n", cfg->powerFlag);
     w_data += tmp;
+    memset(tmp, 0, 16);
+    snprintf(tmp, 16, "%u\n", cfg->targetFps);
+    w_data += tmp;
     g_flashCfg.writeFile(MEDIA_CONFIG_PATH, w_data.c_str());
 }
 
@@ -43,39 +52,79 @@ static void read_config(MP_Config *cfg)
     char info[128] = {0};
     uint16_t size = g_flashCfg.readFile(MEDIA_CONFIG_PATH, (uint8_t *)info);
     info[size] = 0;
-    if (size == 0)
+    // 统计参数个数 兼容旧版本的配置文件
+    int param_num = 0;
+    for (uint16_t pos = 0; pos < size; ++pos)
+    {
+        if ('\n' == info[pos])
+        {
+            ++param_num;
+        }
+    }
+    if (size == 0 || param_num < 2)
     {
         // 默认值
         cfg->switchFlag = 0; // 是否自动播放下一个（0不切换 1自动切换）
         cfg->powerFlag = 1;  // 功耗控制（0低发热 1性能优先）
+        cfg->targetFps = 0;  // 播放帧率（0不控制播放速度）
         write_config(cfg);
     }
     else
     {
         // 解析数据
-        char *param[2] = {0};
-        analyseParam(info, 2, param);
+        char *param[3] = {0};
+        analyseParam(info, param_num < 3 ? 2 : 3, param);
         cfg->switchFlag = atol(param[0]);
         cfg->powerFlag = atol(param[1]);
+        cfg->targetFps = NULL == param[2] ? 0 : atol(param[2]);
     }
 }
 
+// 解码对象的种类 相同种类的视频之间切换时复用解码对象
+enum MEDIA_DOCODER_TYPE
+{
+    MEDIA_DOCODER_NONE = 0,
+    MEDIA_DOCODER_MJPEG,
+    MEDIA_DOCODER_RGB,
+    MEDIA_DOCODER_TILE_RGB,
+    MEDIA_DOCODER_GIF,
+};
+
 struct MediaAppRunData
 {
     PlayDocoderBase *player_docoder;
+    MEDIA_DOCODER_TYPE docoder_type;   // player_docoder 的种类
     unsigned long preTriggerKeyMillis; // 最近一回按键触发的时间戳
     int movie_pos_increate;
     File_Info *movie_file; // movie文件夹下的文件指针头
     File_Info *pfile;      // 指向当前播放的文件节点
-    File file;
+    File file[2];          // 正在播放的是file[file_sel] 切换时新文件放在另一个中
+    uint8_t file_sel;      // 解码对象停止读取旧文件后 旧文件才关闭
+    File_Info *resume_file[MEDIA_RESUME_NUM]; // 记录续播位置的视频
+    uint32_t resume_frame[MEDIA_RESUME_NUM];  // 对应视频上一次播放到的帧
+    uint8_t resume_pos;                       // 下一条记录写入的位置
+    File next_file;                           // 预先打开并读入开头数据的下一个视频
+    File_Info *next_pfile;                    // next_file 对应的文件节点
+    unsigned long clipStartMillis;            // 当前视频开始播放的时间
+    unsigned long switchMillis;               // 最近一次切换视频的时间
 };
 
 static MP_Config cfg_data;
 static MediaAppRunData *run_data = NULL;
 
+static bool is_video_file(const char *file_name)
+{
+    // 只播放支持的视频格式（跳过 .idx 索引等其他文件）
+    return NULL != strstr(file_name, ".mjpeg") || NULL != strstr(file_name, ".MJPEG") ||
+           NULL != strstr(file_name, ".rgb") || NULL != strstr(file_name, ".RGB") ||
+           NULL != strstr(file_name, ".trgb") || NULL != strstr(file_name, ".TRGB") ||
+           NULL != strstr(file_name, ".aio") || NULL != strstr(file_name, ".AIO") ||
+           NULL != strstr(file_name, ".gif") || NULL != strstr(file_name, ".GIF");
+}
+
 static File_Info *get_next_file(File_Info *p_cur_file, int direction)
 {
-    // 得到 p_cur_file 的下一个 类型为FILE_TYPE_FILE 的文件（即下一个非文件夹文件）
+    // 得到 p_cur_file 的下一个 类型为FILE_TYPE_FILE 的视频文件（即下一个非文件夹文件）
     if (NULL == p_cur_file)
     {
         return NULL;
@@ -84,7 +133,7 @@ static File_Info *get_next_file(File_Info *p_cur_file, int direction)
     File_Info *pfile = direction == 1 ? p_cur_file->next_node : p_cur_file->front_node;
     while (pfile != p_cur_file)
     {
-        if (FILE_TYPE_FILE == pfile->file_type)
+        if (FILE_TYPE_FILE == pfile->file_type && is_video_file(pfile->file_name))
         {
             break;
         }
@@ -93,6 +142,67 @@ static File_Info *get_next_file(File_Info *p_cur_file, int direction)
     return pfile;
 }
 
+static void get_file_path(File_Info *pfile, char *file_name)
+{
+    snprintf(file_name, FILENAME_MAX_LEN, "%s/%s", run_data->movie_file->file_name, pfile->file_name);
+}
+
+static void release_prefetch(void)
+{
+    if (run_data->next_file)
+    {
+        run_data->next_file.close();
+    }
+    run_data->next_file = File();
+    run_data->next_pfile = NULL;
+}
+
+static void prefetch_next_file(void)
+{
+    // 当前视频播放一段时间后 提前打开下一个视频并读入开头的数据
+    // 自动播放下一个或者切换视频时直接使用 不再等待SD卡打开与读取
+    if (NULL != run_data->next_pfile || NULL == run_data->pfile ||
+        GET_SYS_MILLIS() - run_data->clipStartMillis < MEDIA_PREFETCH_DELAY)
+    {
+        return;
+    }
+    File_Info *pfile = get_next_file(run_data->pfile, run_data->movie_pos_increate);
+    char file_name[FILENAME_MAX_LEN] = {0};
+    get_file_path(pfile, file_name);
+    // 打开失败时同样记录节点 避免反复尝试
+    run_data->next_file = prefetch_file_open(file_name);
+    run_data->next_pfile = pfile;
+}
+
+static void release_player_docoder(void)
+{
+    // 释放具体的播放对象
+    if (NULL != run_data->player_docoder)
+    {
+        delete run_data->player_docoder;
+        run_data->player_docoder = NULL;
+    }
+    run_data->docoder_type = MEDIA_DOCODER_NONE;
+}
+
+static PlayDocoderBase *new_player_docoder(MEDIA_DOCODER_TYPE type, File *file, const AioMediaHead *head)
+{
+    switch (type)
+    {
+    case MEDIA_DOCODER_MJPEG:
+        // 读卡与解码分别运行在两个核上 SD卡的读取延时被解码时间掩盖
+        return new MjpegPlayDocoder(file, true, true, head);
+    case MEDIA_DOCODER_RGB:
+        return new RgbPlayDocoder(file, true, RGB_STRIP_HEIGHT, head);
+    case MEDIA_DOCODER_TILE_RGB:
+        return new TileRgbPlayDocoder(file);
+    case MEDIA_DOCODER_GIF:
+        return new GifPlayDocoder(file);
+    default:
+        return NULL;
+    }
+}
+
 static bool video_start(bool create_new)
 {
     if (NULL == run_data->pfile)
@@ -107,34 +217,137 @@ static bool video_start(bool create_new)
     }
 
     char file_name[FILENAME_MAX_LEN] = {0};
-    snprintf(file_name, FILENAME_MAX_LEN, "%s/%s", run_data->movie_file->file_name, run_data->pfile->file_name);
+    get_file_path(run_data->pfile, file_name);
 
-    run_data->file = tf.open(file_name);
-    if (NULL != strstr(run_data->pfile->file_name, ".mjpeg") || NULL != strstr(run_data->pfile->file_name, ".MJPEG"))
+    // 新文件放在另一个File中 正在播放的文件在解码对象切换之后才关闭（流水线任务可能还在读取）
+    File *old_file = &run_data->file[run_data->file_sel];
+    File *file = &run_data->file[!run_data->file_sel];
+    if (run_data->pfile == run_data->next_pfile && run_data->next_file)
+    {
+        // 使用预读好的文件
+        *file = run_data->next_file;
+        run_data->next_file = File();
+        run_data->next_pfile = NULL;
+    }
+    else
+    {
+        *file = tf.open(file_name);
+    }
+    if (true == create_new)
+    {
+        // 换了视频（或者切换了方向）之前的预读已经没有用了
+        release_prefetch();
+    }
+    run_data->clipStartMillis = GET_SYS_MILLIS();
+
+    MEDIA_DOCODER_TYPE type = MEDIA_DOCODER_NONE;
+    AioMediaHead head;
+    const AioMediaHead *phead = NULL;
+    if (!*file)
+    {
+        Serial.print(F("Video open failed --------> "));
+    }
+    else if (NULL != strstr(run_data->pfile->file_name, ".aio") || NULL != strstr(run_data->pfile->file_name, ".AIO"))
+    {
+        // 自描述的容器 按文件头中的编码格式、宽高与帧率播放
+        bool isValid = aio_media_read_head(file, &head);
+        if (isValid && AIO_CODEC_MJPEG == head.codec)
+        {
+            type = MEDIA_DOCODER_MJPEG;
+            phead = &head;
+            Serial.print(F("AIO MJPEG video start --------> "));
+        }
+        else if (isValid && AIO_CODEC_RGB565 == head.codec)
+        {
+            type = MEDIA_DOCODER_RGB;
+            phead = &head;
+            Serial.print(F("AIO RGB565 video start --------> "));
+        }
+        else
+        {
+            Serial.print(F("AIO video not supported --------> "));
+        }
+    }
+    else if (NULL != strstr(run_data->pfile->file_name, ".mjpeg") || NULL != strstr(run_data->pfile->file_name, ".MJPEG"))
     {
         // 直接解码mjpeg格式的视频
-        run_data->player_docoder = new MjpegPlayDocoder(&run_data->file, true);
+        type = MEDIA_DOCODER_MJPEG;
         Serial.print(F("MJPEG video start --------> "));
     }
+    else if (NULL != strstr(run_data->pfile->file_name, ".trgb") || NULL != strstr(run_data->pfile->file_name, ".TRGB"))
+    {
+        // 分块差分的RGB565视频 只刷新变化的块
+        type = MEDIA_DOCODER_TILE_RGB;
+        Serial.print(F("Tile RGB565 video start --------> "));
+    }
     else if (NULL != strstr(run_data->pfile->file_name, ".rgb") || NULL != strstr(run_data->pfile->file_name, ".RGB"))
     {
         // 使用RGB格式的视频
-        run_data->player_docoder = new RgbPlayDocoder(&run_data->file, true);
+        type = MEDIA_DOCODER_RGB;
         Serial.print(F("RGB565 video start --------> "));
     }
+    else if (NULL != strstr(run_data->pfile->file_name, ".gif") || NULL != strstr(run_data->pfile->file_name, ".GIF"))
+    {
+        // GIF动画 边读边解码 每帧只刷新变化的矩形
+        type = MEDIA_DOCODER_GIF;
+        Serial.print(F("GIF start --------> "));
+    }
 
     Serial.println(file_name);
+
+    // 同种格式之间切换时把新文件交给正在使用的解码对象（缓冲、DMA与解码器的表缓存都继续使用）
+    // 只有换了格式（或切换失败）时才重新创建
+    bool isSwitched = MEDIA_DOCODER_NONE != type && type == run_data->docoder_type &&
+                      NULL != run_data->player_docoder &&
+                      run_data->player_docoder->video_switch(file, phead);
+    if (!isSwitched)
+    {
+        release_player_docoder();
+        run_data->player_docoder = new_player_docoder(type, file, phead);
+        run_data->docoder_type = NULL == run_data->player_docoder ? MEDIA_DOCODER_NONE : type;
+    }
+    // 解码对象已经改为读取新文件
+    old_file->close();
+    run_data->file_sel = !run_data->file_sel;
+
+    if (NULL != run_data->player_docoder)
+    {
+        run_data->player_docoder->video_set_fps(cfg_data.targetFps);
+        // 从上一次离开的位置继续播放
+        for (int i = 0; i < MEDIA_RESUME_NUM; ++i)
+        {
+            if (run_data->pfile == run_data->resume_file[i] && run_data->resume_frame[i] > 0)
+            {
+                run_data->player_docoder->video_seek(run_data->resume_frame[i]);
+                break;
+            }
+        }
+    }
     return true;
 }
 
-static void release_player_docoder(void)
+static void save_resume_frame(uint32_t frame)
 {
-    // 释放具体的播放对象
-    if (NULL != run_data->player_docoder)
+    // 记录当前视频播放到的位置（frame为0表示从头播放）
+    if (NULL == run_data->pfile)
     {
-        delete run_data->player_docoder;
-        run_data->player_docoder = NULL;
+        return;
+    }
+    for (int i = 0; i < MEDIA_RESUME_NUM; ++i)
+    {
+        if (run_data->pfile == run_data->resume_file[i])
+        {
+            run_data->resume_frame[i] = frame;
+            return;
+        }
     }
+    if (0 == frame)
+    {
+        return;
+    }
+    run_data->resume_file[run_data->resume_pos] = run_data->pfile;
+    run_data->resume_frame[run_data->resume_pos] = frame;
+    run_data->resume_pos = (run_data->resume_pos + 1) % MEDIA_RESUME_NUM;
 }
 
 static int media_player_init(AppController *sys)
@@ -148,15 +361,23 @@ static int media_player_init(AppController *sys)
 
     // 获取配置信息
     read_config(&cfg_data);
+    // 播放时直接操作屏幕 LVGL的绘制缓冲借给视频缓冲使用
+    screen.lendDrawBuf("media enter");
+    // 视频缓冲在APP退出前一直复用
+    g_mediaBufPool.begin("media enter");
     // 初始化运行时参数
     // run_data = (MediaAppRunData *)malloc(sizeof(MediaAppRunData));
     // memset(run_data, 0, sizeof(MediaAppRunData));
     run_data = (MediaAppRunData *)calloc(1, sizeof(MediaAppRunData));
     run_data->player_docoder = NULL;
+    run_data->docoder_type = MEDIA_DOCODER_NONE;
+    run_data->file_sel = 0;
     run_data->movie_pos_increate = 1;
     run_data->movie_file = NULL; // movie文件夹下的文件指针头
     run_data->pfile = NULL;      // 指向当前播放的文件节点
     run_data->preTriggerKeyMillis = GET_SYS_MILLIS();
+    run_data->next_pfile = NULL;
+    run_data->switchMillis = 0;
 
     run_data->movie_file = tf.listDir(MOVIE_PATH);
     if (NULL != run_data->movie_file)
@@ -195,7 +416,8 @@ static void media_player_process(AppController *sys,
         return;
     }
 
-    if (TURN_RIGHT == act_info->active || TURN_LEFT == act_info->active)
+    if ((TURN_RIGHT == act_info->active || TURN_LEFT == act_info->active) &&
+        GET_SYS_MILLIS() - run_data->switchMillis >= MEDIA_SWITCH_DEBOUNCE)
     {
         // 切换方向
         if (TURN_RIGHT == act_info->active)
@@ -206,13 +428,15 @@ static void media_player_process(AppController *sys,
         {
             run_data->movie_pos_increate = -1;
         }
-        // 结束播放
-        release_player_docoder();
-        run_data->file.close(); // 尝试关闭文件
+        // 记录当前视频的位置
+        if (NULL != run_data->player_docoder)
+        {
+            save_resume_frame(run_data->player_docoder->video_get_frame());
+        }
 
-        // 创建播放
+        // 切换到新视频（不再暂停等待 手抖产生的连续动作由 MEDIA_SWITCH_DEBOUNCE 过滤）
         video_start(true);
-        vTaskDelay(400 / portTICK_PERIOD_MS); // 暂缓播放 避免手抖
+        run_data->switchMillis = GET_SYS_MILLIS();
     }
 
     if (NULL == run_data->pfile)
@@ -236,30 +460,36 @@ static void media_player_process(AppController *sys,
         }
     }
 
-    if (!run_data->file)
+    if (NULL == run_data->player_docoder)
     {
-        Serial.println(F("Failed to open file for reading"));
+        // 文件打开失败或无法播放（例如.aio文件头损坏） 直接切换到下一个
+        video_start(true);
         return;
     }
 
-    if (run_data->file.available())
+    if (!run_data->player_docoder->video_is_end())
     {
+        // 降频后自动使用低功耗的半分辨率解码（恢复主频后恢复全分辨率）
+        run_data->player_docoder->video_set_low_power(getCpuFrequencyMhz() < HALF_RES_BELOW_FREQ);
         // 播放一帧数据
         run_data->player_docoder->video_play_screen();
+        prefetch_next_file();
     }
     else
     {
         // 结束播放
-        release_player_docoder();
-        run_data->file.close();
+        save_resume_frame(0);
         if (0 == cfg_data.switchFlag)
         {
-            // 创建播放(重复播放)
-            video_start(false);
+            // 重复播放 解码对象直接回到第一帧（不支持时重新打开文件）
+            if (!run_data->player_docoder->video_rewind())
+            {
+                video_start(false);
+            }
         }
         else
         {
-            // 创建播放(播放下一个)
+            // 播放下一个
             video_start(true);
         }
     }
@@ -274,10 +504,13 @@ static void media_player_background_task(AppController *sys,
 
 static int media_player_exit_callback(void *param)
 {
-    // 结束播放
+    // 结束播放 解码对象只在退出时释放
     release_player_docoder();
+    release_prefetch();
 
-    run_data->file.close(); // 退出时关闭文件
+    // 退出时关闭文件
+    run_data->file[0].close();
+    run_data->file[1].close();
     // 释放文件循环队列
     release_file_info(run_data->movie_file);
 
@@ -287,6 +520,8 @@ static int media_player_exit_callback(void *param)
         free(run_data);
         run_data = NULL;
     }
+    g_mediaBufPool.end("media exit");
+    screen.returnDrawBuf("media exit");
 
     return 0;
 }
@@ -308,6 +543,10 @@ static void media_player_message_handle(const char *from, const char *to,
         {
             snprintf((char *)ext_info, 32, "%u", cfg_data.powerFlag);
         }
+        else if (!strcmp(param_key, "targetFps"))
+        {
+            snprintf((char *)ext_info, 32, "%u", cfg_data.targetFps);
+        }
         else
         {
             snprintf((char *)ext_info, 32, "%s", "NULL");
@@ -326,6 +565,15 @@ static void media_player_message_handle(const char *from, const char *to,
         {
             cfg_data.powerFlag = atol(param_val);
         }
+        else if (!strcmp(param_key, "targetFps"))
+        {
+            cfg_data.targetFps = atol(param_val);
+            // 正在播放时立即生效
+            if (NULL != run_data && NULL != run_data->player_docoder)
+            {
+                run_data->player_docoder->video_set_fps(cfg_data.targetFps);
+            }
+        }
     }
     break;
     case APP_MESSAGE_READ_CFG:
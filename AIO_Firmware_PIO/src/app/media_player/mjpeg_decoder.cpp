@@ -1,16 +1,37 @@
 #include "docoder.h"
 #include "common.h"
+#include "mjpeg_scan.h"
 #include <TJpg_Decoder.h>
 // #include "MjpegClass.h"
 // static MjpegClass mjpeg;
 
 #define VIDEO_WIDTH 240L
 #define VIDEO_HEIGHT 240L
-#define EACH_READ_SIZE 2500     // 每次获取的数据流大小
-#define JPEG_BUFFER_SIZE 10000  // 储存一张jpeg的图像(240*240 10000大概够了，正常一帧差不多3000)
-#define MOVIE_BUFFER_SIZE 20000 // 理论上是JPEG_BUFFER_SIZE的两倍就够了
+#define EACH_READ_SIZE 2500                     // 每次获取的数据流大小
+#define MJPEG_RING_MAX_SIZE 32768               // 环形缓冲的最大值（没有帧索引时使用 必须为2的幂）
+#define MJPEG_RING_MIN_SIZE 4096                // 环形缓冲的最小值（必须为2的幂）
+
+#if (MJPEG_RING_MAX_SIZE & (MJPEG_RING_MAX_SIZE - 1)) != 0 || (MJPEG_RING_MIN_SIZE & (MJPEG_RING_MIN_SIZE - 1)) != 0
+#error "MJPEG ring size must be a power of two"
+#endif
 
 #define DMA_BUFFER_SIZE 512 // (16*16*2)
+#ifndef MJPEG_STRIP_DMA
+#define MJPEG_STRIP_DMA 1           // 1: 一行MCU拼接成一条后一次DMA发送 0: 每个MCU发送一次（用于对比）
+#endif
+#define MJPEG_STRIP_MAX_HEIGHT 16   // MCU的最大高度（4:2:0采样）
+#define MJPEG_DECODE_LEVEL 2        // tjpgd优化级别 2: 查表解哈夫曼码（多占用约6KB工作区） 1: 与相册相同
+#define MJPEG_TABLE_CLIP 0          // 1: 颜色转换时查表限幅 0: 比较限幅
+#define MJPEG_TABLE_CACHE 1         // 1: 帧间复用哈夫曼表与量化表（表不变时跳过重建） 0: 每帧重新解析（用于对比）
+
+#define MJPEG_READ_TASK_CORE 0          // 读卡任务所在的核（loop运行在1核）
+#define MJPEG_DECODE_TASK_CORE 1        // 解码任务所在的核
+#define MJPEG_READ_TASK_PRIORITY 1      // 读卡任务优先级
+#define MJPEG_DECODE_TASK_PRIORITY 1    // 解码任务优先级
+#define MJPEG_PIPE_WAIT_TICKS 20        // 流水线任务阻塞等待的超时（用于检查退出标志）
+#ifndef MJPEG_FPS_REPORT_FRAMES
+#define MJPEG_FPS_REPORT_FRAMES 100     // 每播放多少帧打印一次帧率（主机上的测试改为整段统计）
+#endif
 
 #define TFT_MISO -1
 #define TFT_MOSI 23
@@ -22,11 +43,42 @@
 bool MjpegPlayDocoder::m_isUseDMA = 0;
 uint8_t *MjpegPlayDocoder::m_displayBufWithDma[2];
 bool MjpegPlayDocoder::m_dmaBufferSel = false;
+uint16_t MjpegPlayDocoder::m_stripX = 0;
+uint16_t MjpegPlayDocoder::m_stripY = 0;
+uint16_t MjpegPlayDocoder::m_stripW = 0;
+uint16_t MjpegPlayDocoder::m_stripH = 0;
+uint16_t MjpegPlayDocoder::m_stripStride = 0;
+uint16_t MjpegPlayDocoder::m_stripMaxH = MJPEG_STRIP_MAX_HEIGHT;
+uint32_t MjpegPlayDocoder::m_pushCount = 0;
+uint8_t MjpegPlayDocoder::m_zoomShift = 0;
+int16_t MjpegPlayDocoder::m_outX = 0;
+int16_t MjpegPlayDocoder::m_outY = 0;
+
+void MjpegPlayDocoder::zoom_copy(uint16_t *dst, uint16_t stride, const uint16_t *src, uint16_t w, uint16_t h)
+{
+    // 每个像素放大为2*2：横向放大一行后复制到下一行（dst按4字节对齐）
+    for (uint16_t row = 0; row < h; ++row)
+    {
+        uint32_t *line = (uint32_t *)(dst + row * 2 * stride);
+        for (uint16_t col = 0; col < w; ++col)
+        {
+            line[col] = src[col] * 0x10001U;
+        }
+        memcpy(dst + (row * 2 + 1) * stride, line, w * 4);
+        src += w;
+    }
+}
 
 // This next function will be called during decoding of the jpeg file to render each
 // 16x16 or 8x8 image tile (Minimum Coding Unit) to the tft->
 bool MjpegPlayDocoder::tft_output(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap)
 {
+    // 解码输出的坐标转换为屏幕坐标（放大显示时块的宽高也加倍）
+    x = m_outX + (x << m_zoomShift);
+    y = m_outY + (y << m_zoomShift);
+    uint16_t out_w = w << m_zoomShift;
+    uint16_t out_h = h << m_zoomShift;
+
     // Stop further decoding as image is running off bottom of screen
     if (y >= tft->height())
         return 0;
@@ -39,6 +91,45 @@ bool MjpegPlayDocoder::tft_output(int16_t x, int16_t y, uint16_t w, uint16_t h,
     // Apparent performance benefit of DMA = 95/52 = 83%, 52 - 43 = 9ms lost elsewhere
     if (m_isUseDMA)
     {
+#if MJPEG_STRIP_DMA
+        // 不连续（换行）或者放不下时 先发送已拼接的条带
+        if (m_stripW > 0 &&
+            (y != m_stripY || out_h != m_stripH || x != m_stripX + m_stripW || m_stripW + out_w > m_stripStride))
+        {
+            strip_flush();
+        }
+        if (out_h > m_stripMaxH || out_w > m_stripStride)
+        {
+            // 不会出现的情况 等待DMA结束后直接发送本块
+            tft->dmaWait();
+            push_block(x, y, w, h, bitmap);
+            return 1;
+        }
+        if (0 == m_stripW)
+        {
+            m_stripX = x;
+            m_stripY = y;
+            m_stripH = out_h;
+        }
+        // 正在DMA发送的是另一个条带缓冲（发送前会等待上一次完成） 这里可以直接写入
+        uint16_t *dst = (uint16_t *)m_displayBufWithDma[m_dmaBufferSel] + m_stripW;
+        if (m_zoomShift)
+        {
+            zoom_copy(dst, m_stripStride, bitmap, w, h);
+        }
+        else
+        {
+            for (uint16_t row = 0; row < h; ++row)
+            {
+                memcpy(dst + row * m_stripStride, bitmap + row * w, w * 2);
+            }
+        }
+        m_stripW += out_w;
+        if (m_stripW == m_stripStride)
+        {
+            strip_flush();
+        }
+#else
         // Double buffering is used, the bitmap is copied to the buffer by pushImageDMA() the
         // bitmap can then be updated by the jpeg decoder while DMA is in progress
         uint16_t *dmaBufferPtr;
@@ -47,72 +138,118 @@ bool MjpegPlayDocoder::tft_output(int16_t x, int16_t y, uint16_t w, uint16_t h,
         else
             dmaBufferPtr = (uint16_t *)MjpegPlayDocoder::m_displayBufWithDma[1];
         MjpegPlayDocoder::m_dmaBufferSel = !MjpegPlayDocoder::m_dmaBufferSel; // Toggle buffer selection
+        if (m_zoomShift)
+        {
+            // 放大后的块直接写入空闲的DMA缓冲（上一次使用它的传输已经结束）
+            zoom_copy(dmaBufferPtr, out_w, bitmap, w, h);
+            bitmap = dmaBufferPtr;
+            dmaBufferPtr = nullptr;
+        }
         //  pushImageDMA() will clip the image block at screen boundaries before initiating DMA
-        tft->pushImageDMA(x, y, w, h, bitmap, dmaBufferPtr); // Initiate DMA - blocking only if last DMA is not complete
-                                                             // The DMA transfer of image block to the TFT is now in progress...
+        tft->pushImageDMA(x, y, out_w, out_h, bitmap, dmaBufferPtr); // Initiate DMA - blocking only if last DMA is not complete
+                                                                     // The DMA transfer of image block to the TFT is now in progress...
+        ++m_pushCount;
+#endif
     }
     else
     {
         // Non-DMA blocking alternative
-        tft->pushImage(x, y, w, h, bitmap); // Blocking, so only returns when image block is drawn
+        push_block(x, y, w, h, bitmap); // Blocking, so only returns when image block is drawn
     }
     // Return 1 to decode next block.
     return 1;
 }
 
-uint32_t MjpegPlayDocoder::readJpegFromFile(File *file)
+void MjpegPlayDocoder::push_block(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap)
 {
-    int32_t read_size = 0;
-    int32_t pos = 0;
-    bool isFound = false;
-    while (true)
+    // 不使用DMA时直接发送一个块 放大显示时逐行放大后发送（MCU最宽16像素）
+    if (0 == m_zoomShift)
     {
-        // 查找帧
-        for (; pos < m_bufSaveTail - 1; ++pos)
-        {
-            if (m_displayBuf[pos] == 0xFF && m_displayBuf[pos + 1] == 0xD9)
-            {
-                isFound = true;
-                break;
-            }
-        }
-        if (isFound)
-        {
-            // 找到一帧数据
-            break;
-        }
-        if (m_bufSaveTail + EACH_READ_SIZE > MOVIE_BUFFER_SIZE)
-        {
-            // 防止本帧太大溢出，间接丢弃该帧
-            m_bufSaveTail = 0;
-            pos = 0;
-        }
-        read_size = file->read(&m_displayBuf[m_bufSaveTail], EACH_READ_SIZE);
-        m_bufSaveTail += read_size;
+        tft->pushImage(x, y, w, h, bitmap);
+        return;
     }
+    uint16_t line[MJPEG_STRIP_MAX_HEIGHT * 4] __attribute__((aligned(4)));
+    for (uint16_t row = 0; row < h; ++row)
+    {
+        zoom_copy(line, w * 2, bitmap + row * w, w, 1);
+        tft->pushImage(x, y + row * 2, w * 2, 2, line);
+    }
+}
 
-    if (pos + 2 < JPEG_BUFFER_SIZE)
+void MjpegPlayDocoder::strip_flush(void)
+{
+    // 发送已拼接的条带（一帧解码结束时也需要调用 发送最后一条）
+    if (0 == m_stripW)
+    {
+        return;
+    }
+    uint16_t *strip = (uint16_t *)m_displayBufWithDma[m_dmaBufferSel];
+    if (m_stripW < m_stripStride)
     {
-        // 只有帧大小小于 JPEG_BUFFER_SIZE 的时候才可以拷贝
-        memcpy(m_jpegBuf, m_displayBuf, pos + 2);
+        // 比缓冲窄（视频比屏幕窄）时把各行紧凑排列
+        for (uint16_t row = 1; row < m_stripH; ++row)
+        {
+            memmove(strip + row * m_stripW, strip + row * m_stripStride, m_stripW * 2);
+        }
     }
-    // 把多余数据（本次没用上的数据保存下来）
-    memcpy(m_displayBuf, &m_displayBuf[pos + 2], m_bufSaveTail - pos - 2);
-    // 保存数据 下次循环再使用
-    m_bufSaveTail = m_bufSaveTail - pos - 2;
-    // Serial.println(pos + 2);
-    return pos + 2;
+    tft->pushImageDMA(m_stripX, m_stripY, m_stripW, m_stripH, strip, nullptr);
+    ++m_pushCount;
+    m_dmaBufferSel = !m_dmaBufferSel;
+    m_stripW = 0;
 }
 
-MjpegPlayDocoder::MjpegPlayDocoder(File *file, bool isUseDMA)
+MjpegPlayDocoder::MjpegPlayDocoder(File *file, bool isUseDMA, bool isPipeline, const AioMediaHead *head)
 {
-    m_pFile = file;
+    set_media(file, head);
+    m_offsetX = 0;
+    m_offsetY = 0;
+    m_targetFps = 0;
+    m_isSmall = false;
+    m_isLowPower = false;
+    m_jpgScale = 1;
     m_isUseDMA = isUseDMA;
-    m_displayBuf = NULL;
-    m_bufSaveTail = 0;
-    m_jpegBuf = NULL;
+    // 流水线模式依赖DMA推屏（解码任务推送DMA的同时读卡任务继续读取SD卡）
+    m_isPipeline = isUseDMA && isPipeline;
+    m_pipeStop = false;
+    m_pipeEnd = false;
+    m_ringBuf = NULL;
+    m_ringSize = MJPEG_RING_MAX_SIZE;
+    m_ringMask = MJPEG_RING_MAX_SIZE - 1;
+    m_maxFrameSize = MJPEG_RING_MAX_SIZE - EACH_READ_SIZE;
+    m_ringHead = 0;
+    m_ringTail = 0;
+    m_scanPos = 0;
+    m_frameStart = 0;
+    m_isOversize = false;
+    m_oversizeStart = 0;
+    m_frameQueue = NULL;
+    m_spaceSem = NULL;
+    m_frameDoneSem = NULL;
+    m_taskExitSem = NULL;
+    m_readTask = NULL;
+    m_decodeTask = NULL;
+    m_readFrame = 0;
+    m_showFrame = 0;
+    m_seekFrame = -1;
+    m_isLastSkip = false;
+    m_dropCount = 0;
+    m_frameCount = 0;
+    m_fpsStartMillis = GET_SYS_MILLIS();
+    m_scanMicros = 0;
+    m_readBytes = 0;
+    m_drawMicros = 0;
+    m_headerMicros = 0;
+    m_headerBytes = 0;
+    m_tableSegs = 0;
+    m_tableHits = 0;
+    m_pushCount = 0;
+    m_stripW = 0;
+    m_stripStride = tft->width();
+    m_stripMaxH = MJPEG_STRIP_MAX_HEIGHT;
+    m_zoomShift = 0;
     m_displayBufWithDma[0] = NULL;
     m_displayBufWithDma[1] = NULL;
+    m_dmaBufSize = 0;
     m_dmaBufferSel = 0;
     // The jpeg image can be scaled down by a factor of 1, 2, 4, or 8
     TJpgDec.setJpgScale(1);
@@ -124,6 +261,17 @@ MjpegPlayDocoder::MjpegPlayDocoder(File *file, bool isUseDMA)
     // The decoder must be given the exact name of the rendering function above
     SketchCallback callback = (SketchCallback)&MjpegPlayDocoder::tft_output; // 强制转换func()的类型
     TJpgDec.setCallback(callback);
+    // 视频的每一帧通常使用相同的表 省略DHT的帧（AVI式MJPEG）使用标准哈夫曼表
+    TJpgDec.setStreamMode(MJPEG_TABLE_CACHE);
+    // 视频使用更快的解码级别 工作区从缓冲池分配（相册等仍使用解码器内置的小工作区）
+    m_jpgWorkspace = NULL;
+    if (MJPEG_DECODE_LEVEL >= 2)
+    {
+        m_jpgWorkspace = (uint8_t *)g_mediaBufPool.alloc(TJPGD_WORKSPACE_SIZE_LUT, false);
+    }
+    TJpgDec.setWorkspace(m_jpgWorkspace, TJPGD_WORKSPACE_SIZE_LUT);
+    TJpgDec.setDecodeLevel(MJPEG_DECODE_LEVEL);
+    TJpgDec.setTableClip(MJPEG_TABLE_CLIP);
     video_start();
 }
 
@@ -133,26 +281,168 @@ MjpegPlayDocoder::~MjpegPlayDocoder(void)
     tft->setSwapBytes(m_tftSwapStatus);
     // 释放资源
     video_end();
+    // 其他APP也会使用TJpgDec
+    TJpgDec.setStreamMode(false);
+    TJpgDec.setJpgScale(1);
+    TJpgDec.setDecodeLevel(1);
+    TJpgDec.setTableClip(false);
+    TJpgDec.setWorkspace(NULL, 0);
+    if (NULL != m_jpgWorkspace)
+    {
+        g_mediaBufPool.free(m_jpgWorkspace);
+        m_jpgWorkspace = NULL;
+    }
+}
+
+void MjpegPlayDocoder::set_media(File *file, const AioMediaHead *head)
+{
+    // 视频信息（.aio容器从文件头获取 旧的.mjpeg文件固定为240*240）
+    m_pFile = file;
+    m_isContainer = NULL != head;
+    if (m_isContainer)
+    {
+        m_mediaHead = *head;
+    }
+    else
+    {
+        memset(&m_mediaHead, 0, sizeof(AioMediaHead));
+    }
+    m_width = m_isContainer ? head->width : VIDEO_WIDTH;
+    m_height = m_isContainer ? head->height : VIDEO_HEIGHT;
+    m_fileFps = m_isContainer ? head->fps : 0;
+}
+
+bool MjpegPlayDocoder::open_stream()
+{
+    // .aio容器自带帧表 旧文件有索引时直接按索引定位帧 否则边播放边生成索引
+    if (NULL != m_pFile)
+    {
+        if (m_isContainer)
+        {
+            m_index.open_table(m_pFile->name(), &m_mediaHead);
+        }
+        else if (!m_index.open(m_pFile->name(), m_pFile->size()))
+        {
+            m_index.build_begin(m_pFile->name());
+        }
+    }
+
+    uint32_t ring_size = MJPEG_RING_MAX_SIZE;
+    if (m_index.is_valid())
+    {
+        // 已知最大帧时 按流水线排队的帧数分配刚好够用的环形缓冲（整帧读入 不需要额外的余量）
+        ring_size = MJPEG_RING_MIN_SIZE;
+        while (ring_size < m_index.get_max_frame_size() * MJPEG_PIPE_FRAME_NUM &&
+               ring_size < MJPEG_RING_MAX_SIZE)
+        {
+            ring_size <<= 1;
+        }
+    }
+    // 切换视频时已有的环形缓冲够大就继续使用（更大的缓冲同样可用）
+    if (NULL != m_ringBuf && m_ringSize < ring_size)
+    {
+        g_mediaBufPool.free(m_ringBuf);
+        m_ringBuf = NULL;
+    }
+    if (NULL == m_ringBuf)
+    {
+        m_ringSize = ring_size;
+        m_ringBuf = (uint8_t *)g_mediaBufPool.alloc(m_ringSize, false);
+        if (NULL == m_ringBuf)
+        {
+            Serial.printf("MJPEG ring buffer malloc %u failed\n", m_ringSize);
+        }
+    }
+    m_ringMask = m_ringSize - 1;
+    // 切分帧时需要为下一次读取留出空间
+    m_maxFrameSize = m_index.is_valid() ? m_ringSize : m_ringSize - EACH_READ_SIZE;
+
+    // 不超过屏幕一半的视频（例如为低功耗编码的120*120）放大两倍显示
+    m_isSmall = m_width * 2 <= tft->width() && m_height * 2 <= tft->height();
+    uint16_t show_width = m_isSmall ? m_width * 2 : m_width;
+    uint16_t show_height = m_isSmall ? m_height * 2 : m_height;
+    // 小于屏幕的视频居中显示 只在开始时清一次屏（解码时只绘制视频区域）
+    m_offsetX = (tft->width() - show_width) / 2;
+    m_offsetY = (tft->height() - show_height) / 2;
+    m_outX = m_offsetX;
+    m_outY = m_offsetY;
+    if (show_width < tft->width() || show_height < tft->height())
+    {
+        tft->fillScreen(TFT_BLACK);
+    }
+    // 放大后一行MCU的高度加倍（1/2解码的MCU放大后与原高度相同）
+    m_stripMaxH = m_isSmall ? MJPEG_STRIP_MAX_HEIGHT * 2 : MJPEG_STRIP_MAX_HEIGHT;
+    update_scale();
+    if (!m_isUseDMA)
+    {
+        tft->setAddrWindow(m_offsetX, m_offsetY, show_width, show_height);
+    }
+    reset_play();
+    return NULL != m_ringBuf;
+}
+
+void MjpegPlayDocoder::reset_play()
+{
+    // 清空环形缓冲 从第一帧开始读取（调用前流水线任务必须已经停止）
+    m_ringHead = 0;
+    m_ringTail = 0;
+    m_scanPos = 0;
+    m_frameStart = 0;
+    m_isOversize = false;
+    m_readFrame = 0;
+    m_showFrame = 0;
+    m_seekFrame = -1;
+    m_isLastSkip = false;
+    m_pipeStop = false;
+    m_pipeEnd = false;
+    m_stripW = 0;
+    m_clock.start(0 == m_targetFps ? m_fileFps : m_targetFps);
+}
+
+bool MjpegPlayDocoder::alloc_dma_buf()
+{
+#if MJPEG_STRIP_DMA
+    // 两个屏幕宽度的条带缓冲（解码一行MCU的同时DMA发送上一行）
+    uint32_t size = m_stripStride * m_stripMaxH * 2;
+#else
+    uint32_t size = m_isSmall ? DMA_BUFFER_SIZE * 4 : DMA_BUFFER_SIZE;
+#endif
+    if (NULL != m_displayBufWithDma[0] && m_dmaBufSize >= size)
+    {
+        return true;
+    }
+    // 切换到需要更大缓冲的视频时 等待DMA发送完毕后重新分配
+    free_dma_buf();
+    m_displayBufWithDma[0] = (uint8_t *)g_mediaBufPool.alloc(size, true);
+    m_displayBufWithDma[1] = (uint8_t *)g_mediaBufPool.alloc(size, true);
+    m_dmaBufSize = size;
+    return NULL != m_displayBufWithDma[0] && NULL != m_displayBufWithDma[1];
+}
+
+void MjpegPlayDocoder::free_dma_buf()
+{
+    tft->dmaWait();
+    for (int i = 0; i < 2; ++i)
+    {
+        if (NULL != m_displayBufWithDma[i])
+        {
+            g_mediaBufPool.free(m_displayBufWithDma[i]);
+            m_displayBufWithDma[i] = NULL;
+        }
+    }
+    m_dmaBufSize = 0;
 }
 
 bool MjpegPlayDocoder::video_start()
 {
+    open_stream();
     if (m_isUseDMA)
     {
-        m_displayBuf = (uint8_t *)malloc(MOVIE_BUFFER_SIZE);
-        m_jpegBuf = (uint8_t *)malloc(JPEG_BUFFER_SIZE);
-        m_displayBufWithDma[0] = (uint8_t *)heap_caps_malloc(DMA_BUFFER_SIZE, MALLOC_CAP_DMA);
-        m_displayBufWithDma[1] = (uint8_t *)heap_caps_malloc(DMA_BUFFER_SIZE, MALLOC_CAP_DMA);
+        alloc_dma_buf();
         tft->initDMA();
         // 使用DMA
         // DMADrawer::setup(MOVIE_BUFFER_SIZE, SPI_FREQUENCY, TFT_MOSI, TFT_MISO, TFT_SCLK, TFT_CS, TFT_DC);
-    }
-    else
-    {
-        m_displayBuf = (uint8_t *)malloc(MOVIE_BUFFER_SIZE);
-        tft->setAddrWindow((tft->width() - VIDEO_WIDTH) / 2,
-                           (tft->height() - VIDEO_HEIGHT) / 2,
-                           VIDEO_WIDTH, VIDEO_HEIGHT);
+        // 流水线任务在第一次播放时才启动 以便播放前的跳转（续播）直接生效
     }
     return true;
 
@@ -180,20 +470,56 @@ bool MjpegPlayDocoder::video_start()
 
 bool MjpegPlayDocoder::video_play_screen(void)
 {
-    // Read video
-    uint32_t l = 0;
+    if (NULL == m_ringBuf)
+    {
+        return false;
+    }
+
+    if (m_isPipeline && NULL == m_readTask)
+    {
+        if (!pipeline_start())
+        {
+            // 内存不足等原因创建失败 退回到单线程播放
+            Serial.println(F("MJPEG pipeline start failed, fallback to serial play"));
+            pipeline_end();
+            m_isPipeline = false;
+        }
+    }
+
+    if (m_isPipeline)
+    {
+        // 读卡与解码都在后台任务中进行 这里只等待一帧显示完毕
+        // 使调用者（loop）的节奏与播放帧率保持一致，并能及时响应按键
+        xSemaphoreTake(m_frameDoneSem, MJPEG_PIPE_WAIT_TICKS);
+        return true;
+    }
 
     if (m_isUseDMA)
     {
         // 一帧数据大概3000B 240M主频时花费50ms  80M时需要150ms
         // unsigned long Millis_1 = GET_SYS_MILLIS(); // 更新的时间
-        uint32_t jpg_size = readJpegFromFile(m_pFile);
-        // Serial.println(jpg_size);
-        // Serial.print(GET_SYS_MILLIS() - Millis_1);
-        // Serial.print(" ");
-        // Millis_1 = GET_SYS_MILLIS();
-        // Draw the image, top left at 0,0 - DMA request is handled in the call-back tft_output() in this sketch
-        TJpgDec.drawJpg(0, 0, m_jpegBuf, jpg_size);
+        MjpegFrameSpan span;
+        span.is_decode = false;
+        while (read_frame(&span))
+        {
+            // Draw the image, top left at 0,0 - DMA request is handled in the call-back tft_output() in this sketch
+            if (span.is_decode)
+            {
+                bool isShow = present_frame(&span);
+                release_frame(&span);
+                if (isShow)
+                {
+                    fps_statistics();
+                }
+                break;
+            }
+            // 被丢弃的超大帧 释放空间后继续读取下一帧
+            release_frame(&span);
+        }
+        if (!span.is_decode)
+        {
+            m_pipeEnd = true;
+        }
         // Serial.println(GET_SYS_MILLIS() - Millis_1);
     }
     else
@@ -204,19 +530,15 @@ bool MjpegPlayDocoder::video_play_screen(void)
 
 bool MjpegPlayDocoder::video_end(void)
 {
+    // 先停止流水线任务 再释放任务中使用的资源
+    pipeline_end();
+    // 未完整播放时生成的索引不完整 关闭时会丢弃
+    m_index.close();
     m_pFile = NULL;
     // 结束播放 释放资源
-    if (NULL != m_displayBufWithDma[0])
-    {
-        free(m_displayBufWithDma[0]);
-        free(m_displayBufWithDma[1]);
-        m_displayBufWithDma[0] = NULL;
-        m_displayBufWithDma[1] = NULL;
-    }
-    if (NULL != m_jpegBuf)
+    if (NULL != m_displayBufWithDma[0] || NULL != m_displayBufWithDma[1])
     {
-        free(m_jpegBuf);
-        m_jpegBuf = NULL;
+        free_dma_buf();
     }
     // 需要添加wait 不然强行释放dma 会导致下一次initDMA失败
     // tft->dmaWait();
@@ -229,11 +551,477 @@ bool MjpegPlayDocoder::video_end(void)
     //                  TFT_SCLK, TFT_CS,
     //                  TFT_DC);
     // DMADrawer::close();
-    if (NULL != m_displayBuf)
+    if (NULL != m_ringBuf)
+    {
+        g_mediaBufPool.free(m_ringBuf);
+        m_ringBuf = NULL;
+    }
+
+    return true;
+}
+
+bool MjpegPlayDocoder::video_is_end(void)
+{
+    // 文件读完且环形缓冲中已没有可解码的帧
+    return NULL == m_pFile || m_pipeEnd;
+}
+
+bool MjpegPlayDocoder::video_seek(uint32_t frame)
+{
+    // 没有索引时无法定位帧的位置
+    if (!m_index.is_valid() || frame >= m_index.get_frame_num())
+    {
+        return false;
+    }
+    // 由读取帧的一方（流水线模式下为读卡任务）在下次读取时执行
+    m_seekFrame = frame;
+    m_pipeEnd = false;
+    return true;
+}
+
+bool MjpegPlayDocoder::video_rewind(void)
+{
+    // 从第一帧重新播放（循环） 缓冲、文件与解码器的表缓存都继续使用
+    if (NULL == m_pFile || NULL == m_ringBuf)
+    {
+        return false;
+    }
+    // 流水线任务在下次播放时重新启动
+    pipeline_end();
+    if (m_index.is_building())
+    {
+        // 没有播放完就回到开头 重新生成索引
+        m_index.close();
+        m_index.build_begin(m_pFile->name());
+    }
+    else if (!m_index.is_valid())
+    {
+        // 第一遍播放完时已经生成了索引 之后按索引读取帧
+        m_index.open(m_pFile->name(), m_pFile->size());
+    }
+    if (!m_index.is_valid())
+    {
+        m_pFile->seek(0);
+    }
+    reset_play();
+    return true;
+}
+
+bool MjpegPlayDocoder::video_switch(File *file, const AioMediaHead *head)
+{
+    // 切换到另一个视频 不重新创建解码对象 缓冲够用时直接复用
+    if (NULL == file)
+    {
+        return false;
+    }
+    pipeline_end();
+    m_index.close();
+    set_media(file, head);
+    bool isOk = open_stream();
+    if (m_isUseDMA)
+    {
+        isOk = alloc_dma_buf() && isOk;
+    }
+    return isOk;
+}
+
+uint32_t MjpegPlayDocoder::video_get_frame(void)
+{
+    return m_showFrame;
+}
+
+void MjpegPlayDocoder::video_set_fps(uint8_t fps)
+{
+    // 0表示按文件中记录的帧率播放（旧文件没有记录帧率 即不控制速度）
+    m_targetFps = fps;
+    m_clock.set_fps(0 == fps ? m_fileFps : fps);
+}
+
+uint32_t MjpegPlayDocoder::ring_fill(uint32_t len)
+{
+    // 从文件读取len字节写入环形缓冲（调用前需确保空间足够 跨越缓冲尾部时分两次读取）
+    uint32_t total = 0;
+    while (total < len)
     {
-        free(m_displayBuf);
-        m_displayBuf = NULL;
+        uint32_t idx = m_ringHead & m_ringMask;
+        uint32_t part = len - total;
+        if (part > m_ringSize - idx)
+        {
+            part = m_ringSize - idx;
+        }
+        int32_t read_size = m_pFile->read(&m_ringBuf[idx], part);
+        if (read_size <= 0)
+        {
+            break;
+        }
+        m_ringHead += read_size;
+        total += read_size;
     }
+    m_readBytes += total;
+    return total;
+}
 
+bool MjpegPlayDocoder::ring_wait_space(uint32_t len)
+{
+    // 单线程播放时帧解码后立即释放 空间一定足够
+    // 流水线模式下需要等待解码任务释放已解码的帧
+    while (m_ringSize - (m_ringHead - m_ringTail) < len)
+    {
+        if (NULL == m_spaceSem || m_pipeStop)
+        {
+            return false;
+        }
+        xSemaphoreTake(m_spaceSem, MJPEG_PIPE_WAIT_TICKS);
+    }
     return true;
-}
\ No newline at end of file
+}
+
+bool MjpegPlayDocoder::find_eoi(uint32_t *eoi)
+{
+    return mjpeg_find_eoi(m_ringBuf, m_ringMask, &m_scanPos, m_ringHead, eoi);
+}
+
+bool MjpegPlayDocoder::split_frame(MjpegFrameSpan *span)
+{
+    // 没有索引时 在环形缓冲中查找0xFFD9切分出一帧
+    uint32_t eoi = 0;
+    while (true)
+    {
+        unsigned long scan_start = micros();
+        bool isFound = find_eoi(&eoi);
+        m_scanMicros += micros() - scan_start;
+        if (isFound)
+        {
+            break;
+        }
+        if (m_ringHead - m_frameStart >= m_maxFrameSize)
+        {
+            // 帧太大 丢弃已读到的部分（交给解码方按顺序释放）直到该帧结束
+            if (!m_isOversize)
+            {
+                m_isOversize = true;
+                m_oversizeStart = m_frameStart;
+            }
+            span->start = m_frameStart;
+            span->size = m_ringHead - m_frameStart;
+            span->frame_no = m_readFrame;
+            span->is_decode = false;
+            m_frameStart = m_ringHead;
+            return true;
+        }
+        if (!ring_wait_space(EACH_READ_SIZE) || 0 == ring_fill(EACH_READ_SIZE))
+        {
+            // 文件已读完 且剩余数据中没有完整的一帧
+            m_index.build_end(m_pFile->size(), !m_pipeStop);
+            return false;
+        }
+    }
+
+    uint32_t frame_start = m_isOversize ? m_oversizeStart : m_frameStart;
+    // 帧的位置即文件中的位置（无索引时从文件头顺序读取 不会跳转）
+    m_index.build_append(frame_start, eoi + 2 - frame_start);
+    span->start = m_frameStart;
+    span->size = eoi + 2 - m_frameStart;
+    span->frame_no = m_readFrame++;
+    span->is_decode = !m_isOversize;
+    if (m_isOversize)
+    {
+        m_isOversize = false;
+        ++m_dropCount;
+    }
+    m_frameStart = eoi + 2;
+    return true;
+}
+
+bool MjpegPlayDocoder::read_frame(MjpegFrameSpan *span)
+{
+    if (!m_index.is_valid())
+    {
+        return split_frame(span);
+    }
+
+    MjpegFrameEntry entry;
+    while (true)
+    {
+        if (m_seekFrame >= 0)
+        {
+            m_readFrame = m_seekFrame;
+            m_seekFrame = -1;
+            m_clock.start(m_clock.get_fps(), m_readFrame);
+        }
+        else if (m_clock.get_fps() > 0)
+        {
+            // 按播放时钟计算此刻应显示的帧 落后超过一帧时直接跳过中间的帧（不读取）
+            uint32_t expect = m_clock.get_frame();
+            if (expect > m_readFrame + 1 && expect < m_index.get_frame_num())
+            {
+                m_dropCount += expect - m_readFrame;
+                m_readFrame = expect;
+            }
+        }
+
+        if (!m_index.get_frame(m_readFrame, &entry))
+        {
+            return false;
+        }
+        if (entry.size <= m_maxFrameSize)
+        {
+            break;
+        }
+        // 帧太大 直接跳过
+        ++m_readFrame;
+        ++m_dropCount;
+    }
+
+    // 有索引时整帧读入环形缓冲（可能跨越缓冲尾部 由解码器分两段读取）
+    if (!ring_wait_space(entry.size))
+    {
+        return false;
+    }
+    if (m_pFile->position() != entry.offset)
+    {
+        m_pFile->seek(entry.offset);
+    }
+    m_frameStart = m_ringHead;
+    span->start = m_frameStart;
+    span->size = ring_fill(entry.size);
+    span->frame_no = m_readFrame++;
+    span->is_decode = span->size == entry.size;
+    m_frameStart = m_ringHead;
+    m_scanPos = m_ringHead;
+    return true;
+}
+
+bool MjpegPlayDocoder::present_frame(const MjpegFrameSpan *span)
+{
+    // 落后于播放时钟时跳过本帧的解码（不连续跳过 保证画面仍在更新）
+    // 超前时休眠到本帧的显示时间 播放速度与CPU主频无关
+    if (!m_isLastSkip && m_clock.is_late(span->frame_no))
+    {
+        m_isLastSkip = true;
+        ++m_dropCount;
+        return false;
+    }
+    m_isLastSkip = false;
+    m_clock.wait(span->frame_no);
+    draw_frame(span);
+    return true;
+}
+
+void MjpegPlayDocoder::draw_frame(const MjpegFrameSpan *span)
+{
+    // 帧跨越缓冲尾部时分为两段交给解码器
+    uint32_t idx = span->start & m_ringMask;
+    uint32_t first = span->size;
+    if (first > m_ringSize - idx)
+    {
+        first = m_ringSize - idx;
+    }
+    unsigned long draw_start = micros();
+    m_stripW = 0;
+    // 低功耗模式只在帧之间切换（由解码帧的任务执行 不会改变正在解码的帧）
+    update_scale();
+    // 偏移在 tft_output 中加上（放大显示时偏移不随解码坐标放大）
+    TJpgDec.drawJpg(0, 0, &m_ringBuf[idx], first, m_ringBuf, span->size - first);
+    if (m_isUseDMA)
+    {
+        strip_flush();
+    }
+    m_drawMicros += micros() - draw_start;
+    m_headerMicros += TJpgDec.prepareMicros;
+    m_headerBytes += TJpgDec.headerBytes;
+    m_tableSegs += TJpgDec.tableSegs;
+    m_tableHits += TJpgDec.tableHits;
+    m_showFrame = span->frame_no;
+}
+
+void MjpegPlayDocoder::update_scale(void)
+{
+    // 小视频原尺寸解码后放大 低功耗时大视频以1/2解码后放大（显示区域不变）
+    m_jpgScale = (m_isLowPower && !m_isSmall) ? 2 : 1;
+    m_zoomShift = (m_isSmall || 2 == m_jpgScale) ? 1 : 0;
+    TJpgDec.setJpgScale(m_jpgScale);
+}
+
+void MjpegPlayDocoder::video_set_low_power(bool isLowPower)
+{
+    // 只记录请求 下一帧开始解码时生效
+    m_isLowPower = isLowPower;
+}
+
+void MjpegPlayDocoder::release_frame(const MjpegFrameSpan *span)
+{
+    // 帧按顺序解码 释放到该帧末尾即可
+    m_ringTail = span->start + span->size;
+    if (NULL != m_spaceSem)
+    {
+        xSemaphoreGive(m_spaceSem);
+    }
+}
+
+void MjpegPlayDocoder::fps_statistics(void)
+{
+    // 每 MJPEG_FPS_REPORT_FRAMES 帧打印一次平均帧率 用于对比不同播放方式的性能
+    if (++m_frameCount < MJPEG_FPS_REPORT_FRAMES)
+    {
+        return;
+    }
+    unsigned long cost = GET_SYS_MILLIS() - m_fpsStartMillis;
+    if (cost > 0)
+    {
+        Serial.printf("MJPEG %s %uMHz %s: %.2f fps (dropped %u) scan %u us/frame read %u B/frame "
+                      "draw %u us/frame %u dma/frame header %u us %u B/frame tables %u/%u reused\n",
+                      m_isPipeline ? "pipeline" : "serial",
+                      getCpuFrequencyMhz(),
+                      2 == m_jpgScale ? "half" : (m_isSmall ? "zoom" : "full"),
+                      m_frameCount * 1000.0 / cost,
+                      m_dropCount,
+                      m_scanMicros / m_frameCount,
+                      m_readBytes / m_frameCount,
+                      m_drawMicros / m_frameCount,
+                      m_pushCount / m_frameCount,
+                      m_headerMicros / m_frameCount,
+                      m_headerBytes / m_frameCount,
+                      m_tableHits, m_tableSegs);
+    }
+    m_frameCount = 0;
+    m_scanMicros = 0;
+    m_readBytes = 0;
+    m_drawMicros = 0;
+    m_headerMicros = 0;
+    m_headerBytes = 0;
+    m_tableSegs = 0;
+    m_tableHits = 0;
+    m_pushCount = 0;
+    m_fpsStartMillis = GET_SYS_MILLIS();
+}
+
+bool MjpegPlayDocoder::pipeline_start(void)
+{
+    m_frameQueue = xQueueCreate(MJPEG_PIPE_FRAME_NUM, sizeof(MjpegFrameSpan));
+    m_spaceSem = xSemaphoreCreateBinary();
+    m_frameDoneSem = xSemaphoreCreateBinary();
+    m_taskExitSem = xSemaphoreCreateCounting(2, 0);
+    if (NULL == m_frameQueue || NULL == m_spaceSem ||
+        NULL == m_frameDoneSem || NULL == m_taskExitSem)
+    {
+        return false;
+    }
+
+    m_pipeStop = false;
+    m_pipeEnd = false;
+    if (pdPASS != xTaskCreatePinnedToCore(read_task, "MjpegRead", 4 * 1024, this,
+                                          MJPEG_READ_TASK_PRIORITY, &m_readTask,
+                                          MJPEG_READ_TASK_CORE))
+    {
+        m_readTask = NULL;
+        return false;
+    }
+    if (pdPASS != xTaskCreatePinnedToCore(decode_task, "MjpegDecode", 6 * 1024, this,
+                                          MJPEG_DECODE_TASK_PRIORITY, &m_decodeTask,
+                                          MJPEG_DECODE_TASK_CORE))
+    {
+        m_decodeTask = NULL;
+        return false;
+    }
+    return true;
+}
+
+void MjpegPlayDocoder::pipeline_end(void)
+{
+    // 通知任务退出 并等待它们真正结束（任务阻塞等待均有超时，会检查退出标志）
+    m_pipeStop = true;
+    if (NULL != m_readTask)
+    {
+        xSemaphoreTake(m_taskExitSem, portMAX_DELAY);
+        m_readTask = NULL;
+    }
+    if (NULL != m_decodeTask)
+    {
+        xSemaphoreTake(m_taskExitSem, portMAX_DELAY);
+        m_decodeTask = NULL;
+    }
+    // 等待最后一次DMA传输完成 避免解码缓冲被释放时仍在传输
+    if (m_isUseDMA)
+    {
+        tft->dmaWait();
+    }
+
+    if (NULL != m_frameQueue)
+    {
+        vQueueDelete(m_frameQueue);
+        m_frameQueue = NULL;
+    }
+    if (NULL != m_spaceSem)
+    {
+        vSemaphoreDelete(m_spaceSem);
+        m_spaceSem = NULL;
+    }
+    if (NULL != m_frameDoneSem)
+    {
+        vSemaphoreDelete(m_frameDoneSem);
+        m_frameDoneSem = NULL;
+    }
+    if (NULL != m_taskExitSem)
+    {
+        vSemaphoreDelete(m_taskExitSem);
+        m_taskExitSem = NULL;
+    }
+}
+
+void MjpegPlayDocoder::read_task(void *parameter)
+{
+    // 生产者：从SD卡读取数据到环形缓冲并切分出完整的jpeg帧
+    MjpegPlayDocoder *decoder = (MjpegPlayDocoder *)parameter;
+    MjpegFrameSpan span;
+    while (!decoder->m_pipeStop)
+    {
+        bool isFrame = decoder->read_frame(&span);
+        if (!isFrame)
+        {
+            // size为0表示文件结束 同样送给解码任务作为结束标志
+            span.start = decoder->m_ringHead;
+            span.size = 0;
+            span.is_decode = false;
+        }
+        while (!decoder->m_pipeStop &&
+               pdTRUE != xQueueSend(decoder->m_frameQueue, &span, MJPEG_PIPE_WAIT_TICKS))
+        {
+        }
+        if (!isFrame)
+        {
+            break;
+        }
+    }
+    xSemaphoreGive(decoder->m_taskExitSem);
+    vTaskDelete(NULL);
+}
+
+void MjpegPlayDocoder::decode_task(void *parameter)
+{
+    // 消费者：直接从环形缓冲中解码jpeg并通过DMA推送到屏幕
+    MjpegPlayDocoder *decoder = (MjpegPlayDocoder *)parameter;
+    MjpegFrameSpan span;
+    while (!decoder->m_pipeStop)
+    {
+        if (pdTRUE != xQueueReceive(decoder->m_frameQueue, &span, MJPEG_PIPE_WAIT_TICKS))
+        {
+            continue;
+        }
+        if (0 == span.size)
+        {
+            decoder->m_pipeEnd = true;
+            xSemaphoreGive(decoder->m_frameDoneSem);
+            break;
+        }
+        bool isShow = span.is_decode && decoder->present_frame(&span);
+        decoder->release_frame(&span);
+        if (isShow)
+        {
+            decoder->fps_statistics();
+            xSemaphoreGive(decoder->m_frameDoneSem);
+        }
+    }
+    xSemaphoreGive(decoder->m_taskExitSem);
+    vTaskDelete(NULL);
+}
@@ -0,0 +1,257 @@
+#include "mjpeg_index.h"
+#include "common.h"
+
+#define INDEX_SCAN_READ_SIZE 2500 // 生成索引时每次读取的数据大小
+
+MjpegIndex::MjpegIndex()
+{
+    memset(&m_head, 0, sizeof(MjpegIndexHead));
+    m_isValid = false;
+    m_isBuilding = false;
+    m_cacheStart = 0;
+    m_cacheNum = 0;
+    m_tableOffset = sizeof(MjpegIndexHead);
+    m_idxPath[0] = 0;
+}
+
+MjpegIndex::~MjpegIndex()
+{
+    close();
+}
+
+void MjpegIndex::get_index_path(char *idx_path, const char *video_path)
+{
+    // 将视频的后缀替换为 .idx （没有后缀时直接追加）
+    snprintf(idx_path, FILENAME_MAX_LEN, "%s", video_path);
+    char *dot = strrchr(idx_path, '.');
+    char *slash = strrchr(idx_path, '/');
+    if (NULL == dot || (NULL != slash && dot < slash))
+    {
+        dot = idx_path + strlen(idx_path);
+    }
+    snprintf(dot, FILENAME_MAX_LEN - (dot - idx_path), "%s", MJPEG_INDEX_SUFFIX);
+}
+
+bool MjpegIndex::build(const char *video_path)
+{
+    File video = tf.open(video_path);
+    if (!video)
+    {
+        return false;
+    }
+    uint8_t *buf = (uint8_t *)malloc(INDEX_SCAN_READ_SIZE);
+    if (NULL == buf)
+    {
+        video.close();
+        return false;
+    }
+
+    MjpegIndex index;
+    if (!index.build_begin(video_path))
+    {
+        free(buf);
+        video.close();
+        return false;
+    }
+
+    // 逐块扫描 0xFFD9 结束标志（记录上一块的最后一个字节以处理跨块的标志）
+    uint32_t pos = 0;         // 当前块在文件中的起始位置
+    uint32_t frame_start = 0; // 当前帧的起始位置
+    uint8_t pre_byte = 0;
+    int32_t read_size = 0;
+    while ((read_size = video.read(buf, INDEX_SCAN_READ_SIZE)) > 0)
+    {
+        for (int32_t i = 0; i < read_size; ++i)
+        {
+            if (0xFF == pre_byte && 0xD9 == buf[i])
+            {
+                uint32_t frame_end = pos + i + 1;
+                index.build_append(frame_start, frame_end - frame_start);
+                frame_start = frame_end;
+                pre_byte = 0;
+                continue;
+            }
+            pre_byte = buf[i];
+        }
+        pos += read_size;
+    }
+    index.build_end(video.size(), true);
+
+    free(buf);
+    video.close();
+    Serial.printf("MJPEG index built: %s\n", video_path);
+    return true;
+}
+
+bool MjpegIndex::open(const char *video_path, uint32_t video_size)
+{
+    close();
+    get_index_path(m_idxPath, video_path);
+    if (!SD.exists(m_idxPath))
+    {
+        return false;
+    }
+    m_idxFile = tf.open(m_idxPath);
+    if (!m_idxFile)
+    {
+        return false;
+    }
+    if (sizeof(MjpegIndexHead) != m_idxFile.read((uint8_t *)&m_head, sizeof(MjpegIndexHead)) ||
+        MJPEG_INDEX_MAGIC != m_head.magic ||
+        MJPEG_INDEX_VERSION != m_head.version ||
+        video_size != m_head.video_size ||
+        m_idxFile.size() < sizeof(MjpegIndexHead) + m_head.frame_num * sizeof(MjpegFrameEntry))
+    {
+        // 索引已损坏或者已过期
+        Serial.printf("MJPEG index invalid: %s\n", m_idxPath);
+        m_idxFile.close();
+        return false;
+    }
+    m_tableOffset = sizeof(MjpegIndexHead);
+    m_cacheStart = 0;
+    m_cacheNum = 0;
+    m_isValid = true;
+    return true;
+}
+
+bool MjpegIndex::open_table(const char *video_path, const AioMediaHead *head)
+{
+    close();
+    // 另外打开一个文件句柄读取帧表 不影响视频数据的读取位置
+    m_idxFile = tf.open(video_path);
+    if (!m_idxFile)
+    {
+        return false;
+    }
+    memset(&m_head, 0, sizeof(MjpegIndexHead));
+    m_head.magic = MJPEG_INDEX_MAGIC;
+    m_head.version = MJPEG_INDEX_VERSION;
+    m_head.video_size = m_idxFile.size();
+    m_head.frame_num = head->frame_num;
+    m_head.max_frame_size = head->max_frame_size;
+    m_tableOffset = head->table_offset;
+    m_cacheStart = 0;
+    m_cacheNum = 0;
+    m_isValid = true;
+    return true;
+}
+
+void MjpegIndex::close()
+{
+    if (m_isBuilding)
+    {
+        // 未完成的索引直接丢弃
+        build_end(0, false);
+    }
+    if (m_idxFile)
+    {
+        m_idxFile.close();
+    }
+    m_isValid = false;
+    m_cacheStart = 0;
+    m_cacheNum = 0;
+}
+
+bool MjpegIndex::get_frame(uint32_t frame, MjpegFrameEntry *entry)
+{
+    if (!m_isValid || frame >= m_head.frame_num)
+    {
+        return false;
+    }
+    if (frame < m_cacheStart || frame >= m_cacheStart + m_cacheNum)
+    {
+        // 未命中缓存 一次读取连续的 MJPEG_INDEX_CACHE_NUM 条
+        uint32_t num = m_head.frame_num - frame;
+        if (num > MJPEG_INDEX_CACHE_NUM)
+        {
+            num = MJPEG_INDEX_CACHE_NUM;
+        }
+        m_idxFile.seek(m_tableOffset + frame * sizeof(MjpegFrameEntry));
+        int32_t len = m_idxFile.read((uint8_t *)m_cache, num * sizeof(MjpegFrameEntry));
+        if (len < (int32_t)sizeof(MjpegFrameEntry))
+        {
+            m_cacheNum = 0;
+            return false;
+        }
+        m_cacheStart = frame;
+        m_cacheNum = len / sizeof(MjpegFrameEntry);
+    }
+    *entry = m_cache[frame - m_cacheStart];
+    return true;
+}
+
+bool MjpegIndex::build_begin(const char *video_path)
+{
+    close();
+    get_index_path(m_idxPath, video_path);
+    if (SD.exists(m_idxPath))
+    {
+        tf.deleteFile(m_idxPath);
+    }
+    m_idxFile = tf.open(m_idxPath, FILE_WRITE);
+    if (!m_idxFile)
+    {
+        return false;
+    }
+    // 先写入一个无效的头 生成完毕后再回写
+    memset(&m_head, 0, sizeof(MjpegIndexHead));
+    m_idxFile.write((uint8_t *)&m_head, sizeof(MjpegIndexHead));
+    m_cacheStart = 0;
+    m_cacheNum = 0;
+    m_isBuilding = true;
+    return true;
+}
+
+void MjpegIndex::build_append(uint32_t offset, uint32_t size)
+{
+    if (!m_isBuilding)
+    {
+        return;
+    }
+    m_cache[m_cacheNum].offset = offset;
+    m_cache[m_cacheNum].size = size;
+    ++m_cacheNum;
+    ++m_head.frame_num;
+    if (size > m_head.max_frame_size)
+    {
+        m_head.max_frame_size = size;
+    }
+    if (MJPEG_INDEX_CACHE_NUM == m_cacheNum)
+    {
+        build_flush();
+    }
+}
+
+void MjpegIndex::build_flush()
+{
+    if (m_cacheNum > 0)
+    {
+        m_idxFile.write((uint8_t *)m_cache, m_cacheNum * sizeof(MjpegFrameEntry));
+        m_cacheStart += m_cacheNum;
+        m_cacheNum = 0;
+    }
+}
+
+void MjpegIndex::build_end(uint32_t video_size, bool isComplete)
+{
+    if (!m_isBuilding)
+    {
+        return;
+    }
+    m_isBuilding = false;
+    if (!isComplete || 0 == m_head.frame_num)
+    {
+        m_idxFile.close();
+        tf.deleteFile(m_idxPath);
+        return;
+    }
+    build_flush();
+    m_head.magic = MJPEG_INDEX_MAGIC;
+    m_head.version = MJPEG_INDEX_VERSION;
+    m_head.video_size = video_size;
+    m_idxFile.seek(0);
+    m_idxFile.write((uint8_t *)&m_head, sizeof(MjpegIndexHead));
+    m_idxFile.close();
+    m_cacheStart = 0;
+    m_cacheNum = 0;
+}
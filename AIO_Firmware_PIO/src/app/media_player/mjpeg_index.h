@@ -0,0 +1,69 @@
+#ifndef MJPEG_INDEX_H
+#define MJPEG_INDEX_H
+
+#include <SD.h>
+#include "driver/sd_card.h"
+#include "aio_media.h"
+
+// mjpeg 帧索引文件（与视频同目录同名 后缀为.idx 例如 /movie/a.mjpeg -> /movie/a.idx）
+// 文件结构：MjpegIndexHead + frame_num 个 MjpegFrameEntry
+#define MJPEG_INDEX_MAGIC 0x5844494D // "MIDX"
+#define MJPEG_INDEX_VERSION 1
+#define MJPEG_INDEX_SUFFIX ".idx"
+#define MJPEG_INDEX_CACHE_NUM 32 // 内存中缓存的索引条目数（每条8字节）
+
+struct MjpegIndexHead
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t video_size;     // 对应视频文件的大小（用于判断索引是否过期）
+    uint32_t frame_num;      // 总帧数
+    uint32_t max_frame_size; // 最大的一帧的大小
+};
+
+struct MjpegFrameEntry
+{
+    uint32_t offset; // 帧在视频文件中的起始位置
+    uint32_t size;   // 帧大小（包含结尾的0xFFD9）
+};
+
+class MjpegIndex
+{
+private:
+    File m_idxFile;
+    MjpegIndexHead m_head;
+    bool m_isValid;    // 索引已加载且可用
+    bool m_isBuilding; // 正在生成索引
+    MjpegFrameEntry m_cache[MJPEG_INDEX_CACHE_NUM];
+    uint32_t m_cacheStart; // 缓存中第一条对应的帧号（生成时为已写入的条目数）
+    uint32_t m_cacheNum;   // 缓存中的有效条目数
+    uint32_t m_tableOffset; // 第一条索引在文件中的位置
+    char m_idxPath[FILENAME_MAX_LEN];
+
+public:
+    MjpegIndex();
+    ~MjpegIndex();
+    static void get_index_path(char *idx_path, const char *video_path);
+    // 扫描整个视频文件生成索引（用于上传完成时）
+    static bool build(const char *video_path);
+    // 加载索引 索引不存在或者与视频大小不一致时返回false
+    bool open(const char *video_path, uint32_t video_size);
+    // 使用.aio容器中自带的帧表（不需要索引文件）
+    bool open_table(const char *video_path, const AioMediaHead *head);
+    void close();
+    bool is_valid() { return m_isValid; }
+    uint32_t get_frame_num() { return m_isValid ? m_head.frame_num : 0; }
+    uint32_t get_max_frame_size() { return m_isValid ? m_head.max_frame_size : 0; }
+    bool get_frame(uint32_t frame, MjpegFrameEntry *entry);
+
+    // 边播放边生成索引（首次播放时使用）
+    bool build_begin(const char *video_path);
+    void build_append(uint32_t offset, uint32_t size);
+    void build_end(uint32_t video_size, bool isComplete);
+    bool is_building() { return m_isBuilding; }
+
+private:
+    void build_flush();
+};
+
+#endif
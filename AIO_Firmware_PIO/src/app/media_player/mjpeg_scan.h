@@ -0,0 +1,44 @@
+#ifndef MJPEG_SCAN_H
+#define MJPEG_SCAN_H
+
+#include <stdint.h>
+#include <string.h>
+
+// 在环形缓冲 ring（大小为 mask+1 的2的幂）的 [*scan_pos, head) 中查找jpeg结束标志0xFFD9
+// 找到时 *eoi 为0xFF所在的位置 返回true；*scan_pos 更新为下次继续查找的位置
+// 不依赖Arduino 主机上的性能测试（tools/jpeg_bench）也使用这份代码
+static inline bool mjpeg_find_eoi(const uint8_t *ring, uint32_t mask, uint32_t *scan_pos,
+                                  uint32_t head, uint32_t *eoi)
+{
+    // 以memchr查找0xFF 再检查下一字节是否为0xD9（比逐字节比较快得多）
+    uint32_t size = mask + 1;
+    uint32_t scan = *scan_pos;
+    while (scan + 1 < head)
+    {
+        uint32_t idx = scan & mask;
+        // 0xFF之后必须还有一个字节 且查找不能跨越缓冲尾部
+        uint32_t len = head - 1 - scan;
+        if (len > size - idx)
+        {
+            len = size - idx;
+        }
+        const uint8_t *p = (const uint8_t *)memchr(&ring[idx], 0xFF, len);
+        if (NULL == p)
+        {
+            scan += len;
+            continue;
+        }
+        uint32_t pos = scan + (p - &ring[idx]);
+        if (0xD9 == ring[(pos + 1) & mask])
+        {
+            *eoi = pos;
+            *scan_pos = pos + 2;
+            return true;
+        }
+        scan = pos + 1;
+    }
+    *scan_pos = scan;
+    return false;
+}
+
+#endif
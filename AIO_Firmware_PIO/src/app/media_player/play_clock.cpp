@@ -0,0 +1,84 @@
+#include "play_clock.h"
+#include "esp_timer.h"
+
+PlayClock::PlayClock()
+{
+    start(0, 0);
+}
+
+void PlayClock::start(uint8_t fps, uint32_t frame)
+{
+    // 起点在第一次查询时才确定 避免打开文件、预读等耗时被算作落后
+    m_fps = fps;
+    m_startMicros = -1;
+    m_startFrame = frame;
+}
+
+void PlayClock::anchor()
+{
+    if (m_startMicros < 0)
+    {
+        m_startMicros = esp_timer_get_time();
+    }
+}
+
+void PlayClock::set_fps(uint8_t fps)
+{
+    if (fps == m_fps)
+    {
+        return;
+    }
+    start(fps, 0 == m_fps ? m_startFrame : get_frame());
+}
+
+uint32_t PlayClock::get_frame()
+{
+    if (0 == m_fps)
+    {
+        return m_startFrame;
+    }
+    anchor();
+    return m_startFrame + (esp_timer_get_time() - m_startMicros) * m_fps / 1000000;
+}
+
+int32_t PlayClock::get_late_ms(uint32_t frame)
+{
+    if (0 == m_fps)
+    {
+        return 0;
+    }
+    if (m_startMicros < 0)
+    {
+        // 以第一次显示的帧作为起点
+        m_startFrame = frame;
+        anchor();
+    }
+    int64_t pts = m_startMicros + ((int64_t)frame - m_startFrame) * 1000000 / m_fps;
+    return (esp_timer_get_time() - pts) / 1000;
+}
+
+bool PlayClock::is_late(uint32_t frame)
+{
+    if (0 == m_fps)
+    {
+        return false;
+    }
+    int32_t late_ms = get_late_ms(frame);
+    if (late_ms > PLAY_CLOCK_MAX_LATE_MS)
+    {
+        // 落后太多（例如SD卡读取跟不上） 以当前帧重新对齐时钟
+        start(m_fps, frame);
+        return false;
+    }
+    return late_ms > 1000 / m_fps;
+}
+
+void PlayClock::wait(uint32_t frame)
+{
+    int32_t late_ms = get_late_ms(frame);
+    if (late_ms < 0)
+    {
+        // 超前 休眠让出CPU（空闲时可以降低功耗）
+        vTaskDelay(-late_ms / portTICK_PERIOD_MS);
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef PLAY_CLOCK_H
+#define PLAY_CLOCK_H
+
+#include <Arduino.h>
+
+#define PLAY_CLOCK_MAX_LATE_MS 500 // 落后超过此时间则重新对齐时钟（避免一直追帧）
+
+// 视频播放时钟：根据帧率计算每一帧的显示时间（PTS）
+// 使用 esp_timer 的微秒计时 不受 setCpuFrequencyMhz 切换主频的影响
+class PlayClock
+{
+private:
+    uint8_t m_fps;           // 播放帧率（0表示不控制速度）
+    int64_t m_startMicros;   // 时钟起点
+    uint32_t m_startFrame;   // 时钟起点对应的帧号
+
+public:
+    PlayClock();
+    void start(uint8_t fps, uint32_t frame = 0); // 从第frame帧开始计时
+    void set_fps(uint8_t fps);                   // 更改帧率（从当前帧重新计时）
+    uint8_t get_fps() { return m_fps; }
+    uint32_t get_frame();                        // 此刻应显示的帧号
+    int32_t get_late_ms(uint32_t frame);         // frame 落后显示时间的毫秒数（负数表示超前）
+    bool is_late(uint32_t frame);                // frame 已经落后超过一帧的时间
+    void wait(uint32_t frame);                   // 超前时休眠到 frame 的显示时间
+
+private:
+    void anchor();
+};
+
+#endif
@@ -0,0 +1,126 @@
+#include "prefetch_file.h"
+#include "common.h"
+#include "media_buffer_pool.h"
+
+#define PREFETCH_FILE_MIN_SIZE 2048 // 内存不足时预读的最小值（再小就不预读）
+
+File prefetch_file_open(const char *path, uint32_t prefetch_size)
+{
+    File file = tf.open(path);
+    if (!file)
+    {
+        return file;
+    }
+    return File(std::make_shared<PrefetchFileImpl>(file, prefetch_size));
+}
+
+PrefetchFileImpl::PrefetchFileImpl(File file, uint32_t prefetch_size)
+{
+    m_file = file;
+    m_buf = NULL;
+    m_bufLen = 0;
+    m_pos = 0;
+    m_size = m_file.size();
+
+    if (prefetch_size > m_size)
+    {
+        prefetch_size = m_size;
+    }
+    // 避免占用播放中视频所需的内存 分配失败时减半重试
+    while (prefetch_size >= PREFETCH_FILE_MIN_SIZE)
+    {
+        m_buf = (uint8_t *)g_mediaBufPool.alloc(prefetch_size, false);
+        if (NULL != m_buf)
+        {
+            break;
+        }
+        prefetch_size /= 2;
+    }
+    if (NULL != m_buf)
+    {
+        int32_t len = m_file.read(m_buf, prefetch_size);
+        m_bufLen = len > 0 ? len : 0;
+    }
+}
+
+PrefetchFileImpl::~PrefetchFileImpl()
+{
+    close();
+}
+
+void PrefetchFileImpl::release_buf()
+{
+    if (NULL != m_buf)
+    {
+        g_mediaBufPool.free(m_buf);
+        m_buf = NULL;
+    }
+    m_bufLen = 0;
+}
+
+size_t PrefetchFileImpl::write(const uint8_t *buf, size_t size)
+{
+    // 只用于播放 不支持写入
+    return 0;
+}
+
+size_t PrefetchFileImpl::read(uint8_t *buf, size_t size)
+{
+    size_t total = 0;
+    if (m_pos < m_bufLen)
+    {
+        total = m_bufLen - m_pos < size ? m_bufLen - m_pos : size;
+        memcpy(buf, m_buf + m_pos, total);
+        m_pos += total;
+        if (total == size)
+        {
+            return total;
+        }
+    }
+
+    // 预读的数据已经用完 之后都从SD卡读取
+    release_buf();
+    if (m_file.position() != m_pos)
+    {
+        m_file.seek(m_pos);
+    }
+    int32_t len = m_file.read(buf + total, size - total);
+    if (len > 0)
+    {
+        m_pos += len;
+        total += len;
+    }
+    return total;
+}
+
+void PrefetchFileImpl::flush()
+{
+}
+
+bool PrefetchFileImpl::seek(uint32_t pos, fs::SeekMode mode)
+{
+    // 只记录位置 实际读取SD卡时才跳转
+    if (fs::SeekCur == mode)
+    {
+        pos += m_pos;
+    }
+    else if (fs::SeekEnd == mode)
+    {
+        pos += m_size;
+    }
+    if (pos > m_size)
+    {
+        return false;
+    }
+    m_pos = pos;
+    return true;
+}
+
+void PrefetchFileImpl::close()
+{
+    release_buf();
+    if (m_file)
+    {
+        m_file.close();
+    }
+}
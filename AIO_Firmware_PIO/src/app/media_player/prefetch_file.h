@@ -0,0 +1,44 @@
+#ifndef PREFETCH_FILE_H
+#define PREFETCH_FILE_H
+
+#include <FS.h>
+#include <FSImpl.h>
+
+#define PREFETCH_FILE_SIZE 16384 // 预读文件开头的大小（mjpeg大概可以覆盖前几帧）
+
+// 打开文件并预先读入开头的 prefetch_size 字节
+// 返回的File读取这部分数据时直接从内存复制 读取越过预读部分后释放内存并改为读取SD卡
+// 内存不足时预读的数据会相应减少（仍然提前完成文件的打开）
+File prefetch_file_open(const char *path, uint32_t prefetch_size = PREFETCH_FILE_SIZE);
+
+class PrefetchFileImpl : public fs::FileImpl
+{
+private:
+    File m_file;       // 实际的文件
+    uint8_t *m_buf;    // 文件开头的数据
+    uint32_t m_bufLen; // m_buf 中的有效数据（0表示已释放）
+    uint32_t m_pos;    // 对外的读取位置
+    uint32_t m_size;
+
+public:
+    PrefetchFileImpl(File file, uint32_t prefetch_size);
+    virtual ~PrefetchFileImpl();
+    virtual size_t write(const uint8_t *buf, size_t size);
+    virtual size_t read(uint8_t *buf, size_t size);
+    virtual void flush();
+    virtual bool seek(uint32_t pos, fs::SeekMode mode);
+    virtual size_t position() const { return m_pos; }
+    virtual size_t size() const { return m_size; }
+    virtual void close();
+    virtual time_t getLastWrite() { return m_file.getLastWrite(); }
+    virtual const char *name() const { return m_file.name(); }
+    virtual boolean isDirectory(void) { return false; }
+    virtual fs::FileImplPtr openNextFile(const char *mode) { return fs::FileImplPtr(); }
+    virtual void rewindDirectory(void) {}
+    virtual operator bool() { return (bool)m_file; }
+
+private:
+    void release_buf();
+};
+
+#endif
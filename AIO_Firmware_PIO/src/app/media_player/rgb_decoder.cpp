@@ -4,6 +4,7 @@
 #define VIDEO_WIDTH 240L
 #define VIDEO_HEIGHT 240L
 #define MOVIE_BUFFER_SIZE 28800 // (57600)
+#define RGB_TIME_REPORT_FRAMES 100 // 每播放多少帧打印一次耗时
 
 #define TFT_MISO -1
 #define TFT_MOSI 23
@@ -12,13 +13,26 @@
 #define TFT_DC 2
 #define TFT_RST 4 // Connect reset to ensure display initialises
 
-RgbPlayDocoder::RgbPlayDocoder(File *file, bool isUseDMA)
+RgbPlayDocoder::RgbPlayDocoder(File *file, bool isUseDMA, uint16_t stripHeight, const AioMediaHead *head)
 {
-    m_pFile = file;
     m_isUseDMA = isUseDMA;
     m_displayBuf = NULL;
     m_displayBufWithDma[0] = NULL;
     m_displayBufWithDma[1] = NULL;
+    m_bufSize = 0;
+    m_stripSetting = 0 == stripHeight ? RGB_STRIP_HEIGHT : stripHeight;
+    m_targetFps = 0;
+    set_media(file, head);
+    m_offsetX = 0;
+    m_offsetY = 0;
+    m_dmaBufferSel = false;
+    m_isDmaBusy = false;
+    m_frameNo = 0;
+    m_isLastSkip = false;
+    m_frameCount = 0;
+    m_frameMicros = 0;
+    m_readMicros = 0;
+    m_waitMicros = 0;
     video_start();
 }
 
@@ -29,24 +43,44 @@ RgbPlayDocoder::~RgbPlayDocoder(void)
     video_end();
 }
 
+void RgbPlayDocoder::set_media(File *file, const AioMediaHead *head)
+{
+    m_pFile = file;
+    // .aio容器从文件头获取宽高 旧的.rgb文件固定为240*240
+    m_width = NULL != head ? head->width : VIDEO_WIDTH;
+    m_height = NULL != head ? head->height : VIDEO_HEIGHT;
+    m_frameSize = (uint32_t)m_width * m_height * 2;
+    m_dataOffset = NULL != head ? head->data_offset : 0;
+    m_fileFps = NULL != head ? head->fps : 0;
+    m_stripHeight = m_stripSetting > m_height ? m_height : m_stripSetting;
+}
+
 bool RgbPlayDocoder::video_start()
 {
+    m_pFile->seek(m_dataOffset);
+    // 小于屏幕的视频居中显示 只在开始时清一次屏（之后只刷新视频区域）
+    m_offsetX = (tft->width() - m_width) / 2;
+    m_offsetY = (tft->height() - m_height) / 2;
+    if (m_width < tft->width() || m_height < tft->height())
+    {
+        tft->fillScreen(TFT_BLACK);
+    }
+    m_frameNo = 0;
+    m_isLastSkip = false;
+    m_clock.start(0 == m_targetFps ? m_fileFps : m_targetFps);
+
+    bool isOk = alloc_buf();
     if (m_isUseDMA)
     {
-        m_displayBufWithDma[0] = (uint8_t *)heap_caps_malloc(MOVIE_BUFFER_SIZE, MALLOC_CAP_DMA);
-        m_displayBufWithDma[1] = (uint8_t *)heap_caps_malloc(MOVIE_BUFFER_SIZE, MALLOC_CAP_DMA);
         tft->initDMA();
         // 使用DMA
         // DMADrawer::setup(MOVIE_BUFFER_SIZE, SPI_FREQUENCY, TFT_MOSI, TFT_MISO, TFT_SCLK, TFT_CS, TFT_DC);
     }
     else
     {
-        m_displayBuf = (uint8_t *)malloc(MOVIE_BUFFER_SIZE);
-        tft->setAddrWindow((tft->width() - VIDEO_WIDTH) / 2,
-                           (tft->height() - VIDEO_HEIGHT) / 2,
-                           VIDEO_WIDTH, VIDEO_HEIGHT);
+        tft->setAddrWindow(m_offsetX, m_offsetY, m_width, m_height);
     }
-    return true;
+    return isOk;
 
     // Serial.print("Stack: ");
     // Serial.println(uxTaskGetStackHighWaterMark(NULL));
@@ -70,31 +104,98 @@ bool RgbPlayDocoder::video_start()
     // Serial.println((unsigned long)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
 }
 
-bool RgbPlayDocoder::video_play_screen(void)
+bool RgbPlayDocoder::alloc_buf()
 {
-    // Read video
-    uint32_t l = 0;
-    unsigned long Millis_1 = 0; // 更新的时间
-
+    // DMA模式按视频宽度分配刚好一条的缓冲 切换视频时已有的缓冲够用就继续使用
+    uint32_t size = m_isUseDMA ? (uint32_t)m_width * m_stripHeight * 2
+                               : (m_frameSize < MOVIE_BUFFER_SIZE ? m_frameSize : MOVIE_BUFFER_SIZE);
+    if (size <= m_bufSize)
+    {
+        return true;
+    }
+    free_buf();
     if (m_isUseDMA)
     {
-        // 80M主频大概200ms一帧 240M大概150ms一帧
-        uint8_t *dst = NULL;
-        dst = m_displayBufWithDma[0];
-        m_pFile->read(dst, MOVIE_BUFFER_SIZE);
-        tft->pushImageDMA(0, 0, 240, 60, (uint16_t *)dst, nullptr);
+        m_displayBufWithDma[0] = (uint8_t *)g_mediaBufPool.alloc(size, true);
+        m_displayBufWithDma[1] = (uint8_t *)g_mediaBufPool.alloc(size, true);
+        if (NULL == m_displayBufWithDma[0] || NULL == m_displayBufWithDma[1])
+        {
+            Serial.println(F("RGB strip buffer malloc failed"));
+            return false;
+        }
+    }
+    else
+    {
+        m_displayBuf = (uint8_t *)g_mediaBufPool.alloc(size, false);
+        if (NULL == m_displayBuf)
+        {
+            Serial.println(F("RGB buffer malloc failed"));
+            return false;
+        }
+    }
+    m_bufSize = size;
+    return true;
+}
 
-        dst = m_displayBufWithDma[1];
-        m_pFile->read(dst, MOVIE_BUFFER_SIZE);
-        tft->pushImageDMA(0, 60, 240, 60, (uint16_t *)dst, nullptr);
+void RgbPlayDocoder::free_buf()
+{
+    // 缓冲可能还在DMA发送中 等待发送完毕后再释放
+    dma_fence();
+    for (int i = 0; i < 2; ++i)
+    {
+        if (NULL != m_displayBufWithDma[i])
+        {
+            g_mediaBufPool.free(m_displayBufWithDma[i]);
+            m_displayBufWithDma[i] = NULL;
+        }
+    }
+    if (NULL != m_displayBuf)
+    {
+        g_mediaBufPool.free(m_displayBuf);
+        m_displayBuf = NULL;
+    }
+    m_bufSize = 0;
+}
 
-        dst = m_displayBufWithDma[0];
-        m_pFile->read(dst, MOVIE_BUFFER_SIZE);
-        tft->pushImageDMA(0, 120, 240, 60, (uint16_t *)dst, nullptr);
+bool RgbPlayDocoder::video_play_screen(void)
+{
+    if (0 == m_bufSize)
+    {
+        return false;
+    }
+    // 落后于播放时钟时直接跳过一帧（帧大小固定 跳转即可） 超前时休眠等待
+    if (!m_isLastSkip && m_clock.is_late(m_frameNo))
+    {
+        m_isLastSkip = true;
+        ++m_frameNo;
+        m_pFile->seek(m_pFile->position() + m_frameSize);
+        return true;
+    }
+    m_isLastSkip = false;
+    m_clock.wait(m_frameNo++);
+
+    if (m_isUseDMA)
+    {
+        // TFT与SD卡在不同的SPI主机上 可以同时工作
+        // 两个缓冲交替使用：读下一条的同时DMA发送上一条
+        unsigned long frame_start = micros();
+        for (uint16_t y = 0; y < m_height; y += m_stripHeight)
+        {
+            uint16_t h = m_height - y < m_stripHeight ? m_height - y : m_stripHeight;
+            // 正在发送的一定是另一个缓冲（发起下一次DMA前都会先等待）所以这里可以直接写入
+            uint8_t *dst = m_displayBufWithDma[m_dmaBufferSel];
+            unsigned long read_start = micros();
+            m_pFile->read(dst, m_width * h * 2);
+            m_readMicros += micros() - read_start;
 
-        dst = m_displayBufWithDma[1];
-        m_pFile->read(dst, MOVIE_BUFFER_SIZE);
-        tft->pushImageDMA(0, 180, 240, 60, (uint16_t *)dst, nullptr);
+            dma_fence();
+            tft->pushImageDMA(m_offsetX, m_offsetY + y, m_width, h, (uint16_t *)dst, nullptr);
+            m_isDmaBusy = true;
+            m_dmaBufferSel = !m_dmaBufferSel;
+        }
+        // 最后一条的DMA与下一帧第一条的读取重叠 不在这里等待
+        m_frameMicros += micros() - frame_start;
+        time_statistics();
 
         // 以下是使用DMADrawer接口的实现 目前有一定问题，暂时放着
         // uint8_t *dst = NULL;
@@ -116,26 +217,18 @@ bool RgbPlayDocoder::video_play_screen(void)
     }
     else
     {
-
         tft->startWrite();
-        Millis_1 = GET_SYS_MILLIS();
-        l = m_pFile->read(m_displayBuf, MOVIE_BUFFER_SIZE);
-        Serial.println(GET_SYS_MILLIS() - Millis_1);
-        Millis_1 = GET_SYS_MILLIS();
-        tft->pushColors(m_displayBuf, l);
-        Serial.println(GET_SYS_MILLIS() - Millis_1);
-        Millis_1 = GET_SYS_MILLIS();
-        l = m_pFile->read(m_displayBuf, MOVIE_BUFFER_SIZE);
-        Serial.println(GET_SYS_MILLIS() - Millis_1);
-        Millis_1 = GET_SYS_MILLIS();
-        tft->pushColors(m_displayBuf, l);
-        Serial.println(GET_SYS_MILLIS() - Millis_1);
-
-        l = m_pFile->read(m_displayBuf, MOVIE_BUFFER_SIZE);
-        tft->pushColors(m_displayBuf, l);
-        l = m_pFile->read(m_displayBuf, MOVIE_BUFFER_SIZE);
-        tft->pushColors(m_displayBuf, l);
-
+        uint32_t remain = m_frameSize;
+        while (remain > 0)
+        {
+            int32_t l = m_pFile->read(m_displayBuf, remain < MOVIE_BUFFER_SIZE ? remain : MOVIE_BUFFER_SIZE);
+            if (l <= 0)
+            {
+                break;
+            }
+            tft->pushColors(m_displayBuf, l);
+            remain -= l;
+        }
         tft->endWrite();
     }
     return true;
@@ -145,35 +238,89 @@ bool RgbPlayDocoder::video_end(void)
 {
     m_pFile = NULL;
     // 结束播放 释放资源
-    if (m_isUseDMA)
+    free_buf();
+    // 需要添加wait 不然强行释放dma 会导致下一次initDMA失败
+    // tft->dmaWait();
+    // tft->deInitDMA();
+
+    // 使用DMA
+    // DMADrawer::setup(MOVIE_BUFFER_SIZE,
+    //                  SPI_FREQUENCY,
+    //                  TFT_MOSI, TFT_MISO,
+    //                  TFT_SCLK, TFT_CS,
+    //                  TFT_DC);
+    // DMADrawer::close();
+    return true;
+}
+
+bool RgbPlayDocoder::video_rewind(void)
+{
+    // 从第一帧重新播放（循环） 缓冲与文件继续使用
+    if (NULL == m_pFile)
     {
-        if (NULL != m_displayBufWithDma[0])
-        {
-            free(m_displayBufWithDma[0]);
-            free(m_displayBufWithDma[1]);
-            m_displayBufWithDma[0] = NULL;
-            m_displayBufWithDma[1] = NULL;
-        }
-        // 需要添加wait 不然强行释放dma 会导致下一次initDMA失败
-        // tft->dmaWait();
-        // tft->deInitDMA();
+        return false;
+    }
+    dma_fence();
+    m_pFile->seek(m_dataOffset);
+    m_frameNo = 0;
+    m_isLastSkip = false;
+    m_clock.start(0 == m_targetFps ? m_fileFps : m_targetFps);
+    return true;
+}
 
-        // 使用DMA
-        // DMADrawer::setup(MOVIE_BUFFER_SIZE,
-        //                  SPI_FREQUENCY,
-        //                  TFT_MOSI, TFT_MISO,
-        //                  TFT_SCLK, TFT_CS,
-        //                  TFT_DC);
-        // DMADrawer::close();
+bool RgbPlayDocoder::video_switch(File *file, const AioMediaHead *head)
+{
+    // 切换到另一个视频 不重新创建解码对象 缓冲够用时直接复用
+    if (NULL == file)
+    {
+        return false;
     }
-    else
+    // 最后一条可能还在发送 等待完毕后再改写缓冲
+    dma_fence();
+    set_media(file, head);
+    return video_start();
+}
+
+void RgbPlayDocoder::dma_fence(void)
+{
+    // 等待已发起的DMA发送完毕 之后它使用的缓冲才可以被改写或释放
+    if (!m_isDmaBusy)
     {
-        if (NULL != m_displayBuf)
-        {
-            free(m_displayBuf);
-            m_displayBuf = NULL;
-        }
+        return;
     }
+    unsigned long wait_start = micros();
+    tft->dmaWait();
+    m_waitMicros += micros() - wait_start;
+    m_isDmaBusy = false;
+}
 
-    return true;
-}
\ No newline at end of file
+void RgbPlayDocoder::time_statistics(void)
+{
+    // 每 RGB_TIME_REPORT_FRAMES 帧打印一次平均每帧的耗时 用于对比不同条高的效果
+    if (++m_frameCount < RGB_TIME_REPORT_FRAMES)
+    {
+        return;
+    }
+    Serial.printf("RGB strip %u %uMHz: frame %u us (read %u us, dma wait %u us)\n",
+                  m_stripHeight, getCpuFrequencyMhz(),
+                  m_frameMicros / m_frameCount,
+                  m_readMicros / m_frameCount,
+                  m_waitMicros / m_frameCount);
+    m_frameCount = 0;
+    m_frameMicros = 0;
+    m_readMicros = 0;
+    m_waitMicros = 0;
+}
+
+bool RgbPlayDocoder::video_is_end(void)
+{
+    // 缓冲分配失败时同样视为结束 由播放器切换到下一个
+    return NULL == m_pFile || 0 == m_bufSize || !m_pFile->available();
+}
+
+void RgbPlayDocoder::video_set_fps(uint8_t fps)
+{
+    // 0表示按文件中记录的帧率播放（旧文件没有记录帧率 即不控制速度）
+    m_targetFps = fps;
+    m_clock.set_fps(0 == fps ? m_fileFps : fps);
+}
@@ -0,0 +1,622 @@
+#include "thumb_cache.h"
+#include "aio_media.h"
+#include "common.h"
+#include "lvgl.h"
+#include <TJpg_Decoder.h>
+#include <new>
+
+#define THUMB_PATH_MAX_LEN 128
+#define THUMB_RGB_WIDTH 240 // 旧的.rgb文件固定为240*240
+#define THUMB_RGB_HEIGHT 240
+
+ThumbCache g_thumbCache;
+
+uint16_t *ThumbCache::s_genPixels = NULL;
+uint16_t ThumbCache::s_genW = 0;
+uint16_t ThumbCache::s_genH = 0;
+File *ThumbCache::s_gifFile = NULL;
+
+static uint32_t path_hash(const char *path)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261UL;
+    while (*path)
+    {
+        hash = (hash ^ (uint8_t)*path++) * 16777619UL;
+    }
+    return hash;
+}
+
+static bool has_suffix(const char *path, const char *suffix)
+{
+    uint32_t len = strlen(path);
+    uint32_t suffix_len = strlen(suffix);
+    return len > suffix_len && 0 == strcasecmp(path + len - suffix_len, suffix);
+}
+
+// LVGL的缩略图解码器：图片源为 "S:/路径" + THUMB_SRC_SUFFIX
+// LV_IMG_CACHE_DEF_SIZE为0 每次绘制都会打开一次 整张缩略图只需一次读取
+static bool thumb_src_path(const void *src, char *path)
+{
+    if (LV_IMG_SRC_FILE != lv_img_src_get_type(src))
+    {
+        return false;
+    }
+    const char *src_path = (const char *)src;
+    uint32_t len = strlen(src_path);
+    uint32_t suffix_len = strlen(THUMB_SRC_SUFFIX);
+    if (len <= suffix_len || strcmp(src_path + len - suffix_len, THUMB_SRC_SUFFIX))
+    {
+        return false;
+    }
+    if (NULL != path)
+    {
+        // 去掉盘符与后缀
+        const char *start = ':' == src_path[1] ? src_path + 2 : src_path;
+        snprintf(path, THUMB_PATH_MAX_LEN, "%.*s", (int)(src_path + len - suffix_len - start), start);
+    }
+    return true;
+}
+
+static lv_res_t thumb_decoder_info(lv_img_decoder_t *decoder, const void *src, lv_img_header_t *header)
+{
+    LV_UNUSED(decoder);
+    if (!thumb_src_path(src, NULL))
+    {
+        return LV_RES_INV;
+    }
+    header->always_zero = 0;
+    header->cf = LV_IMG_CF_TRUE_COLOR;
+    header->w = THUMB_SIZE;
+    header->h = THUMB_SIZE;
+    return LV_RES_OK;
+}
+
+static lv_res_t thumb_decoder_open(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc)
+{
+    LV_UNUSED(decoder);
+    char path[THUMB_PATH_MAX_LEN];
+    if (!thumb_src_path(dsc->src, path))
+    {
+        return LV_RES_INV;
+    }
+    uint16_t *pixels = (uint16_t *)lv_mem_alloc(THUMB_PIXEL_SIZE);
+    if (NULL == pixels)
+    {
+        return LV_RES_INV;
+    }
+    if (!g_thumbCache.get(path, pixels))
+    {
+        lv_mem_free(pixels);
+        return LV_RES_INV;
+    }
+    dsc->img_data = (const uint8_t *)pixels;
+    return LV_RES_OK;
+}
+
+static void thumb_decoder_close(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc)
+{
+    LV_UNUSED(decoder);
+    if (NULL != dsc->img_data)
+    {
+        lv_mem_free((void *)dsc->img_data);
+        dsc->img_data = NULL;
+    }
+}
+
+ThumbCache::ThumbCache()
+{
+    memset(&m_head, 0, sizeof(ThumbCacheHead));
+    m_entries = NULL;
+    m_refCount = 0;
+    m_hitCount = 0;
+    m_genCount = 0;
+    m_genMillis = 0;
+}
+
+void ThumbCache::initDecoder()
+{
+    // lv_img_decoder_create插入到链表头部 后注册的先被尝试
+    static lv_img_decoder_t *decoder = NULL;
+    if (NULL == decoder)
+    {
+        decoder = lv_img_decoder_create();
+        lv_img_decoder_set_info_cb(decoder, thumb_decoder_info);
+        lv_img_decoder_set_open_cb(decoder, thumb_decoder_open);
+        lv_img_decoder_set_close_cb(decoder, thumb_decoder_close);
+    }
+}
+
+bool ThumbCache::begin(const char *tag)
+{
+    Serial.printf("ThumbCache begin (%s)\n", tag);
+    if (0 != m_refCount++)
+    {
+        return m_file ? true : false;
+    }
+    m_hitCount = 0;
+    m_genCount = 0;
+    m_genMillis = 0;
+    if (!open_file())
+    {
+        // 缓存文件不可用时每次都重新生成
+        Serial.println(F("ThumbCache file unavailable"));
+        return false;
+    }
+    return true;
+}
+
+void ThumbCache::end(const char *tag)
+{
+    if (0 == m_refCount || 0 != --m_refCount)
+    {
+        return;
+    }
+    report(tag);
+    if (m_file)
+    {
+        m_file.close();
+    }
+    if (NULL != m_entries)
+    {
+        free(m_entries);
+        m_entries = NULL;
+    }
+}
+
+bool ThumbCache::open_file()
+{
+    m_entries = (ThumbEntry *)calloc(THUMB_CACHE_MAX_ENTRY, sizeof(ThumbEntry));
+    if (NULL == m_entries)
+    {
+        return false;
+    }
+    uint32_t table_size = THUMB_CACHE_MAX_ENTRY * sizeof(ThumbEntry);
+    if (SD.exists(THUMB_CACHE_PATH))
+    {
+        m_file = SD.open(THUMB_CACHE_PATH, "r+");
+    }
+    if (m_file &&
+        sizeof(ThumbCacheHead) == m_file.read((uint8_t *)&m_head, sizeof(ThumbCacheHead)) &&
+        THUMB_CACHE_MAGIC == m_head.magic && THUMB_CACHE_VERSION == m_head.version &&
+        THUMB_SIZE == m_head.width && THUMB_SIZE == m_head.height &&
+        m_head.entry_num <= THUMB_CACHE_MAX_ENTRY && m_head.next_slot < THUMB_CACHE_MAX_ENTRY &&
+        table_size == m_file.read((uint8_t *)m_entries, table_size))
+    {
+        return true;
+    }
+
+    // 不存在或者已损坏（版本不同）时重建
+    if (m_file)
+    {
+        m_file.close();
+    }
+    memset(m_entries, 0, table_size);
+    m_head.magic = THUMB_CACHE_MAGIC;
+    m_head.version = THUMB_CACHE_VERSION;
+    m_head.width = THUMB_SIZE;
+    m_head.height = THUMB_SIZE;
+    m_head.entry_num = 0;
+    m_head.next_slot = 0;
+    m_file = SD.open(THUMB_CACHE_PATH, "w+");
+    if (!m_file)
+    {
+        return false;
+    }
+    m_file.write((const uint8_t *)&m_head, sizeof(ThumbCacheHead));
+    m_file.write((const uint8_t *)m_entries, table_size);
+    m_file.flush();
+    return true;
+}
+
+uint32_t ThumbCache::pixel_offset(uint32_t slot)
+{
+    return sizeof(ThumbCacheHead) + THUMB_CACHE_MAX_ENTRY * sizeof(ThumbEntry) +
+           slot * THUMB_PIXEL_SIZE;
+}
+
+int32_t ThumbCache::find_entry(uint32_t hash)
+{
+    if (NULL == m_entries)
+    {
+        return -1;
+    }
+    for (uint32_t i = 0; i < m_head.entry_num; ++i)
+    {
+        if (hash == m_entries[i].path_hash)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool ThumbCache::stat_file(const char *file_path, ThumbEntry *entry)
+{
+    File file = SD.open(file_path);
+    if (!file)
+    {
+        return false;
+    }
+    entry->path_hash = path_hash(file_path);
+    entry->file_size = file.size();
+    entry->mtime = (uint32_t)file.getLastWrite();
+    file.close();
+    return true;
+}
+
+bool ThumbCache::lookup(const char *file_path, ThumbEntry *entry, int32_t *slot)
+{
+    // 返回缓存中的缩略图是否可用 slot为已有记录的位置（过期时生成后覆盖）
+    *slot = -1;
+    if (!stat_file(file_path, entry))
+    {
+        return false;
+    }
+    *slot = find_entry(entry->path_hash);
+    return *slot >= 0 && m_file &&
+           entry->file_size == m_entries[*slot].file_size &&
+           entry->mtime == m_entries[*slot].mtime;
+}
+
+bool ThumbCache::get(const char *file_path, uint16_t *pixels)
+{
+    ThumbEntry entry;
+    int32_t slot;
+    if (lookup(file_path, &entry, &slot) &&
+        m_file.seek(pixel_offset(slot)) &&
+        THUMB_PIXEL_SIZE == m_file.read((uint8_t *)pixels, THUMB_PIXEL_SIZE))
+    {
+        ++m_hitCount;
+        return true;
+    }
+    if (!generate(file_path, pixels))
+    {
+        return false;
+    }
+    store(slot, &entry, pixels);
+    return true;
+}
+
+uint32_t ThumbCache::get_batch(const char **file_paths, uint32_t num, uint16_t *pixels)
+{
+    int32_t *slots = (int32_t *)malloc(num * sizeof(int32_t));
+    if (NULL == slots)
+    {
+        return 0;
+    }
+    uint32_t ok_num = 0;
+    uint32_t thumb_len = THUMB_SIZE * THUMB_SIZE;
+    // 先生成缺少的缩略图 命中的记录稍后一起读
+    for (uint32_t i = 0; i < num; ++i)
+    {
+        ThumbEntry entry;
+        int32_t slot;
+        uint16_t *cur = pixels + i * thumb_len;
+        slots[i] = -1;
+        if (lookup(file_paths[i], &entry, &slot))
+        {
+            slots[i] = slot;
+            continue;
+        }
+        if (generate(file_paths[i], cur))
+        {
+            store(slot, &entry, cur);
+            ++ok_num;
+        }
+        else
+        {
+            memset(cur, 0, THUMB_PIXEL_SIZE);
+        }
+    }
+    // 缓存文件中相邻的记录合并为一次顺序读取
+    for (uint32_t i = 0; i < num; ++i)
+    {
+        if (slots[i] < 0)
+        {
+            continue;
+        }
+        uint32_t run = 1;
+        while (i + run < num && slots[i + run] == slots[i] + (int32_t)run)
+        {
+            ++run;
+        }
+        uint32_t size = run * THUMB_PIXEL_SIZE;
+        if (m_file.seek(pixel_offset(slots[i])) &&
+            size == m_file.read((uint8_t *)(pixels + i * thumb_len), size))
+        {
+            ok_num += run;
+            m_hitCount += run;
+        }
+        else
+        {
+            memset(pixels + i * thumb_len, 0, size);
+        }
+        i += run - 1;
+    }
+    free(slots);
+    return ok_num;
+}
+
+bool ThumbCache::gen_output(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap)
+{
+    // 最近邻缩放：找出落在当前块中的缩略图像素
+    for (uint16_t ty = 0; ty < THUMB_SIZE; ++ty)
+    {
+        int32_t sy = (int32_t)ty * s_genH / THUMB_SIZE;
+        if (sy < y || sy >= y + h)
+        {
+            continue;
+        }
+        uint16_t *src = bitmap + (sy - y) * w;
+        uint16_t *dst = s_genPixels + ty * THUMB_SIZE;
+        for (uint16_t tx = 0; tx < THUMB_SIZE; ++tx)
+        {
+            int32_t sx = (int32_t)tx * s_genW / THUMB_SIZE;
+            if (sx >= x && sx < x + w)
+            {
+                dst[tx] = src[sx - x];
+            }
+        }
+    }
+    return 1;
+}
+
+void *ThumbCache::gif_open(const char *name, int32_t *size)
+{
+    // 文件已在gen_gif中打开 这里直接使用
+    *size = s_gifFile->size();
+    return s_gifFile;
+}
+
+void ThumbCache::gif_close(void *handle)
+{
+    // 文件由gen_gif关闭
+}
+
+int32_t ThumbCache::gif_read(GIFFILE *pFile, uint8_t *buf, int32_t len)
+{
+    File *file = (File *)pFile->fHandle;
+    if (len > pFile->iSize - pFile->iPos)
+    {
+        len = pFile->iSize - pFile->iPos;
+    }
+    if (len <= 0)
+    {
+        return 0;
+    }
+    int32_t read_size = file->read(buf, len);
+    pFile->iPos = file->position();
+    return read_size > 0 ? read_size : 0;
+}
+
+int32_t ThumbCache::gif_seek(GIFFILE *pFile, int32_t pos)
+{
+    File *file = (File *)pFile->fHandle;
+    file->seek(pos);
+    pFile->iPos = file->position();
+    return pFile->iPos;
+}
+
+void ThumbCache::gif_draw(GIFDRAW *pDraw)
+{
+    // 与gen_output相同的最近邻缩放 pPixels为一行的调色板序号 透明像素保持黑色
+    int32_t y = pDraw->iY + pDraw->y;
+    for (uint16_t ty = 0; ty < THUMB_SIZE; ++ty)
+    {
+        if ((int32_t)ty * s_genH / THUMB_SIZE != y)
+        {
+            continue;
+        }
+        uint16_t *dst = s_genPixels + ty * THUMB_SIZE;
+        for (uint16_t tx = 0; tx < THUMB_SIZE; ++tx)
+        {
+            int32_t sx = (int32_t)tx * s_genW / THUMB_SIZE - pDraw->iX;
+            if (sx < 0 || sx >= pDraw->iWidth)
+            {
+                continue;
+            }
+            uint8_t index = pDraw->pPixels[sx];
+            if (!pDraw->ucHasTransparency || index != pDraw->ucTransparent)
+            {
+                dst[tx] = pDraw->pPalette[index];
+            }
+        }
+    }
+}
+
+bool ThumbCache::generate(const char *file_path, uint16_t *pixels)
+{
+    // 按扩展名选择解码方式 都只取第一帧 没有画到的像素为黑色
+    unsigned long start = GET_SYS_MILLIS();
+    s_genPixels = pixels;
+    memset(pixels, 0, THUMB_PIXEL_SIZE);
+    bool ret = false;
+    if (has_suffix(file_path, ".aio"))
+    {
+        ret = gen_aio(file_path);
+    }
+    else if (has_suffix(file_path, ".rgb"))
+    {
+        ret = gen_rgb(file_path, 0, THUMB_RGB_WIDTH, THUMB_RGB_HEIGHT);
+    }
+    else if (has_suffix(file_path, ".gif"))
+    {
+        ret = gen_gif(file_path);
+    }
+    else
+    {
+        // jpg与mjpeg都直接用TJpgDec解码（视频只读到第一帧结束）
+        ret = gen_jpg(file_path, 0);
+    }
+    s_genPixels = NULL;
+    ++m_genCount;
+    m_genMillis += GET_SYS_MILLIS() - start;
+    return ret;
+}
+
+bool ThumbCache::gen_aio(const char *file_path)
+{
+    // 第一帧在文件头之后的data_offset处 按容器中的编码格式解码
+    File file = SD.open(file_path);
+    if (!file)
+    {
+        return false;
+    }
+    AioMediaHead head;
+    bool isValid = aio_media_read_head(&file, &head) && head.frame_num > 0;
+    file.close();
+    if (isValid && AIO_CODEC_MJPEG == head.codec)
+    {
+        return gen_jpg(file_path, head.data_offset);
+    }
+    if (isValid && AIO_CODEC_RGB565 == head.codec)
+    {
+        return gen_rgb(file_path, head.data_offset, head.width, head.height);
+    }
+    return false;
+}
+
+bool ThumbCache::gen_jpg(const char *file_path, uint32_t offset)
+{
+    // TJpgDec从文件的当前位置开始解码 解码结束时会关闭文件
+    File file = SD.open(file_path);
+    uint16_t w = 0;
+    uint16_t h = 0;
+    if (!file || !file.seek(offset) ||
+        JDR_OK != TJpgDec.getSdJpgSize(&w, &h, file) || 0 == w || 0 == h)
+    {
+        return false;
+    }
+    // 选择缩小后仍不小于缩略图的最大缩小倍数
+    uint8_t scale = 8;
+    while (scale > 1 && (w / scale < THUMB_SIZE || h / scale < THUMB_SIZE))
+    {
+        scale >>= 1;
+    }
+    s_genW = (w + scale - 1) / scale;
+    s_genH = (h + scale - 1) / scale;
+    file = SD.open(file_path);
+    if (!file || !file.seek(offset))
+    {
+        return false;
+    }
+    // 保存调用者（播放器、相册）的解码设置 生成后还原
+    SketchCallback callback = TJpgDec.tft_output;
+    uint8_t scale_code = TJpgDec.jpgScale;
+    bool swap = TJpgDec._swap;
+    TJpgDec.setJpgScale(scale);
+    TJpgDec.setSwapBytes(false); // 与lv_color_t的字节序相同（LV_COLOR_16_SWAP为0）
+    TJpgDec.setCallback(gen_output);
+    JRESULT ret = TJpgDec.drawSdJpg(0, 0, file);
+    TJpgDec.setCallback(callback);
+    TJpgDec.jpgScale = scale_code; // 保存的是内部的移位值 不经过setJpgScale
+    TJpgDec.setSwapBytes(swap);
+    return JDR_OK == ret;
+}
+
+bool ThumbCache::gen_rgb(const char *file_path, uint32_t offset, uint16_t width, uint16_t height)
+{
+    // 只读出缩略图用到的行 相邻的缩略图行落在同一源行时不重复读取
+    File file = SD.open(file_path);
+    if (!file)
+    {
+        return false;
+    }
+    uint32_t line_size = (uint32_t)width * 2;
+    uint16_t *line = (uint16_t *)malloc(line_size);
+    if (NULL == line)
+    {
+        file.close();
+        return false;
+    }
+    bool ret = true;
+    int32_t line_no = -1;
+    for (uint16_t ty = 0; ty < THUMB_SIZE && ret; ++ty)
+    {
+        int32_t sy = (int32_t)ty * height / THUMB_SIZE;
+        if (sy != line_no)
+        {
+            ret = file.seek(offset + sy * line_size) && line_size == file.read((uint8_t *)line, line_size);
+            line_no = sy;
+        }
+        uint16_t *dst = s_genPixels + ty * THUMB_SIZE;
+        for (uint16_t tx = 0; tx < THUMB_SIZE && ret; ++tx)
+        {
+            // 文件中高字节在前 转为lv_color_t的字节序
+            uint16_t color = line[(int32_t)tx * width / THUMB_SIZE];
+            dst[tx] = color << 8 | color >> 8;
+        }
+    }
+    free(line);
+    file.close();
+    return ret;
+}
+
+bool ThumbCache::gen_gif(const char *file_path)
+{
+    // AnimatedGIF对象较大（约20KB） 只在生成时临时分配
+    File file = SD.open(file_path);
+    if (!file)
+    {
+        return false;
+    }
+    void *mem = malloc(sizeof(AnimatedGIF));
+    if (NULL == mem)
+    {
+        Serial.printf("ThumbCache GIF malloc %u failed\n", sizeof(AnimatedGIF));
+        file.close();
+        return false;
+    }
+    AnimatedGIF *gif = new (mem) AnimatedGIF();
+    gif->begin(GIF_PALETTE_RGB565_LE); // 与lv_color_t的字节序相同
+    s_gifFile = &file;
+    bool ret = gif->open(file_path, gif_open, gif_close, gif_read, gif_seek, gif_draw);
+    s_gifFile = NULL;
+    if (ret)
+    {
+        int delay_ms = 0;
+        s_genW = gif->getCanvasWidth();
+        s_genH = gif->getCanvasHeight();
+        ret = gif->playFrame(false, &delay_ms, NULL) >= 0;
+        gif->close();
+    }
+    gif->~AnimatedGIF();
+    free(mem);
+    file.close();
+    return ret;
+}
+
+void ThumbCache::store(int32_t slot, const ThumbEntry *entry, const uint16_t *pixels)
+{
+    if (!m_file)
+    {
+        return;
+    }
+    if (slot < 0)
+    {
+        // 新记录 写满后循环覆盖
+        slot = m_head.next_slot;
+        m_head.next_slot = (m_head.next_slot + 1) % THUMB_CACHE_MAX_ENTRY;
+        if (m_head.entry_num < THUMB_CACHE_MAX_ENTRY)
+        {
+            ++m_head.entry_num;
+        }
+    }
+    m_entries[slot] = *entry;
+    // 先写像素再写索引 中途断电最多丢失这一张
+    m_file.seek(pixel_offset(slot));
+    m_file.write((const uint8_t *)pixels, THUMB_PIXEL_SIZE);
+    m_file.seek(sizeof(ThumbCacheHead) + slot * sizeof(ThumbEntry));
+    m_file.write((const uint8_t *)entry, sizeof(ThumbEntry));
+    m_file.seek(0);
+    m_file.write((const uint8_t *)&m_head, sizeof(ThumbCacheHead));
+    m_file.flush();
+}
+
+void ThumbCache::report(const char *tag)
+{
+    Serial.printf("ThumbCache [%s] hit %u generated %u (avg %u ms) entries %u\n",
+                  tag, m_hitCount, m_genCount,
+                  0 == m_genCount ? 0 : m_genMillis / m_genCount, m_head.entry_num);
+}
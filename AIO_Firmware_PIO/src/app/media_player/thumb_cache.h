@@ -0,0 +1,88 @@
+#ifndef THUMB_CACHE_H
+#define THUMB_CACHE_H
+
+#include <SD.h>
+#include <AnimatedGIF.h>
+
+// 缩略图缓存（表情封面、相册等的小图）：首次访问时生成 保存在SD卡上的一个缓存文件中
+// jpg按1/2/4/8缩小解码 视频(.mjpeg/.aio/.rgb)与gif取第一帧 再最近邻缩放到 THUMB_SIZE*THUMB_SIZE（不保持比例）
+// 目前只有表情的封面使用 相册还没有网格浏览界面（需要时以 THUMB_SRC_SUFFIX 的图片源或get_batch接入）
+// 文件结构：ThumbCacheHead + THUMB_CACHE_MAX_ENTRY 条 ThumbEntry + 每条对应的像素（RGB565 与lv_color_t相同）
+// 像素按生成的顺序连续存放 同一目录的缩略图可以一次顺序读出（get_batch）
+#define THUMB_CACHE_PATH "/thumb.cache"
+#define THUMB_CACHE_MAGIC 0x424D4854 // "THMB"
+#define THUMB_CACHE_VERSION 1
+#define THUMB_SIZE 60
+#define THUMB_PIXEL_SIZE (THUMB_SIZE * THUMB_SIZE * 2) // 每张缩略图的字节数
+#define THUMB_CACHE_MAX_ENTRY 256                        // 写满后覆盖最早生成的记录
+#define THUMB_SRC_SUFFIX ".thumb" // LVGL图片源加上此后缀时显示缩略图 例如 "S:/movie/a.mjpeg.thumb"
+
+struct ThumbCacheHead
+{
+    uint32_t magic;
+    uint32_t version;
+    uint16_t width; // 缩略图大小（与 THUMB_SIZE 不一致时重建）
+    uint16_t height;
+    uint32_t entry_num; // 已使用的记录数
+    uint32_t next_slot; // 下一条新记录的位置
+};
+
+struct ThumbEntry
+{
+    uint32_t path_hash; // 原文件路径的哈希
+    uint32_t file_size; // 原文件的大小与修改时间（变化时重新生成）
+    uint32_t mtime;
+};
+
+class ThumbCache
+{
+private:
+    File m_file;
+    ThumbCacheHead m_head;
+    ThumbEntry *m_entries; // 所有记录的键（常驻内存 查找时不读文件）
+    uint8_t m_refCount;    // 正在使用缩略图的APP数
+    uint32_t m_hitCount;   // 命中统计
+    uint32_t m_genCount;
+    uint32_t m_genMillis;  // 生成缩略图的总耗时
+
+    static uint16_t *s_genPixels; // 正在生成的缩略图（供解码回调使用）
+    static uint16_t s_genW;       // 缩小解码后的原图大小
+    static uint16_t s_genH;
+    static File *s_gifFile;       // AnimatedGIF打开文件时使用的已打开文件
+
+public:
+    ThumbCache();
+    // 注册LVGL的缩略图解码器 需在setup中先于lv_port_img_cache_init调用（缩略图也经过图片缓存）
+    static void initDecoder();
+    bool begin(const char *tag); // APP进入时调用
+    void end(const char *tag);   // APP退出时调用 最后一个退出时关闭缓存文件
+    // 取得file_path的缩略图 缓存中没有或已过期时生成 pixels为 THUMB_PIXEL_SIZE 字节
+    bool get(const char *file_path, uint16_t *pixels);
+    // 一次取得多张缩略图（pixels为 num*THUMB_PIXEL_SIZE 字节）缓存中相邻的记录合并为一次读取
+    // 返回成功的张数 失败的缩略图为黑色
+    uint32_t get_batch(const char **file_paths, uint32_t num, uint16_t *pixels);
+    void report(const char *tag);
+
+private:
+    bool open_file();
+    int32_t find_entry(uint32_t hash);
+    bool stat_file(const char *file_path, ThumbEntry *entry);
+    bool lookup(const char *file_path, ThumbEntry *entry, int32_t *slot);
+    bool generate(const char *file_path, uint16_t *pixels);
+    bool gen_aio(const char *file_path);
+    bool gen_jpg(const char *file_path, uint32_t offset);
+    bool gen_rgb(const char *file_path, uint32_t offset, uint16_t width, uint16_t height);
+    bool gen_gif(const char *file_path);
+    void store(int32_t slot, const ThumbEntry *entry, const uint16_t *pixels);
+    uint32_t pixel_offset(uint32_t slot);
+    static bool gen_output(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap);
+    static void *gif_open(const char *name, int32_t *size);
+    static void gif_close(void *handle);
+    static int32_t gif_read(GIFFILE *pFile, uint8_t *buf, int32_t len);
+    static int32_t gif_seek(GIFFILE *pFile, int32_t pos);
+    static void gif_draw(GIFDRAW *pDraw);
+};
+
+extern ThumbCache g_thumbCache;
+
+#endif
@@ -0,0 +1,305 @@
+#include "docoder.h"
+#include "common.h"
+
+#define TILE_READ_BUFFER_SIZE 4096   // 每次从SD卡读取的数据大小
+#define TILE_FPS_REPORT_FRAMES 100   // 每播放多少帧打印一次帧率
+#define TILE_MAX_SIZE 64             // 支持的最大块边长
+#define TILE_RLE_REPEAT 0x80         // RLE控制字节 重复像素的标志
+#define TILE_RLE_COUNT_MASK 0x7F
+
+TileRgbPlayDocoder::TileRgbPlayDocoder(File *file)
+{
+    m_pFile = file;
+    memset(&m_head, 0, sizeof(TileVideoHead));
+    m_offsetX = 0;
+    m_offsetY = 0;
+    m_readBuf = NULL;
+    m_readPos = 0;
+    m_readLen = 0;
+    m_runBufWithDma[0] = NULL;
+    m_runBufWithDma[1] = NULL;
+    m_runBufSize = 0;
+    m_runBufSel = false;
+    m_isEnd = false;
+    m_targetFps = 0;
+    m_frameNo = 0;
+    m_frameCount = 0;
+    m_tileCount = 0;
+    m_fpsStartMillis = GET_SYS_MILLIS();
+    video_start();
+}
+
+TileRgbPlayDocoder::~TileRgbPlayDocoder(void)
+{
+    Serial.println(F("~TileRgbPlayDocoder"));
+    // 释放资源
+    video_end();
+}
+
+bool TileRgbPlayDocoder::video_start()
+{
+    // 从文件的当前位置（开头）读取文件头
+    m_readPos = 0;
+    m_readLen = 0;
+    m_frameNo = 0;
+    m_isEnd = false;
+    if (sizeof(TileVideoHead) != m_pFile->read((uint8_t *)&m_head, sizeof(TileVideoHead)) ||
+        TILE_VIDEO_MAGIC != m_head.magic || TILE_VIDEO_VERSION != m_head.version ||
+        0 == m_head.tile_size || m_head.tile_size > TILE_MAX_SIZE ||
+        0 != m_head.width % m_head.tile_size || 0 != m_head.height % m_head.tile_size ||
+        m_head.width > tft->width() || m_head.height > tft->height())
+    {
+        Serial.println(F("Tile video head invalid"));
+        m_isEnd = true;
+        return false;
+    }
+
+    // 一个块段最长为一整行块 切换视频时已有的缓冲够用就继续使用
+    uint32_t run_buf_size = m_head.width * m_head.tile_size * 2;
+    if (run_buf_size > m_runBufSize)
+    {
+        free_run_buf();
+        m_runBufWithDma[0] = (uint16_t *)g_mediaBufPool.alloc(run_buf_size, true);
+        m_runBufWithDma[1] = (uint16_t *)g_mediaBufPool.alloc(run_buf_size, true);
+        m_runBufSize = run_buf_size;
+    }
+    if (NULL == m_readBuf)
+    {
+        m_readBuf = (uint8_t *)g_mediaBufPool.alloc(TILE_READ_BUFFER_SIZE, false);
+    }
+    if (NULL == m_readBuf || NULL == m_runBufWithDma[0] || NULL == m_runBufWithDma[1])
+    {
+        Serial.println(F("Tile video malloc failed"));
+        m_isEnd = true;
+        return false;
+    }
+    tft->initDMA();
+
+    m_offsetX = (tft->width() - m_head.width) / 2;
+    m_offsetY = (tft->height() - m_head.height) / 2;
+    // 小于屏幕的视频居中显示 只在开始时清一次屏（之后只刷新变化的块） 否则四周留着上一个视频的画面
+    if (m_head.width < tft->width() || m_head.height < tft->height())
+    {
+        tft->fillScreen(TFT_BLACK);
+    }
+    // 0表示按视频自身的帧率播放
+    m_clock.start(0 == m_targetFps ? m_head.fps : m_targetFps);
+    Serial.printf("Tile video %ux%u tile %u %u fps %u frames\n",
+                  m_head.width, m_head.height, m_head.tile_size,
+                  m_head.fps, m_head.frame_num);
+    return true;
+}
+
+bool TileRgbPlayDocoder::read_bytes(uint8_t *dst, uint32_t len)
+{
+    while (len > 0)
+    {
+        if (m_readPos == m_readLen)
+        {
+            int32_t read_size = m_pFile->read(m_readBuf, TILE_READ_BUFFER_SIZE);
+            if (read_size <= 0)
+            {
+                return false;
+            }
+            m_readPos = 0;
+            m_readLen = read_size;
+        }
+        uint32_t copy_size = m_readLen - m_readPos;
+        if (copy_size > len)
+        {
+            copy_size = len;
+        }
+        memcpy(dst, m_readBuf + m_readPos, copy_size);
+        m_readPos += copy_size;
+        dst += copy_size;
+        len -= copy_size;
+    }
+    return true;
+}
+
+bool TileRgbPlayDocoder::decode_run(const TileRunHead *run, uint16_t *dst)
+{
+    // 将一个块段的RLE数据展开到 dst （像素的字节序与.rgb相同 直接发送给屏幕）
+    uint32_t remain = run->count * m_head.tile_size * m_head.tile_size;
+    while (remain > 0)
+    {
+        uint8_t ctrl = 0;
+        if (!read_bytes(&ctrl, 1))
+        {
+            return false;
+        }
+        uint32_t num = (ctrl & TILE_RLE_COUNT_MASK) + 1;
+        if (num > remain)
+        {
+            return false;
+        }
+        if (ctrl & TILE_RLE_REPEAT)
+        {
+            uint16_t color = 0;
+            if (!read_bytes((uint8_t *)&color, 2))
+            {
+                return false;
+            }
+            for (uint32_t i = 0; i < num; ++i)
+            {
+                dst[i] = color;
+            }
+        }
+        else if (!read_bytes((uint8_t *)dst, num * 2))
+        {
+            return false;
+        }
+        dst += num;
+        remain -= num;
+    }
+    return true;
+}
+
+bool TileRgbPlayDocoder::video_play_screen(void)
+{
+    if (m_isEnd)
+    {
+        return false;
+    }
+    if (m_frameNo >= m_head.frame_num)
+    {
+        m_isEnd = true;
+        return false;
+    }
+
+    TileFrameHead frame;
+    if (!read_bytes((uint8_t *)&frame, sizeof(TileFrameHead)))
+    {
+        m_isEnd = true;
+        return false;
+    }
+
+    // 差分帧依赖上一帧的画面 落后时也不能跳过 只在超前时等待
+    m_clock.wait(m_frameNo++);
+
+    uint8_t tiles_x = m_head.width / m_head.tile_size;
+    uint8_t tiles_y = m_head.height / m_head.tile_size;
+    for (uint16_t i = 0; i < frame.run_num; ++i)
+    {
+        TileRunHead run;
+        if (!read_bytes((uint8_t *)&run, sizeof(TileRunHead)) ||
+            0 == run.count || run.x + run.count > tiles_x || run.y >= tiles_y)
+        {
+            Serial.println(F("Tile video data invalid"));
+            m_isEnd = true;
+            return false;
+        }
+        // pushImageDMA 开始前会等待上一次发送完毕 所以两个缓冲交替使用时
+        // 正在解码的缓冲一定已经发送完毕
+        uint16_t *dst = m_runBufWithDma[m_runBufSel];
+        if (!decode_run(&run, dst))
+        {
+            Serial.println(F("Tile video data invalid"));
+            m_isEnd = true;
+            return false;
+        }
+        tft->pushImageDMA(m_offsetX + run.x * m_head.tile_size,
+                          m_offsetY + run.y * m_head.tile_size,
+                          run.count * m_head.tile_size, m_head.tile_size,
+                          dst, nullptr);
+        m_runBufSel = !m_runBufSel;
+        m_tileCount += run.count;
+    }
+    fps_statistics();
+    return true;
+}
+
+void TileRgbPlayDocoder::fps_statistics(void)
+{
+    // 每 TILE_FPS_REPORT_FRAMES 帧打印一次平均帧率以及平均每帧刷新的块数
+    if (++m_frameCount < TILE_FPS_REPORT_FRAMES)
+    {
+        return;
+    }
+    unsigned long cost = GET_SYS_MILLIS() - m_fpsStartMillis;
+    if (cost > 0)
+    {
+        Serial.printf("Tile video %uMHz: %.2f fps %u tiles/frame\n",
+                      getCpuFrequencyMhz(),
+                      m_frameCount * 1000.0 / cost,
+                      m_tileCount / m_frameCount);
+    }
+    m_frameCount = 0;
+    m_tileCount = 0;
+    m_fpsStartMillis = GET_SYS_MILLIS();
+}
+
+bool TileRgbPlayDocoder::video_end(void)
+{
+    m_pFile = NULL;
+    m_isEnd = true;
+    free_run_buf();
+    if (NULL != m_readBuf)
+    {
+        g_mediaBufPool.free(m_readBuf);
+        m_readBuf = NULL;
+    }
+    return true;
+}
+
+void TileRgbPlayDocoder::free_run_buf(void)
+{
+    // 需要等待DMA发送完毕才可以释放缓冲
+    tft->dmaWait();
+    for (int i = 0; i < 2; ++i)
+    {
+        if (NULL != m_runBufWithDma[i])
+        {
+            g_mediaBufPool.free(m_runBufWithDma[i]);
+            m_runBufWithDma[i] = NULL;
+        }
+    }
+    m_runBufSize = 0;
+}
+
+bool TileRgbPlayDocoder::video_rewind(void)
+{
+    // 从第一帧（关键帧）重新播放 缓冲与文件继续使用 画面尺寸不变所以不需要清屏
+    if (NULL == m_pFile || NULL == m_readBuf)
+    {
+        return false;
+    }
+    tft->dmaWait();
+    m_pFile->seek(sizeof(TileVideoHead));
+    m_readPos = 0;
+    m_readLen = 0;
+    m_frameNo = 0;
+    m_isEnd = false;
+    m_clock.start(0 == m_targetFps ? m_head.fps : m_targetFps);
+    return true;
+}
+
+bool TileRgbPlayDocoder::video_switch(File *file, const AioMediaHead *head)
+{
+    // 切换到另一个视频 不重新创建解码对象 缓冲够用时直接复用
+    if (NULL == file)
+    {
+        return false;
+    }
+    // 正在发送的块段缓冲可能被下一个视频改写
+    tft->dmaWait();
+    m_pFile = file;
+    return video_start();
+}
+
+bool TileRgbPlayDocoder::video_is_end(void)
+{
+    return NULL == m_pFile || m_isEnd;
+}
+
+uint32_t TileRgbPlayDocoder::video_get_frame(void)
+{
+    return m_frameNo;
+}
+
+void TileRgbPlayDocoder::video_set_fps(uint8_t fps)
+{
+    // 0表示按视频自身的帧率播放
+    m_targetFps = fps;
+    m_clock.set_fps(0 == fps ? m_head.fps : fps);
+}
@@ -224,7 +224,7 @@ static void pc_resource_process(AppController *sys, const ImuAction *act_info)
                      APP_MESSAGE_WIFI_CONN, (void *)UPDATE_RS_DATA, NULL);
     }
 
-    delay(30);
+    screen.lvglDelay(30);
 }
 
 /**
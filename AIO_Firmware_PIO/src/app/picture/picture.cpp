@@ -1,10 +1,9 @@
 #include "picture.h"
 #include "picture_gui.h"
+#include "picture_cache.h"
 #include "sys/app_controller.h"
 #include "common.h"
-
-// Include the jpeg decoder library
-#include <TJpg_Decoder.h>
+#include "driver/lv_port_jpeg.h"
 
 #define PICTURE_APP_NAME "Picture"
 
@@ -13,8 +12,11 @@
 struct PIC_Config
 {
     unsigned long switchInterval; // 自动播放下一张的时间间隔 ms
+    uint32_t cacheKB;             // 预解码缓存的内存预算 KB（0不缓存）
 };
 
+#define PICTURE_CACHE_DEFAULT_KB 120 // 默认缓存一张整屏图片
+
 static void write_config(PIC_Config *cfg)
 {
     char tmp[16];
@@ -23,6 +25,9 @@ static void write_config(PIC_Config *cfg)
     memset(tmp, 0, 16);
     snprintf(tmp, 16, "%lu\n", cfg->switchInterval);
     w_data += tmp;
+    memset(tmp, 0, 16);
+    snprintf(tmp, 16, "%u\n", cfg->cacheKB);
+    w_data += tmp;
     g_flashCfg.writeFile(PICTURE_CONFIG_PATH, w_data.c_str());
 }
 
@@ -37,14 +42,22 @@ static void read_config(PIC_Config *cfg)
     {
         // 默认值
         cfg->switchInterval = 10000; // 是否自动播放下一个（0不切换 默认10000毫秒）
+        cfg->cacheKB = PICTURE_CACHE_DEFAULT_KB;
         write_config(cfg);
     }
     else
     {
         // 解析数据
-        char *param[1] = {0};
-        analyseParam(info, 1, param);
+        // 旧版本的配置文件只有一行
+        int lines = 0;
+        for (char *c = info; *c; ++c)
+        {
+            lines += '\n' == *c;
+        }
+        char *param[2] = {0};
+        analyseParam(info, lines < 2 ? 1 : 2, param);
         cfg->switchInterval = atol(param[0]);
+        cfg->cacheKB = NULL == param[1] ? PICTURE_CACHE_DEFAULT_KB : atol(param[1]);
     }
 }
 
@@ -56,29 +69,17 @@ struct PictureAppRunData
     File_Info *pfile;           // 指向当前播放的文件节点
     int image_pos_increate = 1; // 文件的遍历方向
     bool refreshFlag = false;   // 是否更新
-    bool tftSwapStatus;
 };
 
 static PIC_Config cfg_data;
 static PictureAppRunData *run_data = NULL;
+static PictureCache pic_cache;
 
-// This next function will be called during decoding of the jpeg file to
-// render each block to the TFT.  If you use a different TFT library
-// you will need to adapt this function to suit.
-bool tft_output(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap)
+static bool cache_read_line(const char *path, lv_coord_t x, lv_coord_t y,
+                            lv_coord_t len, lv_color_t *buf)
 {
-    // Stop further decoding as image is running off bottom of screen
-    if (y >= tft->height())
-        return 0;
-
-    // This function will clip the image block rendering automatically at the TFT boundaries
-    tft->pushImage(x, y, w, h, bitmap);
-
-    // This might work instead if you adapt the sketch to use the Adafruit_GFX library
-    // tft.drawRGBBitmap(x, y, bitmap, w, h);
-
-    // Return 1 to decode next block
-    return 1;
+    // LVGL解码jpg时优先从预解码缓存中读取
+    return pic_cache.read_line(path, x, y, len, (uint16_t *)buf);
 }
 
 static File_Info *get_next_file(File_Info *p_cur_file, int direction)
@@ -101,6 +102,30 @@ static File_Info *get_next_file(File_Info *p_cur_file, int direction)
     return pfile;
 }
 
+static bool is_jpg_file(const char *file_name)
+{
+    return NULL != strstr(file_name, ".jpg") || NULL != strstr(file_name, ".JPG");
+}
+
+static void prefetch_neighbours(void)
+{
+    // 预解码当前遍历方向上的下一张与反方向的上一张（只缓存jpg）
+    File_Info *keys[2] = {get_next_file(run_data->pfile, run_data->image_pos_increate),
+                          get_next_file(run_data->pfile, -run_data->image_pos_increate)};
+    char paths[2][PIC_FILENAME_MAX_LEN] = {{0}};
+    for (int i = 0; i < 2; ++i)
+    {
+        if (NULL == keys[i] || run_data->pfile == keys[i] || !is_jpg_file(keys[i]->file_name))
+        {
+            keys[i] = NULL;
+            continue;
+        }
+        snprintf(paths[i], PIC_FILENAME_MAX_LEN, "%s/%s",
+                 run_data->image_file->file_name, keys[i]->file_name);
+    }
+    pic_cache.prefetch(keys[0], paths[0], keys[1], paths[1]);
+}
+
 static int picture_init(AppController *sys)
 {
     photo_gui_init();
@@ -112,9 +137,6 @@ static int picture_init(AppController *sys)
     run_data->image_file = NULL;
     run_data->pfile = NULL;
     run_data->image_pos_increate = 1;
-    // 保存系统的tft设置参数 用于退出时恢复设置
-    run_data->tftSwapStatus = tft->getSwapBytes();
-    tft->setSwapBytes(true); // We need to swap the colour bytes (endianess)
 
     run_data->image_file = tf.listDir(IMAGE_PATH);
     if (NULL != run_data->image_file)
@@ -122,10 +144,9 @@ static int picture_init(AppController *sys)
         run_data->pfile = get_next_file(run_data->image_file->next_node, 1);
     }
 
-    // The jpeg image can be scaled by a factor of 1, 2, 4, or 8
-    TJpgDec.setJpgScale(1);
-    // The decoder must be given the exact name of the rendering function above
-    TJpgDec.setCallback(tft_output);
+    // jpg与bin一样由LVGL显示（lv_port_jpeg.c） 预解码的图片直接从缓存中读取
+    pic_cache.begin(cfg_data.cacheKB * 1024, tft->width(), tft->height());
+    lv_port_jpeg_set_read_cb(cache_read_line);
     return 0;
 }
 
@@ -181,22 +202,30 @@ static void picture_process(AppController *sys,
         // Draw the image, top left at 0,0
         Serial.print(F("Decode image: "));
         Serial.println(file_name);
-        if (NULL != strstr(file_name, ".jpg") || NULL != strstr(file_name, ".JPG"))
+        if (is_jpg_file(file_name))
         {
-            // 直接解码jpg格式的图片
-            TJpgDec.drawSdJpg(0, 0, file_name);
+            // 预解码缓存命中时LVGL直接读取缓存 否则逐行解码jpg
+            pic_cache.select(run_data->pfile);
+            display_photo(file_name, anim_type);
+            // 立即刷新 切换动画期间LVGL仍逐帧读取当前缓存 等动画结束后才能释放给相邻图片
+            lv_refr_now(NULL);
+            screen.waitAnim(1000);
+            pic_cache.report("show");
         }
         else if (NULL != strstr(file_name, ".bin") || NULL != strstr(file_name, ".BIN"))
         {
             // 使用LVGL的bin格式的图片
             display_photo(file_name, anim_type);
         }
-        
+
+        // 当前图片已显示完毕 释放选中的缓存并预解码相邻图片
+        prefetch_neighbours();
+
         run_data->refreshFlag = false;
         // 重置更新的时间标记
         run_data->pic_perMillis = GET_SYS_MILLIS();
     }
-    delay(300);
+    screen.lvglDelay(300);
 }
 
 static void picture_background_task(AppController *sys,
@@ -208,11 +237,12 @@ static void picture_background_task(AppController *sys,
 
 static int picture_exit_callback(void *param)
 {
+    // 先停止后台解码（解码任务还在使用文件名）
+    lv_port_jpeg_set_read_cb(NULL);
+    pic_cache.end();
     photo_gui_del();
     // 释放文件名链表
     release_file_info(run_data->image_file);
-    // 恢复此前的驱动参数
-    tft->setSwapBytes(run_data->tftSwapStatus);
 
     // 释放运行数据
     if (NULL != run_data)
@@ -236,6 +266,10 @@ static void picture_message_handle(const char *from, const char *to,
         {
             snprintf((char *)ext_info, 32, "%lu", cfg_data.switchInterval);
         }
+        else if (!strcmp(param_key, "cacheKB"))
+        {
+            snprintf((char *)ext_info, 32, "%u", cfg_data.cacheKB);
+        }
         else
         {
             snprintf((char *)ext_info, 32, "%s", "NULL");
@@ -250,6 +284,10 @@ static void picture_message_handle(const char *from, const char *to,
         {
             cfg_data.switchInterval = atol(param_val);
         }
+        else if (!strcmp(param_key, "cacheKB"))
+        {
+            cfg_data.cacheKB = atol(param_val);
+        }
     }
     break;
     case APP_MESSAGE_READ_CFG:
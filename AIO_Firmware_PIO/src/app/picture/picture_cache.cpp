@@ -0,0 +1,342 @@
+#include "picture_cache.h"
+#include <TJpg_Decoder.h>
+
+#define PICTURE_CACHE_TASK_CORE 0     // 后台解码任务所在的核（loop运行在1核）
+#define PICTURE_CACHE_TASK_PRIORITY 1
+#define PICTURE_CACHE_WAIT_MS 2000    // 选中时等待正在后台解码的图片的最长时间
+
+PictureCache::CacheSlot *PictureCache::s_decodeSlot = NULL;
+PictureCache *PictureCache::s_decodeCache = NULL;
+
+static void free_bands(uint16_t **bands, uint16_t band_num)
+{
+    if (NULL == bands)
+    {
+        return;
+    }
+    for (uint16_t i = 0; i < band_num; ++i)
+    {
+        if (NULL != bands[i])
+        {
+            free(bands[i]);
+        }
+    }
+    free(bands);
+}
+
+PictureCache::PictureCache()
+{
+    memset(m_slots, 0, sizeof(m_slots));
+    m_slotNum = 0;
+    m_width = 0;
+    m_height = 0;
+    m_bandNum = 0;
+    m_stateMutex = NULL;
+    m_taskExitSem = NULL;
+    m_task = NULL;
+    m_isStop = false;
+    m_frameSlot = NULL;
+    m_hitCount = 0;
+    m_missCount = 0;
+    m_decodeMillis = 0;
+}
+
+void PictureCache::begin(uint32_t budget, uint16_t width, uint16_t height)
+{
+    m_width = width;
+    m_height = height;
+    m_bandNum = (height + PICTURE_CACHE_BAND_ROWS - 1) / PICTURE_CACHE_BAND_ROWS;
+    m_slotNum = 0;
+    m_hitCount = 0;
+    m_missCount = 0;
+    m_isStop = false;
+    m_frameSlot = NULL;
+    m_stateMutex = xSemaphoreCreateMutex();
+
+    uint32_t band_size = m_width * PICTURE_CACHE_BAND_ROWS * 2;
+    uint32_t want = budget / (band_size * m_bandNum);
+    if (want > PICTURE_CACHE_MAX_SLOT)
+    {
+        want = PICTURE_CACHE_MAX_SLOT;
+    }
+    for (uint8_t i = 0; i < want; ++i)
+    {
+        // 内存不足时少缓存几张
+        CacheSlot *slot = &m_slots[i];
+        slot->bands = (uint16_t **)calloc(m_bandNum, sizeof(uint16_t *));
+        bool isOk = NULL != slot->bands;
+        for (uint16_t b = 0; isOk && b < m_bandNum; ++b)
+        {
+            slot->bands[b] = (uint16_t *)malloc(band_size);
+            isOk = NULL != slot->bands[b];
+        }
+        if (!isOk)
+        {
+            free_bands(slot->bands, m_bandNum);
+            slot->bands = NULL;
+            break;
+        }
+        slot->key = NULL;
+        slot->state = SLOT_EMPTY;
+        ++m_slotNum;
+    }
+
+    if (m_slotNum > 0)
+    {
+        m_taskExitSem = xSemaphoreCreateBinary();
+        if (pdPASS != xTaskCreatePinnedToCore(decode_task, "PicCache", 6 * 1024, this,
+                                              PICTURE_CACHE_TASK_PRIORITY, &m_task,
+                                              PICTURE_CACHE_TASK_CORE))
+        {
+            m_task = NULL;
+            m_slotNum = 0;
+        }
+    }
+    Serial.printf("Picture cache %u/%u slots (%u KB)\n", m_slotNum, want,
+                  m_slotNum * band_size * m_bandNum / 1024);
+}
+
+void PictureCache::end()
+{
+    // 先停止后台任务（正在进行的解码会在下一个块时退出）
+    if (NULL != m_task)
+    {
+        m_isStop = true;
+        xTaskNotifyGive(m_task);
+        xSemaphoreTake(m_taskExitSem, portMAX_DELAY);
+        m_task = NULL;
+    }
+    report("exit");
+    m_frameSlot = NULL;
+    for (uint8_t i = 0; i < PICTURE_CACHE_MAX_SLOT; ++i)
+    {
+        free_bands(m_slots[i].bands, m_bandNum);
+        m_slots[i].bands = NULL;
+        m_slots[i].key = NULL;
+        m_slots[i].state = SLOT_EMPTY;
+    }
+    m_slotNum = 0;
+    if (NULL != m_taskExitSem)
+    {
+        vSemaphoreDelete(m_taskExitSem);
+        m_taskExitSem = NULL;
+    }
+    if (NULL != m_stateMutex)
+    {
+        vSemaphoreDelete(m_stateMutex);
+        m_stateMutex = NULL;
+    }
+}
+
+PictureCache::CacheSlot *PictureCache::find_slot(File_Info *key)
+{
+    for (uint8_t i = 0; i < m_slotNum; ++i)
+    {
+        if (SLOT_EMPTY != m_slots[i].state && key == m_slots[i].key)
+        {
+            return &m_slots[i];
+        }
+    }
+    return NULL;
+}
+
+bool PictureCache::select(File_Info *key)
+{
+    m_frameSlot = NULL;
+    if (0 == m_slotNum)
+    {
+        return false;
+    }
+    xSemaphoreTake(m_stateMutex, portMAX_DELAY);
+    CacheSlot *slot = find_slot(key);
+    if (NULL != slot && SLOT_PENDING == slot->state)
+    {
+        // 还没开始解码 由LVGL直接解码
+        slot->state = SLOT_EMPTY;
+        slot->key = NULL;
+        slot = NULL;
+    }
+    xSemaphoreGive(m_stateMutex);
+
+    // 正在后台解码的图片等它解码完（比重新解码快）
+    unsigned long start = GET_SYS_MILLIS();
+    while (NULL != slot && SLOT_DECODING == slot->state &&
+           GET_SYS_MILLIS() - start < PICTURE_CACHE_WAIT_MS)
+    {
+        delay(5);
+    }
+    if (NULL == slot || SLOT_READY != slot->state || key != slot->key)
+    {
+        ++m_missCount;
+        return false;
+    }
+    m_frameSlot = slot;
+    ++m_hitCount;
+    return true;
+}
+
+bool PictureCache::read_line(const char *path, int16_t x, int16_t y, uint16_t len, uint16_t *buf)
+{
+    CacheSlot *slot = m_frameSlot;
+    if (NULL == slot || x < 0 || y < 0 || x + len > m_width || y >= m_height ||
+        strcmp(path, slot->path))
+    {
+        return false;
+    }
+    memcpy(buf, slot->bands[y / PICTURE_CACHE_BAND_ROWS] +
+                    (y % PICTURE_CACHE_BAND_ROWS) * m_width + x,
+           len * 2);
+    return true;
+}
+
+void PictureCache::release()
+{
+    m_frameSlot = NULL;
+}
+
+void PictureCache::prefetch(File_Info *next, const char *next_path, File_Info *prev, const char *prev_path)
+{
+    if (0 == m_slotNum)
+    {
+        return;
+    }
+    File_Info *keys[2] = {next, prev};
+    const char *paths[2] = {next_path, prev_path};
+    release();
+    xSemaphoreTake(m_stateMutex, portMAX_DELAY);
+    // 回收不再需要的缓存（正在解码的等下一次再回收）
+    for (uint8_t i = 0; i < m_slotNum; ++i)
+    {
+        CacheSlot *slot = &m_slots[i];
+        if (SLOT_DECODING != slot->state && next != slot->key && prev != slot->key)
+        {
+            slot->state = SLOT_EMPTY;
+            slot->key = NULL;
+        }
+    }
+    for (uint8_t k = 0; k < 2; ++k)
+    {
+        if (NULL == keys[k] || NULL == paths[k])
+        {
+            continue;
+        }
+        CacheSlot *slot = find_slot(keys[k]);
+        if (NULL != slot)
+        {
+            slot->priority = k;
+            continue;
+        }
+        for (uint8_t i = 0; i < m_slotNum && NULL == slot; ++i)
+        {
+            if (SLOT_EMPTY == m_slots[i].state)
+            {
+                slot = &m_slots[i];
+            }
+        }
+        if (NULL == slot)
+        {
+            break;
+        }
+        slot->key = keys[k];
+        snprintf(slot->path, PIC_FILENAME_MAX_LEN, "%s", paths[k]);
+        slot->priority = k;
+        slot->state = SLOT_PENDING;
+    }
+    xSemaphoreGive(m_stateMutex);
+    xTaskNotifyGive(m_task);
+}
+
+void PictureCache::report(const char *tag)
+{
+    uint32_t total = m_hitCount + m_missCount;
+    Serial.printf("Picture cache [%s] hit %u/%u (%u%%) last decode %u ms\n",
+                  tag, m_hitCount, total,
+                  0 == total ? 0 : m_hitCount * 100 / total, m_decodeMillis);
+}
+
+bool PictureCache::decode_output(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap)
+{
+    // 把解码出的块写入对应的分块（块的行数不超过分块的行数 且不会跨越两块）
+    PictureCache *cache = s_decodeCache;
+    if (cache->m_isStop || y >= cache->m_height)
+    {
+        return 0;
+    }
+    if (x >= cache->m_width)
+    {
+        return 1;
+    }
+    uint16_t copy_w = x + w > cache->m_width ? cache->m_width - x : w;
+    for (uint16_t row = 0; row < h && y + row < cache->m_height; ++row)
+    {
+        uint16_t line = y + row;
+        uint16_t *dst = s_decodeSlot->bands[line / PICTURE_CACHE_BAND_ROWS] +
+                        (line % PICTURE_CACHE_BAND_ROWS) * cache->m_width + x;
+        memcpy(dst, bitmap + row * w, copy_w * 2);
+    }
+    return 1;
+}
+
+bool PictureCache::decode_slot(CacheSlot *slot)
+{
+    // 小于屏幕的图片与直接解码时一样画在左上角 其余部分为黑色
+    for (uint16_t b = 0; b < m_bandNum; ++b)
+    {
+        memset(slot->bands[b], 0, m_width * PICTURE_CACHE_BAND_ROWS * 2);
+    }
+    // 相册中只有后台任务使用TJpgDec（前台由LVGL的jpg解码器解码）
+    unsigned long start = GET_SYS_MILLIS();
+    s_decodeCache = this;
+    s_decodeSlot = slot;
+    TJpgDec.setJpgScale(1);
+    TJpgDec.setSwapBytes(LV_COLOR_16_SWAP); // 与lv_color_t的字节序相同
+    TJpgDec.setCallback(decode_output);
+    JRESULT ret = TJpgDec.drawSdJpg(0, 0, slot->path);
+    TJpgDec.setSwapBytes(false);
+    s_decodeSlot = NULL;
+    m_decodeMillis = GET_SYS_MILLIS() - start;
+    return JDR_OK == ret && !m_isStop;
+}
+
+void PictureCache::decode_task(void *parameter)
+{
+    // 按 prefetch() 排好的顺序逐张解码 没有待解码的图片时休眠
+    PictureCache *cache = (PictureCache *)parameter;
+    while (!cache->m_isStop)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (!cache->m_isStop)
+        {
+            CacheSlot *slot = NULL;
+            xSemaphoreTake(cache->m_stateMutex, portMAX_DELAY);
+            for (uint8_t i = 0; i < cache->m_slotNum; ++i)
+            {
+                CacheSlot *cur = &cache->m_slots[i];
+                if (SLOT_PENDING == cur->state && (NULL == slot || cur->priority < slot->priority))
+                {
+                    slot = cur;
+                }
+            }
+            if (NULL != slot)
+            {
+                slot->state = SLOT_DECODING;
+            }
+            xSemaphoreGive(cache->m_stateMutex);
+            if (NULL == slot)
+            {
+                break;
+            }
+
+            bool isOk = cache->decode_slot(slot);
+            xSemaphoreTake(cache->m_stateMutex, portMAX_DELAY);
+            slot->state = isOk ? SLOT_READY : SLOT_EMPTY;
+            if (!isOk)
+            {
+                slot->key = NULL;
+            }
+            xSemaphoreGive(cache->m_stateMutex);
+        }
+    }
+    xSemaphoreGive(cache->m_taskExitSem);
+    vTaskDelete(NULL);
+}
@@ -0,0 +1,70 @@
+#ifndef PICTURE_CACHE_H
+#define PICTURE_CACHE_H
+
+#include "common.h"
+#include "picture_gui.h"
+
+#define PICTURE_CACHE_MAX_SLOT 2   // 最多缓存的图片数（下一张、上一张）
+#define PICTURE_CACHE_BAND_ROWS 16 // 每块缓冲的行数（MCU的最大高度 解码的块不会跨越两块）
+
+// 相册的预解码缓存：后台任务把下一张/上一张jpg解码成RGB565 切换时LVGL的jpg解码器直接从缓存中读取各行
+// 每张图按 PICTURE_CACHE_BAND_ROWS 行分块申请内存（不需要一整块连续的内存）
+// 缓存本身不推屏：命中时画面与其余控件一样经LVGL的绘制缓冲发送到屏幕
+// 没有解码器互斥锁：相册中TJpgDec只由后台任务使用 前台的jpg解码器直接调用tjpgd（各自的工作区）
+class PictureCache
+{
+private:
+    enum SlotState
+    {
+        SLOT_EMPTY,    // 空闲
+        SLOT_PENDING,  // 等待后台解码
+        SLOT_DECODING, // 后台正在解码
+        SLOT_READY     // 已解码 可供LVGL读取
+    };
+    struct CacheSlot
+    {
+        File_Info *key; // 图片在文件链表中的节点
+        char path[PIC_FILENAME_MAX_LEN];
+        volatile uint8_t state;
+        uint8_t priority; // 后台解码的顺序（0为下一张 1为上一张）
+        uint16_t **bands; // 每块 PICTURE_CACHE_BAND_ROWS 行像素（与lv_color_t相同）
+    };
+    CacheSlot m_slots[PICTURE_CACHE_MAX_SLOT];
+    uint8_t m_slotNum;  // 内存预算内实际可用的缓存数（0表示不缓存）
+    uint16_t m_width;   // 缓存的画面大小（屏幕大小）
+    uint16_t m_height;
+    uint16_t m_bandNum; // 每张图的分块数
+    SemaphoreHandle_t m_stateMutex; // 保护各缓存的状态
+    SemaphoreHandle_t m_taskExitSem;
+    TaskHandle_t m_task;
+    volatile bool m_isStop;
+    CacheSlot *m_frameSlot; // select()选中的当前图片（release()之前不会被回收）
+    uint32_t m_hitCount; // 命中统计
+    uint32_t m_missCount;
+    uint32_t m_decodeMillis; // 最近一次后台解码的耗时
+
+    static CacheSlot *s_decodeSlot; // 正在后台解码的缓存（供解码回调使用）
+    static PictureCache *s_decodeCache;
+
+public:
+    PictureCache();
+    // budget为内存预算（字节）按一张整屏RGB565计算可缓存的张数
+    void begin(uint32_t budget, uint16_t width, uint16_t height);
+    void end();
+    // 选中将要显示的图片 命中时返回true 之后read_line()可以读出它的各行
+    bool select(File_Info *key);
+    // 从选中的图片中读取一行（供LVGL的jpg解码器使用）path不是选中的图片时返回false
+    bool read_line(const char *path, int16_t x, int16_t y, uint16_t len, uint16_t *buf);
+    void release();
+    // 显示完当前图片后调用 后台预解码next与prev（next优先） 其他缓存（包括选中的图片）被回收
+    void prefetch(File_Info *next, const char *next_path, File_Info *prev, const char *prev_path);
+    void report(const char *tag);
+
+private:
+    CacheSlot *find_slot(File_Info *key);
+    bool decode_slot(CacheSlot *slot);
+    static bool decode_output(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap);
+    static void decode_task(void *parameter);
+};
+
+#endif
@@ -10,10 +10,6 @@ extern "C"
 #endif
 
 #include "lvgl.h"
-#define ANIEND                      \
-    while (lv_anim_count_running()) \
-        lv_task_handler(); //等待动画完成
-
     void photo_gui_init(void);
     void display_photo_init(void);
     void display_photo(const char *file_name, lv_scr_load_anim_t anim_type);
@@ -32,6 +32,7 @@ void start_web_config()
     server.on("/upload", File_Upload);
     server.on("/delete", File_Delete);
     server.on("/delete_result", delete_result);
+    server.on("/perf", perf_query);
 
     server.on("/sys_setting", sys_setting);
     server.on("/rgb_setting", rgb_setting);
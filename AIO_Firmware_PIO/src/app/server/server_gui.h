@@ -9,10 +9,6 @@ extern "C"
 #endif
 
 #include "lvgl.h"
-#define ANIEND                      \
-    while (lv_anim_count_running()) \
-        lv_task_handler(); //等待动画完成
-
     void server_gui_init(void);
     void display_setting_init(void);
     void display_setting(const char *title, const char *domain,
@@ -6,6 +6,7 @@
 #include "server.h"
 #include "web_setting.h"
 #include "app/app_conf.h"
+#include "app/media_player/mjpeg_index.h"
 #include "FS.h"
 #include "HardwareSerial.h"
 #include <esp32-hal.h>
@@ -63,6 +64,7 @@ String file_size(int bytes)
                     "<label class=\"input hidden\"><span>操作方向（0~15可選）</span><input type=\"text\"name=\"mpu_order\"value=\"%s\"></label>"                                                                                                                       \
                     "<label class=\"input\"><span>MPU6050自動校準</span><input class=\"radio\" type=\"radio\" value=\"0\" name=\"auto_calibration_mpu\" %s>關閉<input class=\"radio\" type=\"radio\" value=\"1\" name=\"auto_calibration_mpu\" %s>開啟</label>" \
                     "<label class=\"input\"><span>開機自啟的APP名字</span><input type=\"text\"name=\"auto_start_app\"value=\"%s\"></label>"                                                                                                                      \
+                    "<label class=\"input\"><span>圖片緩存（KB 0不緩存）</span><input type=\"text\"name=\"img_cache_kb\"value=\"%s\"></label>"                                                                                                                         \
                     "</label><input class=\"btn\" type=\"submit\" name=\"submit\" value=\"保存\"></form>"
 
 #define RGB_SETTING "<form method=\"GET\" action=\"saveRgbConf\">"                                                                                             \
@@ -123,11 +125,13 @@ String file_size(int bytes)
 
 #define PICTURE_SETTING "<form method=\"GET\" action=\"savePictureConf\">"                                                                                         \
                         "<label class=\"input\"><span>自動切換時間間隔（毫秒）</span><input type=\"text\"name=\"switchInterval\"value=\"%s\"></label>" \
+                        "<label class=\"input\"><span>預解碼快取（KB 0不使用）</span><input type=\"text\"name=\"cacheKB\"value=\"%s\"></label>"        \
                         "</label><input class=\"btn\" type=\"submit\" name=\"submit\" value=\"保存\"></form>"
 
 #define MEDIA_SETTING "<form method=\"GET\" action=\"saveMediaConf\">"                                                                                             \
                       "<label class=\"input\"><span>自動切換（0不切換 1自動切換）</span><input type=\"text\"name=\"switchFlag\"value=\"%s\"></label>" \
                       "<label class=\"input\"><span>功耗控制（0低發熱 1性能優先）</span><input type=\"text\"name=\"powerFlag\"value=\"%s\"></label>"  \
+                      "<label class=\"input\"><span>播放幀率（0不控制播放速度）</span><input type=\"text\"name=\"targetFps\"value=\"%s\"></label>" \
                       "</label><input class=\"btn\" type=\"submit\" name=\"submit\" value=\"保存\"></form>"
 
 #define SCREEN_SETTING "<form method=\"GET\" action=\"saveScreenConf\">"                                                                                           \
@@ -269,6 +273,7 @@ void sys_setting()
     char time[32];
     char auto_calibration_mpu[32];
     char auto_start_app[32];
+    char img_cache_kb[32];
     // 讀取數據
     app_controller->send_to(SERVER_APP_NAME, "AppCtrl", APP_MESSAGE_READ_CFG,
                             NULL, NULL);
@@ -294,6 +299,8 @@ void sys_setting()
                             (void *)"auto_calibration_mpu", auto_calibration_mpu);
     app_controller->send_to(SERVER_APP_NAME, "AppCtrl", APP_MESSAGE_GET_PARAM,
                             (void *)"auto_start_app", auto_start_app);
+    app_controller->send_to(SERVER_APP_NAME, "AppCtrl", APP_MESSAGE_GET_PARAM,
+                            (void *)"img_cache_kb", img_cache_kb);
     SysUtilConfig cfg = app_controller->sys_cfg;
     // 主要為了處理啟停MPU自動校準的單選框
     if (0 == cfg.auto_calibration_mpu)
@@ -302,7 +309,7 @@ void sys_setting()
                 ssid_0, password_0,
                 power_mode, backLight, rotation,
                 mpu_order, "checked=\"checked\"", "",
-                auto_start_app);
+                auto_start_app, img_cache_kb);
     }
     else
     {
@@ -310,7 +317,7 @@ void sys_setting()
                 ssid_0, password_0,
                 power_mode, backLight, rotation,
                 mpu_order, "", "checked=\"checked\"",
-                auto_start_app);
+                auto_start_app, img_cache_kb);
     }
     webpage = buf;
     Send_HTML(webpage);
@@ -459,12 +466,15 @@ void picture_setting()
 {
     char buf[2048];
     char switchInterval[32];
+    char cacheKB[32];
     // 讀取數據
     app_controller->send_to(SERVER_APP_NAME, "Picture", APP_MESSAGE_READ_CFG,
                             NULL, NULL);
     app_controller->send_to(SERVER_APP_NAME, "Picture", APP_MESSAGE_GET_PARAM,
                             (void *)"switchInterval", switchInterval);
-    sprintf(buf, PICTURE_SETTING, switchInterval);
+    app_controller->send_to(SERVER_APP_NAME, "Picture", APP_MESSAGE_GET_PARAM,
+                            (void *)"cacheKB", cacheKB);
+    sprintf(buf, PICTURE_SETTING, switchInterval, cacheKB);
     webpage = buf;
     Send_HTML(webpage);
 }
@@ -474,6 +484,7 @@ void media_setting()
     char buf[2048];
     char switchFlag[32];
     char powerFlag[32];
+    char targetFps[32];
     // 讀取數據
     app_controller->send_to(SERVER_APP_NAME, "Media", APP_MESSAGE_READ_CFG,
                             NULL, NULL);
@@ -481,7 +492,9 @@ void media_setting()
                             (void *)"switchFlag", switchFlag);
     app_controller->send_to(SERVER_APP_NAME, "Media", APP_MESSAGE_GET_PARAM,
                             (void *)"powerFlag", powerFlag);
-    sprintf(buf, MEDIA_SETTING, switchFlag, powerFlag);
+    app_controller->send_to(SERVER_APP_NAME, "Media", APP_MESSAGE_GET_PARAM,
+                            (void *)"targetFps", targetFps);
+    sprintf(buf, MEDIA_SETTING, switchFlag, powerFlag, targetFps);
     webpage = buf;
     Send_HTML(webpage);
 }
@@ -611,6 +624,10 @@ void saveSysConf(void)
                             APP_MESSAGE_SET_PARAM,
                             (void *)"auto_start_app",
                             (void *)server.arg("auto_start_app").c_str());
+    app_controller->send_to(SERVER_APP_NAME, "AppCtrl",
+                            APP_MESSAGE_SET_PARAM,
+                            (void *)"img_cache_kb",
+                            (void *)server.arg("img_cache_kb").c_str());
     // 持久化資料
     app_controller->send_to(SERVER_APP_NAME, "AppCtrl", APP_MESSAGE_WRITE_CFG,
                             NULL, NULL);
@@ -738,6 +755,10 @@ void savePictureConf(void)
                             APP_MESSAGE_SET_PARAM,
                             (void *)"switchInterval",
                             (void *)server.arg("switchInterval").c_str());
+    app_controller->send_to(SERVER_APP_NAME, "Picture",
+                            APP_MESSAGE_SET_PARAM,
+                            (void *)"cacheKB",
+                            (void *)server.arg("cacheKB").c_str());
     // 持久化資料
     app_controller->send_to(SERVER_APP_NAME, "Picture", APP_MESSAGE_WRITE_CFG,
                             NULL, NULL);
@@ -754,6 +775,10 @@ void saveMediaConf(void)
                             APP_MESSAGE_SET_PARAM,
                             (void *)"powerFlag",
                             (void *)server.arg("powerFlag").c_str());
+    app_controller->send_to(SERVER_APP_NAME, "Media",
+                            APP_MESSAGE_SET_PARAM,
+                            (void *)"targetFps",
+                            (void *)server.arg("targetFps").c_str());
     // 持久化資料
     app_controller->send_to(SERVER_APP_NAME, "Media", APP_MESSAGE_WRITE_CFG,
                             NULL, NULL);
@@ -847,6 +872,27 @@ void savePCResourceConf(void)
                             NULL, NULL);
 }
 
+void perf_query(void)
+{
+    // /perf?overlay=1 打开左上角的性能浮窗 overlay=0 关闭 返回最近一秒的统计（JSON）
+    if (server.hasArg("overlay"))
+    {
+        screen.setOverlay(server.arg("overlay").toInt() != 0);
+    }
+    DispStats stats;
+    screen.getStats(&stats);
+    char json[320];
+    snprintf(json, sizeof(json),
+             "{\"overlay\":%d,\"fps\":%u.%u,\"frames\":%u,\"elapsed_ms\":%u,"
+             "\"render_us\":%u,\"flush_us\":%u,\"area_px\":%u,"
+             "\"heap_free\":%u,\"heap_largest\":%u,\"heap_min\":%u,\"img_cache\":%u}",
+             screen.isOverlay(), stats.fps_x10 / 10, stats.fps_x10 % 10, stats.frames, stats.elapsed_ms,
+             stats.render_us, stats.flush_us, stats.area_px,
+             stats.heap_free, stats.heap_largest, stats.heap_min, stats.img_cache);
+    server.sendHeader("Cache-Control", "no-cache");
+    server.send(200, "application/json", json);
+}
+
 void File_Delete()
 {
     Send_HTML(
@@ -936,6 +982,13 @@ void handleFileUpload()
         else if (filename.endsWith(".mjpeg") || filename.endsWith(".MJPEG"))
         {
             filename = "/movie/" + filename;
+            // 删除旧视频的帧索引 上传完成后重新生成
+            char idx_path[FILENAME_MAX_LEN];
+            MjpegIndex::get_index_path(idx_path, filename.c_str());
+            if (SD.exists(idx_path))
+            {
+                tf.deleteFile(idx_path);
+            }
         }
         else
         {
@@ -961,6 +1014,11 @@ void handleFileUpload()
             UploadFile.close(); // Close the file again
             Serial.print(F("Upload Size: "));
             Serial.println(uploadFileStream.totalSize);
+            if (filename.endsWith(".mjpeg") || filename.endsWith(".MJPEG"))
+            {
+                // 生成帧索引 播放时可直接定位、续播与丢帧
+                MjpegIndex::build(("/movie/" + filename).c_str());
+            }
             webpage = webpage_header;
             webpage += F("<h3>File was successfully uploaded</h3>");
             webpage += F("<h2>Uploaded File Name: ");
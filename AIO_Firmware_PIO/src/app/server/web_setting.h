@@ -14,6 +14,7 @@ void File_Upload(void);
 void File_Delete(void);
 void delete_result(void);
 void handleFileUpload(void);
+void perf_query(void);
 
 void sys_setting(void);
 void rgb_setting(void);
@@ -178,7 +178,7 @@ static void settings_process(AppController *sys,
     {
         sys->send_to(SETTINGS_APP_NAME, CTRL_NAME,
                      APP_MESSAGE_WIFI_CONN, NULL, NULL);
-        delay(500);
+        screen.lvglDelay(500);
     }
 
     if (Serial.available())
@@ -194,7 +194,7 @@ static void settings_process(AppController *sys,
             Serial.write(run_data->recv_buf, len);
             analysis_uart_data(run_data->recv_len, run_data->recv_buf);
         }
-        delay(50);
+        screen.lvglDelay(50);
     }
     else
     {
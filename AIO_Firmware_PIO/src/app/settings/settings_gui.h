@@ -7,10 +7,6 @@ extern "C"
 #endif
 
 #include "lvgl.h"
-#define ANIEND                      \
-    while (lv_anim_count_running()) \
-        lv_task_handler(); //等待动画完成
-
     void settings_gui_init(void);
     void display_settings(const char *cur_ver, const char *new_ver, lv_scr_load_anim_t anim_type);
     void settings_gui_del(void);
@@ -220,7 +220,7 @@ static void tomato_process(AppController *sys, const ImuAction *act_info)
     static int count_down_reset = ON;
     if (!hadOpened)
     {
-        delay(750);
+        screen.lvglDelay(750);
         run_data->time_start = millis();
         hadOpened = true;
     }
@@ -307,7 +307,7 @@ static void tomato_process(AppController *sys, const ImuAction *act_info)
                         if (run_data->time_mode >= -1 && run_data->time_mode <= 2)
                         {
                             run_data->t_start.minute = 5;
-                            delay(50);
+                            screen.lvglDelay(50);
                             run_data->time_start = millis();
                         }
                     }
@@ -318,7 +318,7 @@ static void tomato_process(AppController *sys, const ImuAction *act_info)
                         if (run_data->time_mode >= -1 && run_data->time_mode <= 2)
                         {
                             run_data->t_start.minute = 45;
-                            delay(50);
+                            screen.lvglDelay(50);
                             run_data->time_start = millis();
                         }
                     }
@@ -361,7 +361,7 @@ static void tomato_process(AppController *sys, const ImuAction *act_info)
     }
     // Serial.print(run_data->rgb_fast);
     display_tomato(run_data->t, run_data->time_mode);
-    delay(100);
+    screen.lvglDelay(100);
 }
 
 static int tomato_exit_callback(void *param)
@@ -16,10 +16,6 @@ extern "C"
 
 
 #include "lvgl.h"
-#define ANIEND                      \
-    while (lv_anim_count_running()) \
-        lv_task_handler(); //等待动画完成
-
     void tomato_gui_init(void);
     void tomato_gui_del(void);
    void display_tomato(struct TimeStr t,int mode);
@@ -456,6 +456,7 @@ static int weather_init(AppController *sys)
     // 强制更新
     run_data->coactusUpdateFlag = 0x01;
     run_data->update_type = 0x00; // 表示什么也不需要更新
+    screen.perfReset(); // 退出时打印天气界面的刷新帧率
 
     // 目前更新数据的任务栈大小5000够用，4000不够用
     // 为了后期迭代新功能 当前设置为8000
@@ -484,7 +485,7 @@ static void weather_process(AppController *sys,
     {
         // 间接强制更新
         run_data->coactusUpdateFlag = 0x01;
-        delay(500); // 以防间接强制更新后，生产很多请求 使显示卡顿
+        screen.lvglDelay(500); // 以防间接强制更新后，生产很多请求 使显示卡顿
     }
    
 
@@ -512,13 +513,13 @@ static void weather_process(AppController *sys,
         }
         run_data->coactusUpdateFlag = 0x00; // 取消强制更新标志
         display_space();
-        delay(30);
+        screen.lvglDelay(30);
     }
     else if (run_data->clock_page == 1)
     {
         // 仅在切换界面时获取一次未来天气
         display_curve(run_data->wea.daily_max, run_data->wea.daily_min, anim_type);
-        delay(300);
+        screen.lvglDelay(300);
     }
 }
 
@@ -531,6 +532,7 @@ static void weather_background_task(AppController *sys,
 
 static int weather_exit_callback(void *param)
 {
+    screen.perfReport("weather");
     weather_gui_del();
 
     // 查杀异步任务
@@ -35,10 +35,6 @@ extern "C"
 
 #include "lvgl.h"
 
-#define ANIEND                      \
-    while (lv_anim_count_running()) \
-        lv_task_handler(); //等待动画完成
-
     void weather_gui_init(void);
     void display_curve_init(lv_scr_load_anim_t anim_type);
     void display_curve(short maxT[], short minT[], lv_scr_load_anim_t anim_type);
@@ -275,7 +275,7 @@ static void weather_process(AppController *sys,
         display_hardware_old(NULL, anim_type);
     }
 
-    delay(300);
+    screen.lvglDelay(300);
 }
 
 static void weather_background_task(AppController *sys,
@@ -7,10 +7,6 @@ extern "C"
 #endif
 
 #include "lvgl.h"
-#define ANIEND                      \
-    while (lv_anim_count_running()) \
-        lv_task_handler(); //等待动画完成
-
     void weather_old_gui_init(void);
     void display_hardware_old(const char *info, lv_scr_load_anim_t anim_type);
     void display_weather_old(const char *cityname, const char *temperature,
@@ -11,7 +11,7 @@ Display screen;     // 屏幕对象
 Ambient ambLight;   // 光线传感器对象
 
 // lvgl handle的锁
-SemaphoreHandle_t lvgl_mutex = xSemaphoreCreateMutex();
+SemaphoreHandle_t lvgl_mutex = xSemaphoreCreateRecursiveMutex();
 
 boolean doDelayMillisTime(unsigned long interval, unsigned long *previousMillis, boolean state)
 {
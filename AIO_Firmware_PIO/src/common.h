@@ -69,14 +69,14 @@ boolean doDelayMillisTime(unsigned long interval,
 #define TASK_RGB_PRIORITY 0  // RGB的任务优先级
 #define TASK_LVGL_PRIORITY 2 // LVGL的页面优先级
 
-// lvgl 操作的锁
+// lvgl 操作的锁（递归锁：loop()运行APP时已持有 APP中可以再次加锁）
 extern SemaphoreHandle_t lvgl_mutex;
 // LVGL操作的安全宏（避免脏数据）
-#define AIO_LVGL_OPERATE_LOCK(CODE)                          \
-    if (pdTRUE == xSemaphoreTake(lvgl_mutex, portMAX_DELAY)) \
-    {                                                        \
-        CODE;                                                \
-        xSemaphoreGive(lvgl_mutex);                          \
+#define AIO_LVGL_OPERATE_LOCK(CODE)                                   \
+    if (pdTRUE == xSemaphoreTakeRecursive(lvgl_mutex, portMAX_DELAY)) \
+    {                                                                 \
+        CODE;                                                         \
+        xSemaphoreGiveRecursive(lvgl_mutex);                          \
     }
 
 struct SysUtilConfig
@@ -93,6 +93,7 @@ struct SysUtilConfig
     uint8_t rotation;             // 屏幕旋转方向
     uint8_t auto_calibration_mpu; // 是否自动校准陀螺仪 0关闭自动校准 1打开自动校准
     uint8_t mpu_order;            // 操作方向
+    uint16_t img_cache_kb;        // LVGL图片缓存的内存预算（KB 0为不缓存）
 };
 
 #define GFX 0
@@ -2,28 +2,156 @@
 #include "network.h"
 #include "lv_port_indev.h"
 #include "lv_demo_encoder.h"
+#include "lv_port_img_cache.h"
 #include "common.h"
 
-#define LV_HOR_RES_MAX_LEN 80 // 24
+struct DispPerf
+{
+    uint32_t start;     // 开始统计的时间（ms）
+    uint32_t frames;    // 刷新的次数
+    uint32_t pixels;    // 刷新的像素数
+    uint32_t refr_ms;   // 刷新的总耗时（monitor_cb 包含等待发送）
+    uint32_t flush_us;  // 等待屏幕发送的耗时
+};
 
 static lv_disp_draw_buf_t disp_buf;
 static lv_disp_drv_t disp_drv;
-static lv_color_t buf[SCREEN_HOR_RES * LV_HOR_RES_MAX_LEN];
+static lv_color_t *buf[2] = {NULL, NULL};
+static lv_color_t lend_buf[SCREEN_HOR_RES * DISP_LEND_LINES]; // 借出或分配失败时使用
+static bool buf_lent = false; // 绘制缓冲已借出
+static bool disp_dma = false; // 是否使用DMA发送
+static DispPerf perf;
+static DispPerf mon;          // 性能浮窗/查询使用的统计周期（每DISP_MON_PERIOD毫秒清零）
+static DispStats mon_stats;   // 上一个统计周期的结果
+static lv_obj_t *overlay = NULL; // 性能浮窗（lv_layer_sys上的标签）
+
+struct UiPost
+{
+    UiCommand cmd;
+    void *param;
+};
+
+static TaskHandle_t lvgl_task = NULL;  // LVGL渲染任务
+static QueueHandle_t ui_queue = NULL; // 投递给渲染任务的UI操作
+
+static void add_flush_us(uint32_t us)
+{
+    perf.flush_us += us;
+    mon.flush_us += us;
+}
 
 void my_disp_flush(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p)
 {
     uint32_t w = (area->x2 - area->x1 + 1);
     uint32_t h = (area->y2 - area->y1 + 1);
+    unsigned long flush_start = micros();
+
+    if (!disp_dma)
+    {
+        tft->setAddrWindow(area->x1, area->y1, w, h);
+        tft->startWrite();
+        tft->pushColors(&color_p->full, w * h, true);
+        tft->endWrite();
+        lv_disp_flush_ready(disp);
+        add_flush_us(micros() - flush_start);
+        return;
+    }
 
-    tft->setAddrWindow(area->x1, area->y1, w, h);
-    tft->startWrite();
-    // tft->writePixels(&color_p->full, w * h);
-    tft->pushColors(&color_p->full, w * h, true);
-    tft->endWrite();
-    // Initiate DMA - blocking only if last DMA is not complete
-    // tft->pushImageDMA(area->x1, area->y1, w, h, bitmap, &color_p->full);
+    // LV_COLOR_16_SWAP为0 发送前在缓冲上原地交换字节（其他APP可能改过swapBytes 用完恢复）
+    bool swap = tft->getSwapBytes();
+    tft->setSwapBytes(true);
+    // 上一块还在发送时先等待 之后发起DMA立即返回
+    tft->pushImageDMA(area->x1, area->y1, w, h, &color_p->full);
+    tft->setSwapBytes(swap);
 
+    if (lv_disp_flush_is_last(disp))
+    {
+        // 一帧的最后一块等待发送完毕 lv_timer_handler返回后其他地方可以直接操作屏幕
+        tft->dmaWait();
+        lv_disp_flush_ready(disp);
+    }
+    // 否则LVGL继续渲染另一块缓冲 需要这块缓冲时由my_disp_wait等待DMA完成
+    add_flush_us(micros() - flush_start);
+}
+
+void my_disp_wait(lv_disp_drv_t *disp)
+{
+    // DMA完成前阻塞（让出CPU） 完成后通知LVGL缓冲已空闲
+    unsigned long wait_start = micros();
+    tft->dmaWait();
     lv_disp_flush_ready(disp);
+    add_flush_us(micros() - wait_start);
+}
+
+void my_disp_monitor(lv_disp_drv_t *disp, uint32_t time, uint32_t px)
+{
+    ++perf.frames;
+    perf.pixels += px;
+    perf.refr_ms += time;
+    ++mon.frames;
+    mon.pixels += px;
+    mon.refr_ms += time;
+}
+
+static void calc_stats(const DispPerf *p, uint32_t elapsed, DispStats *stats)
+{
+    memset(stats, 0, sizeof(DispStats));
+    stats->elapsed_ms = elapsed;
+    stats->frames = p->frames;
+    if (0 != p->frames && 0 != elapsed)
+    {
+        // render为刷新总耗时减去等待发送的部分
+        uint32_t refr_us = p->refr_ms * 1000;
+        uint32_t render_us = refr_us > p->flush_us ? refr_us - p->flush_us : 0;
+        stats->fps_x10 = p->frames * 10000 / elapsed;
+        stats->render_us = render_us / p->frames;
+        stats->flush_us = p->flush_us / p->frames;
+        stats->area_px = p->pixels / p->frames;
+    }
+    // LV_MEM_CUSTOM为1 LVGL直接使用系统堆 按系统堆统计
+    stats->heap_free = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    stats->heap_largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    stats->heap_min = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    lv_port_img_cache_stat_t cache;
+    lv_port_img_cache_get_stat(&cache);
+    stats->img_cache = cache.bytes;
+}
+
+static void monitor_timer_cb(lv_timer_t *timer)
+{
+    calc_stats(&mon, millis() - mon.start, &mon_stats);
+    memset(&mon, 0, sizeof(mon));
+    mon.start = millis();
+    // 借出期间屏幕归APP所有 浮窗已隐藏 统计仍可从串口或/perf查询
+    if (NULL == overlay || buf_lent)
+    {
+        return;
+    }
+    // 浮窗本身的刷新也计入下一个周期（约每秒一次 很小的区域）
+    lv_label_set_text_fmt(overlay, "%u.%u fps  area %u px\nrender %u.%u ms  flush %u.%u ms\nheap %uK  max %uK  img %uK",
+                          mon_stats.fps_x10 / 10, mon_stats.fps_x10 % 10, mon_stats.area_px,
+                          mon_stats.render_us / 1000, mon_stats.render_us / 100 % 10,
+                          mon_stats.flush_us / 1000, mon_stats.flush_us / 100 % 10,
+                          mon_stats.heap_free / 1024, mon_stats.heap_largest / 1024,
+                          mon_stats.img_cache / 1024);
+}
+
+static void alloc_draw_buf(void)
+{
+    // 两块缓冲都需要DMA可访问的内存 第二块分配失败时退回单缓冲 都失败时使用静态的小缓冲
+    uint32_t buf_size = SCREEN_HOR_RES * DISP_BUF_LINES;
+    buf[0] = (lv_color_t *)heap_caps_malloc(buf_size * sizeof(lv_color_t), MALLOC_CAP_DMA);
+    buf[1] = NULL == buf[0] ? NULL : (lv_color_t *)heap_caps_malloc(buf_size * sizeof(lv_color_t), MALLOC_CAP_DMA);
+    if (NULL == buf[0])
+    {
+        lv_disp_draw_buf_init(&disp_buf, lend_buf, NULL, SCREEN_HOR_RES * DISP_LEND_LINES);
+    }
+    else
+    {
+        lv_disp_draw_buf_init(&disp_buf, buf[0], buf[1], buf_size);
+    }
+    Serial.printf("LVGL draw buf %u lines x%d dma %d\n",
+                  NULL == buf[0] ? DISP_LEND_LINES : DISP_BUF_LINES, NULL == buf[1] ? 1 : 2, disp_dma);
 }
 
 void Display::init(uint8_t rotation, uint8_t backLight)
@@ -50,22 +178,134 @@ void Display::init(uint8_t rotation, uint8_t backLight)
 
     setBackLight(backLight / 100.0); // 设置亮度
 
-    lv_disp_draw_buf_init(&disp_buf, buf, NULL, SCREEN_HOR_RES * LV_HOR_RES_MAX_LEN);
+    tft->initDMA();
+    disp_dma = tft->DMA_Enabled;
+    alloc_draw_buf();
 
     /*Initialize the display*/
     lv_disp_drv_init(&disp_drv);
     disp_drv.hor_res = SCREEN_HOR_RES;
     disp_drv.ver_res = SCREEN_VER_RES;
     disp_drv.flush_cb = my_disp_flush;
+    disp_drv.wait_cb = my_disp_wait;
+    disp_drv.monitor_cb = my_disp_monitor;
     disp_drv.draw_buf = &disp_buf;
     disp_drv.user_data = tft;
     // 开启 LV_COLOR_SCREEN_TRANSP 屏幕具有透明和不透明样式
     lv_disp_drv_register(&disp_drv);
+    perfReset();
+    memset(&mon, 0, sizeof(mon));
+    mon.start = millis();
+    lv_timer_create(monitor_timer_cb, DISP_MON_PERIOD, NULL);
 }
 
 void Display::routine()
 {
-    AIO_LVGL_OPERATE_LOCK(lv_timer_handler();)
+    if (NULL != lvgl_task)
+    {
+        return; // 由渲染任务刷新
+    }
+    AIO_LVGL_OPERATE_LOCK(runPosted(); lv_timer_handler();)
+}
+
+static void task_lvgl_update(void *parameter)
+{
+    Display *display = (Display *)parameter;
+    const TickType_t period = pdMS_TO_TICKS(LV_DISP_DEF_REFR_PERIOD);
+    TickType_t last_wake = xTaskGetTickCount();
+    for (;;)
+    {
+        AIO_LVGL_OPERATE_LOCK(display->runPosted(); lv_timer_handler();)
+        if (xTaskGetTickCount() - last_wake >= period)
+        {
+            // 等锁或渲染超过了一帧 不追赶落下的帧 至少让出1个tick给APP拿锁
+            vTaskDelay(1);
+            last_wake = xTaskGetTickCount();
+        }
+        else
+        {
+            vTaskDelayUntil(&last_wake, period);
+        }
+    }
+}
+
+bool Display::startTask()
+{
+    if (NULL != lvgl_task)
+    {
+        return true;
+    }
+    ui_queue = xQueueCreate(DISP_UI_QUEUE_LEN, sizeof(UiPost));
+    if (NULL == ui_queue)
+    {
+        return false;
+    }
+    // 与loop()在同一个核上且优先级更高：APP让出锁时立即渲染
+    BaseType_t ret = xTaskCreatePinnedToCore(task_lvgl_update, "LvglThread", 8 * 1024, this,
+                                             TASK_LVGL_PRIORITY, &lvgl_task, ARDUINO_RUNNING_CORE);
+    if (pdPASS != ret)
+    {
+        lvgl_task = NULL;
+        Serial.println(F("LvglThread create failed, refresh in loop()"));
+        return false;
+    }
+    return true;
+}
+
+bool Display::post(UiCommand cmd, void *param)
+{
+    if (NULL == ui_queue)
+    {
+        // 没有渲染任务时直接执行
+        AIO_LVGL_OPERATE_LOCK(cmd(param);)
+        return true;
+    }
+    UiPost ui_post = {cmd, param};
+    return pdTRUE == xQueueSend(ui_queue, &ui_post, 0);
+}
+
+void Display::runPosted()
+{
+    UiPost ui_post;
+    while (NULL != ui_queue && pdTRUE == xQueueReceive(ui_queue, &ui_post, 0))
+    {
+        ui_post.cmd(ui_post.param);
+    }
+}
+
+void Display::lvglDelay(uint32_t ms)
+{
+    if (NULL == lvgl_task)
+    {
+        // 没有渲染任务时按原来的方式自己刷新
+        unsigned long start = millis();
+        do
+        {
+            lv_timer_handler();
+            delay(1);
+        } while (millis() - start < ms);
+        return;
+    }
+    // 只有当前任务持有锁时才让出（嵌套加锁时只是普通的延时）
+    bool held = xSemaphoreGetMutexHolder(lvgl_mutex) == xTaskGetCurrentTaskHandle();
+    if (held)
+    {
+        xSemaphoreGiveRecursive(lvgl_mutex);
+    }
+    delay(ms);
+    if (held)
+    {
+        xSemaphoreTakeRecursive(lvgl_mutex, portMAX_DELAY);
+    }
+}
+
+void Display::waitAnim(uint32_t timeout)
+{
+    unsigned long start = millis();
+    while (lv_anim_count_running() && millis() - start < timeout)
+    {
+        lvglDelay(LV_DISP_DEF_REFR_PERIOD);
+    }
 }
 
 void Display::setBackLight(float duty)
@@ -74,3 +314,108 @@ void Display::setBackLight(float duty)
     duty = 1 - duty;
     ledcWrite(LCD_BL_PWM_CHANNEL, (int)(duty * 255));
 }
+
+void Display::perfReset()
+{
+    memset(&perf, 0, sizeof(perf));
+    perf.start = millis();
+}
+
+void Display::perfReport(const char *tag)
+{
+    uint32_t elapsed = millis() - perf.start;
+    if (0 == perf.frames || 0 == elapsed)
+    {
+        perfReset();
+        return;
+    }
+    DispStats stats;
+    calc_stats(&perf, elapsed, &stats);
+    Serial.printf("LVGL %s: %u.%u fps (%u frames in %u ms) render %u us flush %u us per frame, %u px/frame\n",
+                  tag, stats.fps_x10 / 10, stats.fps_x10 % 10, stats.frames, elapsed,
+                  stats.render_us, stats.flush_us, stats.area_px);
+    perfReset();
+}
+
+void Display::getStats(DispStats *stats)
+{
+    *stats = mon_stats;
+}
+
+void Display::setOverlay(bool enable)
+{
+    // 需持有LVGL锁
+    if (enable == (NULL != overlay))
+    {
+        return;
+    }
+    if (!enable)
+    {
+        lv_obj_del(overlay);
+        overlay = NULL;
+        return;
+    }
+    // 放在系统层 切换APP（切换screen）时保持显示
+    overlay = lv_label_create(lv_layer_sys());
+    lv_obj_set_style_bg_color(overlay, lv_color_black(), 0);
+    lv_obj_set_style_bg_opa(overlay, LV_OPA_60, 0);
+    lv_obj_set_style_text_color(overlay, lv_color_white(), 0);
+    lv_obj_set_style_pad_all(overlay, 2, 0);
+    lv_obj_align(overlay, LV_ALIGN_TOP_LEFT, 0, 0);
+    lv_label_set_text(overlay, "LVGL perf ...");
+    if (buf_lent)
+    {
+        lv_obj_add_flag(overlay, LV_OBJ_FLAG_HIDDEN);
+    }
+}
+
+bool Display::isOverlay()
+{
+    return NULL != overlay;
+}
+
+uint32_t Display::lendDrawBuf(const char *tag)
+{
+    if (buf_lent)
+    {
+        return 0;
+    }
+    // 持有LVGL锁时没有正在进行的刷新 只需等最后一块DMA发送完
+    tft->dmaWait();
+    uint32_t free_before = ESP.getFreeHeap();
+    lv_disp_draw_buf_init(&disp_buf, lend_buf, NULL, SCREEN_HOR_RES * DISP_LEND_LINES);
+    heap_caps_free(buf[0]);
+    heap_caps_free(buf[1]);
+    buf[0] = NULL;
+    buf[1] = NULL;
+    lv_port_img_cache_purge();
+    // 屏幕归APP所有：暂停LVGL的刷新（其他定时器照常运行） 不再向屏幕发送也不和APP抢SPI总线
+    lv_timer_pause(lv_disp_get_default()->refr_timer);
+    if (NULL != overlay)
+    {
+        lv_obj_add_flag(overlay, LV_OBJ_FLAG_HIDDEN);
+    }
+    buf_lent = true;
+    uint32_t reclaimed = ESP.getFreeHeap() - free_before;
+    Serial.printf("Display %s: lend draw buf, reclaimed %u bytes, free heap %u largest %u\n",
+                  tag, reclaimed, ESP.getFreeHeap(), heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+    return reclaimed;
+}
+
+void Display::returnDrawBuf(const char *tag)
+{
+    if (!buf_lent)
+    {
+        return;
+    }
+    Serial.printf("Display %s: return draw buf, ", tag);
+    alloc_draw_buf();
+    buf_lent = false;
+    if (NULL != overlay)
+    {
+        lv_obj_clear_flag(overlay, LV_OBJ_FLAG_HIDDEN);
+    }
+    // APP画过的画面与LVGL的不一致 恢复刷新后整屏重绘
+    lv_timer_resume(lv_disp_get_default()->refr_timer);
+    lv_obj_invalidate(lv_scr_act());
+}
@@ -3,12 +3,61 @@
 
 #include <lvgl.h>
 
+// LVGL绘制缓冲的行数（两块缓冲交替 一块DMA发送时渲染另一块）可在build_flags中覆盖
+#ifndef DISP_BUF_LINES
+#define DISP_BUF_LINES 40
+#endif
+
+#define DISP_LEND_LINES 4     // 绘制缓冲借出期间LVGL使用的静态小缓冲的行数
+#define DISP_UI_QUEUE_LEN 16 // 投递的UI操作最多排队的个数
+#define DISP_MON_PERIOD 1000 // 性能浮窗/查询的统计周期（ms）
+
+typedef void (*UiCommand)(void *param);
+
+// 一个统计周期内的刷新性能与内存（每帧的值为周期内的平均值）
+struct DispStats
+{
+    uint32_t elapsed_ms;   // 统计的时长
+    uint32_t frames;       // 刷新的帧数
+    uint32_t fps_x10;      // 帧率x10
+    uint32_t render_us;    // 每帧渲染的耗时（不含等待发送）
+    uint32_t flush_us;     // 每帧等待屏幕发送的耗时
+    uint32_t area_px;      // 每帧刷新（失效区域）的像素数
+    uint32_t heap_free;    // 剩余的堆内存（LVGL使用系统的malloc）
+    uint32_t heap_largest; // 最大的连续空闲块
+    uint32_t heap_min;     // 开机以来剩余堆内存的最小值
+    uint32_t img_cache;    // LVGL图片缓存占用的内存
+};
+
 class Display
 {
 public:
     void init(uint8_t rotation, uint8_t backLight);
     void routine();
+    // 启动LVGL渲染任务（按LV_DISP_DEF_REFR_PERIOD调用lv_timer_handler） 之后routine不再刷新
+    bool startTask();
+    // 投递UI操作 由渲染任务在下一帧之前执行（供不持有LVGL锁的任务使用 目前只有game_2048）
+    // 其余APP仍在main_process中持锁直接操作LVGL 等待时用lvglDelay/waitAnim让出锁
+    bool post(UiCommand cmd, void *param = NULL);
+    // 立即执行已投递的UI操作（需持有LVGL锁 例如APP退出前）
+    void runPosted();
+    // 持有LVGL锁的APP中等待ms毫秒 期间让出锁由渲染任务刷新画面（代替循环调用lv_timer_handler）
+    void lvglDelay(uint32_t ms);
+    // 等待所有动画结束 最多等待timeout毫秒
+    void waitAnim(uint32_t timeout);
+    // 直接操作屏幕的APP运行期间借出LVGL的绘制缓冲（以及解码后的图片缓存） 返回回收的字节数
+    // 需在APP进程中（持有LVGL锁）调用 借出期间暂停LVGL的屏幕刷新 APP退出前用returnDrawBuf归还
+    uint32_t lendDrawBuf(const char *tag);
+    void returnDrawBuf(const char *tag);
     void setBackLight(float);
+    // 刷新性能统计：perfReset清零 perfReport打印自上次清零以来的帧率与渲染/发送耗时
+    void perfReset();
+    void perfReport(const char *tag);
+    // 最近一个统计周期（DISP_MON_PERIOD）的性能与内存 不影响perfReset/perfReport
+    void getStats(DispStats *stats);
+    // 运行时开关左上角的性能浮窗（需持有LVGL锁） 绘制缓冲借出期间隐藏
+    void setOverlay(bool enable);
+    bool isOverlay();
 };
 
 #endif
@@ -85,6 +85,18 @@ void lv_fs_fatfs_init(void)
     lv_fs_drv_register(&fs_drv);
 }
 
+lv_fs_res_t lv_fs_fatfs_stat(const char * path, uint32_t * size, uint32_t * mtime)
+{
+    /*与lv_fs_open相同 去掉盘符后交给FatFS*/
+    if(path[0] != LV_FS_FATFS_LETTER || path[1] != ':') return LV_FS_RES_INV_PARAM;
+
+    FILINFO info;
+    if(f_stat(path + 2, &info) != FR_OK) return LV_FS_RES_NOT_EX;
+    *size = info.fsize;
+    *mtime = (uint32_t)info.fdate << 16 | info.ftime;
+    return LV_FS_RES_OK;
+}
+
 /**********************
  *   STATIC FUNCTIONS
  **********************/
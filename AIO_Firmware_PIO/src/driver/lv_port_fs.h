@@ -31,6 +31,8 @@ extern "C" {
  * GLOBAL PROTOTYPES
  **********************/
 void lv_fs_fatfs_init(void);
+/*取得文件的大小与修改时间（FatFS的日期<<16|时间） path带盘符 例如 "S:/folder/file.bin"*/
+lv_fs_res_t lv_fs_fatfs_stat(const char * path, uint32_t * size, uint32_t * mtime);
 
 /**********************
  *      MACROS
@@ -0,0 +1,341 @@
+/**
+ * @file lv_port_img_cache.c
+ * LV_IMG_CACHE_DEF_SIZE为0时每次重绘都要重新打开图片并逐行解码（SD卡上的.bin、索引色图标等）
+ * 此解码器最后注册（最先被尝试） 把其他解码器的结果整张解码到内存中
+ * 缓存总大小不超过预算（字节） 超出时淘汰最久未使用的图片
+ * 内存中可以直接绘制的图片（变量形式的真彩色图片）不缓存
+ * 文件图片以路径、文件大小与修改时间为键 文件被替换后重新解码
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_port_img_cache.h"
+#include "lv_port_fs.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define REJECT_NUM 8 /*记住最近不缓存的图片（避免每次重绘都多读一次图片头）*/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct {
+    const void * src;        /*变量图片为原指针 文件为复制的路径（NULL表示空闲）*/
+    lv_img_src_t src_type;
+    lv_img_header_t header;  /*缓存后的格式*/
+    uint8_t * data;
+    uint32_t size;
+    uint32_t last_use;       /*最近使用的序号（LRU）*/
+    uint16_t refs;           /*正在使用的次数（使用中的不淘汰）*/
+    uint32_t file_size;      /*文件图片的大小与修改时间（与文件不一致时失效）*/
+    uint32_t mtime;
+    uint32_t check_tick;     /*上次检查文件的时间*/
+    bool stale;              /*文件已变化 仍在使用 关闭后释放*/
+} img_cache_entry_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static lv_res_t cache_info(lv_img_decoder_t * decoder, const void * src, lv_img_header_t * header);
+static lv_res_t cache_open(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc);
+static void cache_close(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc);
+static img_cache_entry_t * find_entry(const void * src);
+static img_cache_entry_t * load_entry(const void * src, lv_color_t color, int32_t frame_id);
+static bool make_room(uint32_t size, bool need_slot);
+static void free_entry(img_cache_entry_t * entry);
+static lv_img_cf_t cached_cf(lv_img_src_t src_type, lv_img_cf_t cf);
+static uint32_t px_size(lv_img_cf_t cf);
+static uint32_t src_hash(const void * src);
+static void stat_src(const char * path, uint32_t * size, uint32_t * mtime);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static img_cache_entry_t entries[LV_PORT_IMG_CACHE_MAX_ENTRY];
+static lv_port_img_cache_stat_t stat;
+static uint32_t use_tick;
+static bool bypass; /*正在通过其他解码器解码（自己的回调不响应）*/
+static uint32_t rejects[REJECT_NUM];
+static uint8_t reject_pos;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void lv_port_img_cache_init(void)
+{
+    lv_memset_00(entries, sizeof(entries));
+    lv_memset_00(&stat, sizeof(stat));
+    stat.budget = LV_PORT_IMG_CACHE_BUDGET;
+
+    lv_img_decoder_t * dec = lv_img_decoder_create();
+    lv_img_decoder_set_info_cb(dec, cache_info);
+    lv_img_decoder_set_open_cb(dec, cache_open);
+    lv_img_decoder_set_close_cb(dec, cache_close);
+}
+
+void lv_port_img_cache_set_budget(uint32_t budget)
+{
+    stat.budget = budget;
+    lv_memset_00(rejects, sizeof(rejects));
+    make_room(0, false);
+}
+
+void lv_port_img_cache_purge(void)
+{
+    for(uint16_t i = 0; i < LV_PORT_IMG_CACHE_MAX_ENTRY; i++) {
+        if(entries[i].src != NULL && entries[i].refs == 0) free_entry(&entries[i]);
+    }
+    lv_memset_00(rejects, sizeof(rejects));
+}
+
+void lv_port_img_cache_get_stat(lv_port_img_cache_stat_t * s)
+{
+    *s = stat;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static lv_img_cf_t cached_cf(lv_img_src_t src_type, lv_img_cf_t cf)
+{
+    switch(cf) {
+        case LV_IMG_CF_TRUE_COLOR:
+        case LV_IMG_CF_TRUE_COLOR_ALPHA:
+        case LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED:
+            /*变量形式的真彩色图片本来就可以直接绘制*/
+            return src_type == LV_IMG_SRC_FILE ? cf : LV_IMG_CF_UNKNOWN;
+        case LV_IMG_CF_INDEXED_1BIT:
+        case LV_IMG_CF_INDEXED_2BIT:
+        case LV_IMG_CF_INDEXED_4BIT:
+        case LV_IMG_CF_INDEXED_8BIT:
+            /*内置解码器按行输出带透明度的真彩色*/
+            return LV_IMG_CF_TRUE_COLOR_ALPHA;
+        default:
+            return LV_IMG_CF_UNKNOWN;
+    }
+}
+
+static uint32_t px_size(lv_img_cf_t cf)
+{
+    return cf == LV_IMG_CF_TRUE_COLOR_ALPHA ? LV_IMG_PX_SIZE_ALPHA_BYTE : LV_COLOR_SIZE / 8;
+}
+
+static uint32_t src_hash(const void * src)
+{
+    /*FNV-1a 变量图片使用指针的值*/
+    if(lv_img_src_get_type(src) == LV_IMG_SRC_VARIABLE) return (uint32_t)(uintptr_t)src | 1;
+    uint32_t hash = 2166136261UL;
+    for(const char * c = src; *c; c++) hash = (hash ^ (uint8_t)*c) * 16777619UL;
+    return hash | 1; /*0表示空*/
+}
+
+static void stat_src(const char * path, uint32_t * size, uint32_t * mtime)
+{
+    /*派生的图片源（例如缩略图"a.mjpeg.thumb"）不存在时 使用去掉最后一个后缀的原文件*/
+    *size = 0;
+    *mtime = 0;
+    if(lv_fs_fatfs_stat(path, size, mtime) == LV_FS_RES_OK) return;
+
+    const char * dot = strrchr(path, '.');
+    char buf[128];
+    if(dot == NULL || dot - path >= (int32_t)sizeof(buf)) return;
+    lv_memcpy(buf, path, dot - path);
+    buf[dot - path] = '\0';
+    lv_fs_fatfs_stat(buf, size, mtime);
+}
+
+static img_cache_entry_t * find_entry(const void * src)
+{
+    lv_img_src_t src_type = lv_img_src_get_type(src);
+    for(uint16_t i = 0; i < LV_PORT_IMG_CACHE_MAX_ENTRY; i++) {
+        img_cache_entry_t * e = &entries[i];
+        if(e->src == NULL || e->src_type != src_type || e->stale) continue;
+        if(src_type == LV_IMG_SRC_VARIABLE) {
+            if(e->src == src) return e;
+            continue;
+        }
+        if(strcmp(e->src, src)) continue;
+
+        /*同一路径的文件可能已被替换 每隔一段时间比较一次大小与修改时间*/
+        if(lv_tick_elaps(e->check_tick) < LV_PORT_IMG_CACHE_CHECK_MS) return e;
+        uint32_t size;
+        uint32_t mtime;
+        stat_src(src, &size, &mtime);
+        if(size == e->file_size && mtime == e->mtime) {
+            e->check_tick = lv_tick_get();
+            return e;
+        }
+        if(e->refs == 0) free_entry(e);
+        else e->stale = true;
+        return NULL;
+    }
+    return NULL;
+}
+
+static void free_entry(img_cache_entry_t * entry)
+{
+    if(entry->src_type == LV_IMG_SRC_FILE) lv_mem_free((void *)entry->src);
+    lv_mem_free(entry->data);
+    stat.bytes -= entry->size;
+    stat.entries--;
+    lv_memset_00(entry, sizeof(img_cache_entry_t));
+}
+
+static bool make_room(uint32_t size, bool need_slot)
+{
+    /*淘汰最久未使用的图片 直到放得下size字节（need_slot时还需要有空闲的位置）*/
+    while(true) {
+        img_cache_entry_t * lru = NULL;
+        bool has_free = false;
+        for(uint16_t i = 0; i < LV_PORT_IMG_CACHE_MAX_ENTRY; i++) {
+            img_cache_entry_t * e = &entries[i];
+            if(e->src == NULL) {
+                has_free = true;
+                continue;
+            }
+            if(e->refs == 0 && (lru == NULL || e->last_use < lru->last_use)) lru = e;
+        }
+        if((has_free || !need_slot) && stat.bytes + size <= stat.budget) return true;
+        if(lru == NULL) return false;
+        free_entry(lru);
+        stat.evictions++;
+    }
+}
+
+static img_cache_entry_t * load_entry(const void * src, lv_color_t color, int32_t frame_id)
+{
+    /*解码前记下文件的状态 解码期间文件被替换时下次检查会发现*/
+    uint32_t file_size = 0;
+    uint32_t mtime = 0;
+    if(lv_img_src_get_type(src) == LV_IMG_SRC_FILE) stat_src(src, &file_size, &mtime);
+
+    lv_img_decoder_dsc_t inner;
+    bypass = true;
+    lv_res_t res = lv_img_decoder_open(&inner, src, color, frame_id);
+    bypass = false;
+    if(res != LV_RES_OK) return NULL;
+
+    lv_img_cf_t cf = cached_cf(inner.src_type, inner.header.cf);
+    uint32_t px = px_size(cf);
+    uint32_t size = inner.header.w * inner.header.h * px;
+    uint8_t * data = NULL;
+    if(cf != LV_IMG_CF_UNKNOWN && size <= stat.budget && make_room(size, true)) {
+        data = lv_mem_alloc(size);
+    }
+    if(data != NULL && inner.img_data != NULL) {
+        /*整张已在内存中（例如缩略图） 格式不变时直接复制*/
+        if(cf == inner.header.cf) {
+            lv_memcpy(data, inner.img_data, size);
+        }
+        else {
+            lv_mem_free(data);
+            data = NULL;
+        }
+    }
+    else if(data != NULL) {
+        for(lv_coord_t y = 0; y < inner.header.h; y++) {
+            if(lv_img_decoder_read_line(&inner, 0, y, inner.header.w, data + y * inner.header.w * px) != LV_RES_OK) {
+                lv_mem_free(data);
+                data = NULL;
+                break;
+            }
+        }
+    }
+    lv_img_header_t header = inner.header;
+    lv_img_decoder_close(&inner);
+    if(data == NULL) return NULL;
+
+    img_cache_entry_t * e = NULL;
+    for(uint16_t i = 0; i < LV_PORT_IMG_CACHE_MAX_ENTRY && e == NULL; i++) {
+        if(entries[i].src == NULL) e = &entries[i];
+    }
+    e->src_type = lv_img_src_get_type(src);
+    if(e->src_type == LV_IMG_SRC_FILE) {
+        char * path = lv_mem_alloc(strlen(src) + 1);
+        if(path == NULL) {
+            lv_mem_free(data);
+            return NULL;
+        }
+        strcpy(path, src);
+        e->src = path;
+    }
+    else {
+        e->src = src;
+    }
+    e->header = header;
+    e->header.cf = cf;
+    e->data = data;
+    e->size = size;
+    e->file_size = file_size;
+    e->mtime = mtime;
+    e->check_tick = lv_tick_get();
+    stat.bytes += size;
+    stat.entries++;
+    if(stat.bytes > stat.peak) stat.peak = stat.bytes;
+    return e;
+}
+
+static lv_res_t cache_info(lv_img_decoder_t * decoder, const void * src, lv_img_header_t * header)
+{
+    LV_UNUSED(decoder);
+    if(bypass || stat.budget == 0) return LV_RES_INV;
+
+    img_cache_entry_t * e = find_entry(src);
+    if(e != NULL) {
+        *header = e->header;
+        return LV_RES_OK;
+    }
+
+    uint32_t hash = src_hash(src);
+    for(uint8_t i = 0; i < REJECT_NUM; i++) {
+        if(rejects[i] == hash) return LV_RES_INV;
+    }
+
+    /*由其他解码器取得原始的格式 只接管放得进预算的图片*/
+    lv_img_header_t inner;
+    bypass = true;
+    lv_res_t res = lv_img_decoder_get_info(src, &inner);
+    bypass = false;
+    if(res != LV_RES_OK) return LV_RES_INV;
+    lv_img_cf_t cf = cached_cf(lv_img_src_get_type(src), inner.cf);
+    if(cf == LV_IMG_CF_UNKNOWN || inner.w * inner.h * px_size(cf) > stat.budget) {
+        rejects[reject_pos] = hash;
+        reject_pos = (reject_pos + 1) % REJECT_NUM;
+        return LV_RES_INV;
+    }
+    *header = inner;
+    header->cf = cf;
+    return LV_RES_OK;
+}
+
+static lv_res_t cache_open(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc)
+{
+    LV_UNUSED(decoder);
+    img_cache_entry_t * e = find_entry(dsc->src);
+    if(e != NULL) {
+        stat.hits++;
+    }
+    else {
+        e = load_entry(dsc->src, dsc->color, dsc->frame_id);
+        if(e == NULL) return LV_RES_INV; /*由其他解码器按原来的方式解码*/
+        stat.misses++;
+    }
+    e->refs++;
+    e->last_use = ++use_tick;
+    dsc->img_data = e->data;
+    dsc->user_data = e;
+    return LV_RES_OK;
+}
+
+static void cache_close(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc)
+{
+    LV_UNUSED(decoder);
+    img_cache_entry_t * e = dsc->user_data;
+    if(e != NULL && e->refs > 0) e->refs--;
+    if(e != NULL && e->refs == 0 && e->stale) free_entry(e);
+    dsc->user_data = NULL;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file lv_port_img_cache.h
+ * 按字节数限制的LVGL图片缓存（LRU）
+ */
+
+#ifndef LV_PORT_IMG_CACHE_H
+#define LV_PORT_IMG_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define LV_PORT_IMG_CACHE_BUDGET (64U * 1024U) /*默认的内存预算（字节） 0不缓存*/
+#define LV_PORT_IMG_CACHE_MAX_ENTRY 16        /*最多缓存的图片数*/
+#define LV_PORT_IMG_CACHE_CHECK_MS 1000       /*文件图片至少间隔多久重新检查一次大小与修改时间*/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct {
+    uint32_t hits;      /*命中次数*/
+    uint32_t misses;    /*解码并加入缓存的次数*/
+    uint32_t evictions; /*因超出预算被淘汰的次数*/
+    uint32_t bytes;     /*当前占用的内存*/
+    uint32_t peak;      /*占用的峰值*/
+    uint32_t budget;
+    uint16_t entries;   /*当前缓存的图片数*/
+} lv_port_img_cache_stat_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+void lv_port_img_cache_init(void);
+void lv_port_img_cache_set_budget(uint32_t budget);
+/*释放所有缓存（APP退出时调用）*/
+void lv_port_img_cache_purge(void);
+void lv_port_img_cache_get_stat(lv_port_img_cache_stat_t * stat);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*LV_PORT_IMG_CACHE_H*/
@@ -0,0 +1,207 @@
+/**
+ * @file lv_port_jpeg.c
+ * 图片源为 "S:/xxx.jpg" 时由此解码器解码（与.bin一样可以使用切换动画与局部刷新）
+ * 不需要整帧的缓冲：read_line按行读取 只缓存当前的一个MCU行（8或16行）
+ * LVGL按从上到下的顺序读取 请求的行在缓存之前时从头重新解码
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_port_jpeg.h"
+#include "tjpgd.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#if LV_COLOR_DEPTH != 16 || JD_FORMAT != 1
+    #error "lv_port_jpeg needs RGB565 (LV_COLOR_DEPTH 16 and JD_FORMAT 1)"
+#endif
+
+#define JPEG_PATH_MAX_LEN 128
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct {
+    lv_fs_file_t file;
+    JDEC jd;
+    void * work;          /*tjpgd的工作区*/
+    lv_color_t * rows;    /*行缓存：最近解码的一个MCU行*/
+    uint16_t rows_y;      /*行缓存中第一行的位置*/
+    uint16_t rows_h;      /*行缓存中的有效行数（0表示为空）*/
+    char path[JPEG_PATH_MAX_LEN];
+} jpeg_ctx_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static lv_res_t decoder_info(lv_img_decoder_t * decoder, const void * src, lv_img_header_t * header);
+static lv_res_t decoder_open(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc);
+static lv_res_t decoder_read_line(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc,
+                                  lv_coord_t x, lv_coord_t y, lv_coord_t len, uint8_t * buf);
+static void decoder_close(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc);
+static bool is_jpeg(const void * src);
+static size_t jpeg_input(JDEC * jd, uint8_t * buf, size_t len);
+static int jpeg_output(JDEC * jd, void * bitmap, JRECT * rect);
+static JRESULT jpeg_prepare(JDEC * jd, lv_fs_file_t * file, void * work, void * dev);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static lv_port_jpeg_read_cb_t ext_read_cb = NULL;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void lv_port_jpeg_init(void)
+{
+    lv_img_decoder_t * dec = lv_img_decoder_create();
+    lv_img_decoder_set_info_cb(dec, decoder_info);
+    lv_img_decoder_set_open_cb(dec, decoder_open);
+    lv_img_decoder_set_read_line_cb(dec, decoder_read_line);
+    lv_img_decoder_set_close_cb(dec, decoder_close);
+}
+
+void lv_port_jpeg_set_read_cb(lv_port_jpeg_read_cb_t read_cb)
+{
+    ext_read_cb = read_cb;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static bool is_jpeg(const void * src)
+{
+    if(lv_img_src_get_type(src) != LV_IMG_SRC_FILE) return false;
+    const char * ext = lv_fs_get_ext(src);
+    return !strcmp(ext, "jpg") || !strcmp(ext, "JPG") || !strcmp(ext, "jpeg") || !strcmp(ext, "JPEG");
+}
+
+static size_t jpeg_input(JDEC * jd, uint8_t * buf, size_t len)
+{
+    lv_fs_file_t * file = (lv_fs_file_t *)jd->device;
+    uint32_t br = 0;
+    if(buf == NULL) {
+        /*跳过数据*/
+        return lv_fs_seek(file, len, LV_FS_SEEK_CUR) == LV_FS_RES_OK ? len : 0;
+    }
+    lv_fs_read(file, buf, len, &br);
+    return br;
+}
+
+static int jpeg_output(JDEC * jd, void * bitmap, JRECT * rect)
+{
+    /*把解码出的块复制到行缓存*/
+    jpeg_ctx_t * ctx = (jpeg_ctx_t *)jd->device;
+    uint16_t w = rect->right - rect->left + 1;
+    const lv_color_t * src = (const lv_color_t *)bitmap;
+    for(uint16_t y = rect->top; y <= rect->bottom; y++) {
+        lv_memcpy(ctx->rows + (y - ctx->rows_y) * jd->width + rect->left, src, w * sizeof(lv_color_t));
+        src += w;
+    }
+    return 1;
+}
+
+static JRESULT jpeg_prepare(JDEC * jd, lv_fs_file_t * file, void * work, void * dev)
+{
+    /*dev为文件或者以文件为第一个成员的jpeg_ctx_t（jpeg_input使用）*/
+    lv_fs_seek(file, 0, LV_FS_SEEK_SET);
+    jd->swap = LV_COLOR_16_SWAP;
+    jd->level = 1;
+    jd->tblclip = 1;
+    return jd_prepare(jd, jpeg_input, work, TJPGD_WORKSPACE_SIZE, dev);
+}
+
+static lv_res_t decoder_info(lv_img_decoder_t * decoder, const void * src, lv_img_header_t * header)
+{
+    LV_UNUSED(decoder);
+    if(!is_jpeg(src)) return LV_RES_INV;
+
+    lv_fs_file_t file;
+    if(lv_fs_open(&file, src, LV_FS_MODE_RD) != LV_FS_RES_OK) return LV_RES_INV;
+    void * work = lv_mem_alloc(TJPGD_WORKSPACE_SIZE);
+    lv_res_t res = LV_RES_INV;
+    if(work != NULL) {
+        JDEC jd;
+        if(jpeg_prepare(&jd, &file, work, &file) == JDR_OK) {
+            header->always_zero = 0;
+            header->cf = LV_IMG_CF_TRUE_COLOR;
+            header->w = jd.width;
+            header->h = jd.height;
+            res = LV_RES_OK;
+        }
+        lv_mem_free(work);
+    }
+    lv_fs_close(&file);
+    return res;
+}
+
+static lv_res_t decoder_open(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc)
+{
+    LV_UNUSED(decoder);
+    if(!is_jpeg(dsc->src)) return LV_RES_INV;
+
+    jpeg_ctx_t * ctx = lv_mem_alloc(sizeof(jpeg_ctx_t));
+    if(ctx == NULL) return LV_RES_INV;
+    lv_memset_00(ctx, sizeof(jpeg_ctx_t));
+    const char * src = dsc->src;
+    lv_snprintf(ctx->path, JPEG_PATH_MAX_LEN, "%s", src[1] == ':' ? src + 2 : src);
+
+    if(lv_fs_open(&ctx->file, src, LV_FS_MODE_RD) != LV_FS_RES_OK) {
+        lv_mem_free(ctx);
+        return LV_RES_INV;
+    }
+    ctx->work = lv_mem_alloc(TJPGD_WORKSPACE_SIZE);
+    if(ctx->work != NULL && jpeg_prepare(&ctx->jd, &ctx->file, ctx->work, ctx) == JDR_OK) {
+        ctx->rows = lv_mem_alloc(ctx->jd.width * ctx->jd.msy * 8 * sizeof(lv_color_t));
+        if(ctx->rows != NULL && jd_decomp_begin(&ctx->jd, 0) == JDR_OK) {
+            dsc->user_data = ctx;
+            dsc->img_data = NULL; /*使用read_line*/
+            return LV_RES_OK;
+        }
+    }
+    dsc->user_data = ctx;
+    decoder_close(decoder, dsc);
+    return LV_RES_INV;
+}
+
+static lv_res_t decoder_read_line(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc,
+                                  lv_coord_t x, lv_coord_t y, lv_coord_t len, uint8_t * buf)
+{
+    LV_UNUSED(decoder);
+    jpeg_ctx_t * ctx = dsc->user_data;
+    JDEC * jd = &ctx->jd;
+    if(ext_read_cb != NULL && ext_read_cb(ctx->path, x, y, len, (lv_color_t *)buf)) return LV_RES_OK;
+    if(y >= jd->height || x + len > jd->width) return LV_RES_INV;
+
+    if(y < ctx->rows_y) {
+        /*向上的行已经不在缓存中 从头重新解码*/
+        ctx->rows_y = 0;
+        ctx->rows_h = 0;
+        if(jpeg_prepare(jd, &ctx->file, ctx->work, ctx) != JDR_OK) return LV_RES_INV;
+        if(jd_decomp_begin(jd, 0) != JDR_OK) return LV_RES_INV;
+    }
+    while(y >= ctx->rows_y + ctx->rows_h) {
+        ctx->rows_y = jd->rowy;
+        ctx->rows_h = 0;
+        if(jd_decomp_row(jd, jpeg_output) != JDR_OK) return LV_RES_INV;
+        ctx->rows_h = LV_MIN(jd->msy * 8, jd->height - ctx->rows_y);
+    }
+    lv_memcpy(buf, ctx->rows + (y - ctx->rows_y) * jd->width + x, len * sizeof(lv_color_t));
+    return LV_RES_OK;
+}
+
+static void decoder_close(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc)
+{
+    LV_UNUSED(decoder);
+    jpeg_ctx_t * ctx = dsc->user_data;
+    if(ctx == NULL) return;
+    lv_fs_close(&ctx->file);
+    if(ctx->work != NULL) lv_mem_free(ctx->work);
+    if(ctx->rows != NULL) lv_mem_free(ctx->rows);
+    lv_mem_free(ctx);
+    dsc->user_data = NULL;
+}
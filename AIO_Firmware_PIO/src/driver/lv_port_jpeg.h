@@ -0,0 +1,46 @@
+/**
+ * @file lv_port_jpeg.h
+ * LVGL的jpg图片解码器（使用TJpg_Decoder库中的tjpgd 按MCU行逐行解码）
+ */
+
+#ifndef LV_PORT_JPEG_H
+#define LV_PORT_JPEG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+/**
+ * 外部已解码画面的读取函数（例如相册的预解码缓存）
+ * path为去掉盘符的路径 能提供这一行时复制到buf并返回true 否则由解码器自己解码
+ */
+typedef bool (*lv_port_jpeg_read_cb_t)(const char * path, lv_coord_t x, lv_coord_t y,
+                                       lv_coord_t len, lv_color_t * buf);
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+void lv_port_jpeg_init(void);
+void lv_port_jpeg_set_read_cb(lv_port_jpeg_read_cb_t read_cb);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*LV_PORT_JPEG_H*/
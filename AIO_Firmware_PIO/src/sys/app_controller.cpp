@@ -3,6 +3,7 @@
 #include "common.h"
 #include "interface.h"
 #include "Arduino.h"
+#include "driver/lv_port_img_cache.h"
 
 const char *app_event_type_info[] = {"APP_MESSAGE_WIFI_CONN", "APP_MESSAGE_WIFI_AP",
                                      "APP_MESSAGE_WIFI_ALIVE", "APP_MESSAGE_WIFI_DISCONN",
@@ -23,6 +24,48 @@ void eventDealHandle(TimerHandle_t xTimer)
     isRunEventDeal = true;
 }
 
+static void print_perf_stats(void)
+{
+    DispStats stats;
+    screen.getStats(&stats);
+    Serial.printf("[Perf]\t%u.%u fps (%u frames in %u ms) render %u us flush %u us area %u px per frame\n",
+                  stats.fps_x10 / 10, stats.fps_x10 % 10, stats.frames, stats.elapsed_ms,
+                  stats.render_us, stats.flush_us, stats.area_px);
+    Serial.printf("[Perf]\tfree heap %u largest %u min %u img cache %u overlay %d\n",
+                  stats.heap_free, stats.heap_largest, stats.heap_min, stats.img_cache,
+                  screen.isOverlay());
+}
+
+static void serial_perf_cmd(void)
+{
+    // 串口命令（换行结束）："perf"打印最近一秒的统计 "perf on"/"perf off"开关性能浮窗
+    static char line[16];
+    static uint8_t len = 0;
+    while (Serial.available())
+    {
+        char c = Serial.read();
+        if ('\r' != c && '\n' != c)
+        {
+            if (len < sizeof(line) - 1)
+            {
+                line[len++] = c;
+            }
+            continue;
+        }
+        line[len] = 0;
+        len = 0;
+        if (!strcmp(line, "perf on") || !strcmp(line, "perf off"))
+        {
+            screen.setOverlay(!strcmp(line, "perf on"));
+            print_perf_stats();
+        }
+        else if (!strcmp(line, "perf"))
+        {
+            print_perf_stats();
+        }
+    }
+}
+
 AppController::AppController(const char *name)
 {
     strncpy(this->name, name, APP_CONTROLLER_NAME_LEN);
@@ -150,6 +193,12 @@ int AppController::main_process(ImuAction *act_info)
         this->req_event_deal();
     }
 
+    // Settings运行时串口由它使用（二进制协议）
+    if (0 == app_exit_flag || strcmp(appList[cur_app_index]->app_name, "Settings"))
+    {
+        serial_perf_cmd();
+    }
+
     // wifi自动关闭(在节能模式下)
     if (0 == sys_cfg.power_mode && true == m_wifi_status && doDelayMillisTime(WIFI_LIFE_CYCLE, &m_preWifiReqMillis, false))
     {
@@ -187,10 +236,16 @@ int AppController::main_process(ImuAction *act_info)
 
         if (ACTIVE_TYPE::GO_FORWORD != act_info->active) // && UNKNOWN != act_info->active
         {
+            screen.perfReset();
             app_control_display_scr(appList[cur_app_index]->app_image,
                                     appList[cur_app_index]->app_name,
                                     anim_type, false);
-            vTaskDelay(200 / portTICK_PERIOD_MS);
+            if (LV_SCR_LOAD_ANIM_NONE != anim_type)
+            {
+                screen.waitAnim(1000); // 让渲染任务刷新屏幕直到动画结束
+                screen.perfReport("carousel"); // 切换动画的帧率
+            }
+            screen.lvglDelay(200);
         }
     }
     else
@@ -412,11 +467,21 @@ void AppController::app_exit()
         }
     }
 
+    // APP投递但还未执行的UI操作 必须在APP释放资源前执行完
+    screen.runPosted();
+
     if (NULL != appList[cur_app_index]->exit_callback)
     {
         // 执行APP退出回调
         (*(appList[cur_app_index]->exit_callback))(NULL);
     }
+    // 释放APP中缓存的图片
+    lv_port_img_cache_stat_t img_stat;
+    lv_port_img_cache_get_stat(&img_stat);
+    Serial.printf("Img cache hit %u miss %u evict %u bytes %u/%u (peak %u) entries %u free heap %u\n",
+                  img_stat.hits, img_stat.misses, img_stat.evictions, img_stat.bytes,
+                  img_stat.budget, img_stat.peak, img_stat.entries, ESP.getFreeHeap());
+    lv_port_img_cache_purge();
     app_control_display_scr(appList[cur_app_index]->app_image,
                             appList[cur_app_index]->app_name,
                             LV_SCR_LOAD_ANIM_NONE, true);
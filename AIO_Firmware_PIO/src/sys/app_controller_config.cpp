@@ -2,6 +2,7 @@
 #include "common.h"
 #include "interface.h"
 #include "Arduino.h"
+#include "driver/lv_port_img_cache.h"
 
 #define APP_CTRL_CONFIG_PATH "/sys.cfg"
 #define MPU_CONFIG_PATH "/mpu.cfg"
@@ -11,9 +12,10 @@ void AppController::read_config(SysUtilConfig *cfg)
 {
     // 如果有需要持久化配置文件 可以调用此函数将数据存在flash中
     // 配置文件名最好以APP名为开头 以".cfg"结尾，以免多个APP读取混乱
-    char info[128] = {0};
+    char info[160] = {0};
     uint16_t size = g_flashCfg.readFile(APP_CTRL_CONFIG_PATH, (uint8_t *)info);
     info[size] = 0;
+    cfg->img_cache_kb = LV_PORT_IMG_CACHE_BUDGET / 1024;
     if (size == 0)
     {
         // 默认值
@@ -28,8 +30,14 @@ void AppController::read_config(SysUtilConfig *cfg)
     else
     {
         // 解析数据
-        char *param[12] = {0};
-        analyseParam(info, 12, param);
+        // 旧版本的配置文件没有图片缓存一项（只解析实际存在的行）
+        int line_num = 0;
+        for (uint16_t pos = 0; pos < size; ++pos)
+        {
+            line_num += '\n' == info[pos];
+        }
+        char *param[13] = {0};
+        analyseParam(info, line_num >= 13 ? 13 : 12, param);
         cfg->ssid_0 = param[0];
         cfg->password_0 = param[1];
         cfg->ssid_1 = param[2];
@@ -42,6 +50,10 @@ void AppController::read_config(SysUtilConfig *cfg)
         cfg->auto_calibration_mpu = atol(param[9]);
         cfg->mpu_order = atol(param[10]);
         cfg->auto_start_app = param[11]; // 开机自启APP的name
+        if (line_num >= 13)
+        {
+            cfg->img_cache_kb = atol(param[12]);
+        }
     }
 }
 
@@ -78,12 +90,18 @@ void AppController::write_config(SysUtilConfig *cfg)
 
     w_data = w_data + cfg->auto_start_app + "\n";
 
+    memset(tmp, 0, 25);
+    snprintf(tmp, 25, "%u\n", cfg->img_cache_kb);
+    w_data += tmp;
+
     g_flashCfg.writeFile(APP_CTRL_CONFIG_PATH, w_data.c_str());
 
     // 立即生效相关配置
     screen.setBackLight(cfg->backLight / 100.0);
     tft->setRotation(cfg->rotation);
     mpu.setOrder(cfg->mpu_order);
+    // 调用者不一定持有LVGL锁（例如网页设置发来的消息） 淘汰缓存会释放LVGL的内存 需要加锁（递归锁）
+    AIO_LVGL_OPERATE_LOCK(lv_port_img_cache_set_budget(cfg->img_cache_kb * 1024U);)
 }
 
 void AppController::read_config(SysMpuConfig *cfg)
@@ -355,6 +373,10 @@ void AppController::deal_config(APP_MESSAGE_TYPE type,
         {
             snprintf(value, 32, "%s", sys_cfg.auto_start_app.c_str());
         }
+        else if (!strcmp(key, "img_cache_kb"))
+        {
+            snprintf(value, 32, "%u", sys_cfg.img_cache_kb);
+        }
     }
     break;
     case APP_MESSAGE_SET_PARAM:
@@ -423,6 +445,10 @@ void AppController::deal_config(APP_MESSAGE_TYPE type,
         {
             sys_cfg.auto_start_app = value;
         }
+        else if (!strcmp(key, "img_cache_kb"))
+        {
+            sys_cfg.img_cache_kb = atol(value);
+        }
     }
     break;
     case APP_MESSAGE_READ_CFG:
@@ -15,6 +15,11 @@ static lv_style_t app_name_style;
 
 LV_FONT_DECLARE(lv_font_montserrat_24);
 
+static void pre_app_anim_ready(lv_anim_t *a)
+{
+    lv_obj_del((lv_obj_t *)a->var); // 移出屏幕后删除原先的图像
+}
+
 void app_control_gui_init(void)
 {
     if (NULL != app_scr)
@@ -154,12 +159,10 @@ void app_control_display_scr(const void *src_img, const char *app_name, lv_scr_l
     duration = lv_anim_speed_to_time(400, old_start_x, old_end_x); // 计算时间
     lv_anim_set_time(&pre_app, duration);
     lv_anim_set_path_cb(&pre_app, lv_anim_path_linear); // 设置一个动画的路径
+    lv_anim_set_ready_cb(&pre_app, pre_app_anim_ready);
 
+    // 不在此处等待动画 由调用者 screen.waitAnim() 让出锁给渲染任务刷新
     lv_anim_start(&now_app);
     lv_anim_start(&pre_app);
-    ANIEND_WAIT
-    lv_task_handler(); // 消除 ANIEND_WAIT 执行完后依然"卡顿一下"的问题
-
-    lv_obj_del(pre_app_image); // 删除原先的图像
     pre_app_image = now_app_image;
 }
\ No newline at end of file
@@ -8,15 +8,6 @@ extern "C"
 
 #include "lvgl.h"
 
-// #define ANIEND_WAIT
-
-#define ANIEND_WAIT                 \
-    while (lv_anim_count_running()) \
-        lv_task_handler(); // 等待动画完成
-
-// #define ANIEND_WAIT                      \
-//     while (lv_anim_count_running());
-
     void app_control_gui_init(void);
     void app_control_gui_release(void);
     void display_app_scr_release(void);
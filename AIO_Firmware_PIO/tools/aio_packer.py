@@ -0,0 +1,192 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+将 .mjpeg / .rgb 视频打包为自描述的 .aio 容器
+
+文件结构（小端）：AioMediaHead(32字节) + 帧表(每帧 offset/size 各4字节) + 帧数据
+格式定义见 src/app/media_player/aio_media.h。播放器根据文件头得到宽高、帧率与最大帧，
+按需分配缓冲并居中显示，也不再需要生成 .idx 索引。
+
+用法：
+python aio_packer.py 240_20fps.mjpeg 240_20fps.aio --fps 20
+python aio_packer.py 180_9fps.rgb 180_9fps.aio --fps 9 --width 180 --height 180
+python aio_packer.py 240_20fps.mjpeg 240_20fps.aio --fps 20 --strip-dht
+
+--strip-dht 去掉每帧中与标准表（JPEG规范附录K.3）相同的哈夫曼表（约420字节/帧），
+播放器对没有DHT的帧使用内置的标准表。使用优化哈夫曼表编码的帧不受影响。
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+AIO_MEDIA_MAGIC = 0x564F4941  # "AIOV"
+AIO_MEDIA_VERSION = 1
+AIO_CODEC_MJPEG = 1
+AIO_CODEC_RGB565 = 2
+HEAD_FORMAT = '<IHHHHBBHIIII'
+HEAD_SIZE = struct.calcsize(HEAD_FORMAT)
+ENTRY_SIZE = 8
+
+# 标准哈夫曼表 {类别<<4|编号: (各码长的码字数, 符号)}
+STD_DC_VALUES = bytes(range(12))
+STD_HUFFMAN_TABLES = {
+    0x00: (bytes([0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0]), STD_DC_VALUES),
+    0x01: (bytes([0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0]), STD_DC_VALUES),
+    0x10: (bytes([0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7D]), bytes.fromhex(
+        '01020300041105122131410613516107227114328191a1082342b1c11552d1f0'
+        '2433627282090a161718191a25262728292a3435363738393a4344454647484'
+        '94a535455565758595a636465666768696a737475767778797a838485868788'
+        '898a92939495969798999aa2a3a4a5a6a7a8a9aab2b3b4b5b6b7b8b9bac2c3c4'
+        'c5c6c7c8c9cad2d3d4d5d6d7d8d9dae1e2e3e4e5e6e7e8e9eaf1f2f3f4f5f6f7'
+        'f8f9fa')),
+    0x11: (bytes([0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77]), bytes.fromhex(
+        '000102031104052131061241510761711322328108144291a1b1c109233352f0'
+        '156272d10a162434e125f11718191a262728292a35363738393a434445464748'
+        '494a535455565758595a636465666768696a737475767778797a828384858687'
+        '88898a92939495969798999aa2a3a4a5a6a7a8a9aab2b3b4b5b6b7b8b9bac2c3'
+        'c4c5c6c7c8c9cad2d3d4d5d6d7d8d9dae2e3e4e5e6e7e8e9eaf2f3f4f5f6f7f8'
+        'f9fa')),
+}
+
+
+def split_jpeg(data):
+    """按jpeg的标记切分出每一帧 返回 [(offset, size)] 以及第一帧的宽高"""
+    frames = []
+    size = None
+    pos = data.find(b'\xff\xd8')
+    while pos >= 0:
+        start = pos
+        pos += 2
+        end = -1
+        while pos + 2 <= len(data):
+            if data[pos] != 0xFF:
+                break
+            marker = data[pos + 1]
+            if marker == 0xFF:
+                pos += 1
+                continue
+            if marker == 0xD9:
+                end = pos + 2
+                break
+            if pos + 4 > len(data):
+                break
+            seg_len = struct.unpack_from('>H', data, pos + 2)[0]
+            if marker in (0xC0, 0xC1, 0xC2) and size is None:
+                h, w = struct.unpack_from('>HH', data, pos + 5)
+                size = (w, h)
+            if marker == 0xDA:
+                # 熵编码数据：跳过填充的FF00与RST标记 直到下一个真正的标记
+                pos += 2 + seg_len
+                while pos + 1 < len(data):
+                    if data[pos] == 0xFF and data[pos + 1] != 0 and not 0xD0 <= data[pos + 1] <= 0xD7:
+                        break
+                    pos += 1
+                continue
+            pos += 2 + seg_len
+        if end < 0:
+            print('warning: truncated frame at %d dropped' % start)
+            break
+        frames.append((start, end - start))
+        pos = data.find(b'\xff\xd8', end)
+    return frames, size
+
+
+def is_std_dht(payload):
+    """DHT段中的哈夫曼表是否全部为标准表"""
+    pos = 0
+    while pos < len(payload):
+        if pos + 17 > len(payload):
+            return False
+        bits = payload[pos + 1:pos + 17]
+        values = payload[pos + 17:pos + 17 + sum(bits)]
+        if STD_HUFFMAN_TABLES.get(payload[pos]) != (bits, values):
+            return False
+        pos += 17 + sum(bits)
+    return True
+
+
+def strip_dht(frame):
+    """去掉帧中的DHT段 帧中有非标准表（或无法解析）时原样返回"""
+    segments = []
+    pos = 2
+    while pos + 4 <= len(frame) and frame[pos] == 0xFF:
+        marker = frame[pos + 1]
+        seg_len = struct.unpack_from('>H', frame, pos + 2)[0]
+        if marker == 0xDA:
+            out = bytearray()
+            last = 0
+            for (start, size) in segments:
+                out += frame[last:start]
+                last = start + size
+            out += frame[last:]
+            return bytes(out)
+        if marker == 0xC4:
+            if not is_std_dht(frame[pos + 4:pos + 2 + seg_len]):
+                return frame
+            segments.append((pos, 2 + seg_len))
+        pos += 2 + seg_len
+    return frame
+
+
+def main():
+    parser = argparse.ArgumentParser(description='.mjpeg/.rgb -> .aio 容器')
+    parser.add_argument('input', help='.mjpeg（连续的jpeg）或 .rgb（rgb565be原始数据）')
+    parser.add_argument('output', help='输出的.aio文件')
+    parser.add_argument('--fps', type=int, default=0, help='视频帧率（0表示未知 播放时不控制速度）')
+    parser.add_argument('--width', type=int, default=240, help='.rgb视频的宽')
+    parser.add_argument('--height', type=int, default=240, help='.rgb视频的高')
+    parser.add_argument('--strip-dht', action='store_true', help='去掉mjpeg帧中的标准哈夫曼表')
+    args = parser.parse_args()
+
+    if not 0 <= args.fps <= 255:
+        sys.exit('fps must be 0~255')
+
+    with open(args.input, 'rb') as f:
+        data = f.read()
+
+    if os.path.splitext(args.input)[1].lower() == '.rgb':
+        codec = AIO_CODEC_RGB565
+        width, height = args.width, args.height
+        frame_size = width * height * 2
+        frames = [(pos, frame_size) for pos in range(0, len(data) - frame_size + 1, frame_size)]
+    else:
+        codec = AIO_CODEC_MJPEG
+        frames, size = split_jpeg(data)
+        if size is None:
+            sys.exit('no jpeg frame found')
+        width, height = size
+
+    if not frames:
+        sys.exit('no frame found')
+
+    frames = [data[start:start + size] for (start, size) in frames]
+    if codec == AIO_CODEC_MJPEG and args.strip_dht:
+        total = sum(len(frame) for frame in frames)
+        frames = [strip_dht(frame) for frame in frames]
+        print('strip DHT: %d -> %d bytes/frame' % (
+            total // len(frames), sum(len(frame) for frame in frames) // len(frames)))
+
+    table_offset = HEAD_SIZE
+    data_offset = table_offset + len(frames) * ENTRY_SIZE
+    max_frame_size = max(len(frame) for frame in frames)
+
+    with open(args.output, 'wb') as f:
+        f.write(struct.pack(HEAD_FORMAT, AIO_MEDIA_MAGIC, AIO_MEDIA_VERSION, HEAD_SIZE,
+                            width, height, args.fps, codec, 0,
+                            len(frames), max_frame_size, table_offset, data_offset))
+        offset = data_offset
+        for frame in frames:
+            f.write(struct.pack('<II', offset, len(frame)))
+            offset += len(frame)
+        for frame in frames:
+            f.write(frame)
+
+    print('%s %dx%d %d fps, %d frames, max frame %d bytes' % (
+        'MJPEG' if codec == AIO_CODEC_MJPEG else 'RGB565',
+        width, height, args.fps, len(frames), max_frame_size))
+
+
+if __name__ == '__main__':
+    main()
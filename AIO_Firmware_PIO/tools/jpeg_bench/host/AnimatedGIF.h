@@ -0,0 +1,9 @@
+// 主机上不编译GIF播放器 只声明 docoder.h 中用到的类型
+#ifndef HOST_ANIMATED_GIF_H
+#define HOST_ANIMATED_GIF_H
+
+class AnimatedGIF;
+typedef struct gif_file_tag GIFFILE;
+typedef struct gif_draw_tag GIFDRAW;
+
+#endif
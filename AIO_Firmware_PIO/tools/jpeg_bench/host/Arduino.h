@@ -0,0 +1,77 @@
+// 主机上编译固件代码用的最小Arduino环境（只提供性能测试用到的部分）
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string>
+#include "freertos_host.h"
+
+typedef bool boolean;
+
+#define F(s) (s)
+#define PROGMEM
+#define memcpy_P memcpy
+
+static inline unsigned long micros(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)(ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+}
+
+static inline unsigned long millis(void)
+{
+    return micros() / 1000;
+}
+
+static inline uint32_t getCpuFrequencyMhz(void)
+{
+    return 240;
+}
+
+// 主机上没有DMA内存的区别 剩余内存无法统计（返回0）
+#define MALLOC_CAP_DMA (1 << 3)
+#define MALLOC_CAP_8BIT (1 << 2)
+static inline void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    return malloc(size);
+}
+static inline size_t heap_caps_get_free_size(uint32_t caps)
+{
+    return 0;
+}
+static inline size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    return 0;
+}
+
+class String : public std::string
+{
+public:
+    String(const char *s = "") : std::string(s) {}
+    String(const std::string &s) : std::string(s) {}
+};
+
+// 串口输出到stderr（stdout留给测试结果）
+class HostSerial
+{
+public:
+    void print(const char *s) { fputs(s, stderr); }
+    void println(const char *s = "") { fprintf(stderr, "%s\n", s); }
+    void printf(const char *fmt, ...)
+    {
+        va_list ap;
+        va_start(ap, fmt);
+        vfprintf(stderr, fmt, ap);
+        va_end(ap);
+    }
+};
+
+[[maybe_unused]] static HostSerial Serial;
+
+#endif
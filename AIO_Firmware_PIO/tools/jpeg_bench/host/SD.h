@@ -0,0 +1,83 @@
+// 主机上的SD卡文件：直接读取本地文件 并统计读取的字节数
+#ifndef HOST_SD_H
+#define HOST_SD_H
+
+#include "Arduino.h"
+#include <memory>
+
+#define FILE_READ "rb"
+#define FILE_WRITE "wb"
+
+class File
+{
+private:
+    std::shared_ptr<FILE> m_fp;
+    std::string m_path;
+
+public:
+    inline static uint64_t s_readBytes = 0; // 所有文件累计读取的字节数
+    // SD卡的读取耗时模型（0为不模拟）：每次读取休眠 s_modelCallUs + 字节数/s_modelKBps
+    inline static uint32_t s_modelKBps = 0;
+    inline static uint32_t s_modelCallUs = 0;
+
+    File() {}
+    File(FILE *fp, const char *path) : m_path(path)
+    {
+        if (NULL != fp)
+        {
+            m_fp.reset(fp, fclose);
+        }
+    }
+
+    size_t read(uint8_t *buf, size_t size)
+    {
+        size_t len = m_fp ? fread(buf, 1, size, m_fp.get()) : 0;
+        s_readBytes += len;
+        if (s_modelKBps > 0 || s_modelCallUs > 0)
+        {
+            uint64_t us = s_modelCallUs + (s_modelKBps > 0 ? (uint64_t)len * 1000000 / (s_modelKBps * 1024ULL) : 0);
+            std::this_thread::sleep_for(std::chrono::microseconds(us));
+        }
+        return len;
+    }
+    size_t write(const uint8_t *buf, size_t size) { return m_fp ? fwrite(buf, 1, size, m_fp.get()) : 0; }
+    const char *name() const { return m_path.c_str(); } // 与旧版ESP32的SD库一样为完整路径
+    bool seek(uint32_t pos) { return m_fp && 0 == fseek(m_fp.get(), pos, SEEK_SET); }
+    size_t position() const { return m_fp ? ftell(m_fp.get()) : 0; }
+    size_t size() const
+    {
+        if (!m_fp)
+        {
+            return 0;
+        }
+        long pos = ftell(m_fp.get());
+        fseek(m_fp.get(), 0, SEEK_END);
+        long end = ftell(m_fp.get());
+        fseek(m_fp.get(), pos, SEEK_SET);
+        return end;
+    }
+    int available() { return size() - position(); }
+    void close() { m_fp.reset(); }
+    operator bool() const { return (bool)m_fp; }
+};
+
+class SDClass
+{
+public:
+    bool exists(const char *path)
+    {
+        FILE *fp = fopen(path, "rb");
+        if (NULL != fp)
+        {
+            fclose(fp);
+        }
+        return NULL != fp;
+    }
+    bool exists(const String &path) { return exists(path.c_str()); }
+    File open(const char *path, const char *mode = FILE_READ) { return File(fopen(path, mode), path); }
+    File open(const String &path, const char *mode = FILE_READ) { return open(path.c_str(), mode); }
+};
+
+static SDClass SD;
+
+#endif
@@ -0,0 +1,438 @@
+// 主机上的TFT_eSPI实现（说明见 TFT_eSPI.h）
+#include "TFT_eSPI.h"
+#include "../../../lib/TFT_eSPI/Fonts/glcdfont.c"
+#include <algorithm>
+
+#define TFT_WINDOW_CMD_NUM 3  // CASET RASET RAMWR
+#define TFT_WINDOW_DATA_NUM 8 // 起止坐标各2字节
+
+static inline uint16_t swap16(uint16_t v)
+{
+    return (uint16_t)(v << 8 | v >> 8);
+}
+
+TFT_eSPI::TFT_eSPI(int16_t w, int16_t h) : m_fb(w * h, 0), m_width(w), m_height(h)
+{
+}
+
+void TFT_eSPI::init(void)
+{
+    m_rotation = 0;
+    m_width = TFT_WIDTH;
+    m_height = TFT_HEIGHT;
+    std::fill(m_fb.begin(), m_fb.end(), 0);
+}
+
+void TFT_eSPI::setRotation(uint8_t r)
+{
+    // 固件中高4位设置镜像 只按低2位决定宽高（画面内容不做镜像）
+    m_rotation = r & 3;
+    m_width = (m_rotation & 1) ? TFT_HEIGHT : TFT_WIDTH;
+    m_height = (m_rotation & 1) ? TFT_WIDTH : TFT_HEIGHT;
+    writecommand(TFT_MADCTL);
+    m_stats.bytes += 1;
+}
+
+void TFT_eSPI::writecommand(uint8_t c)
+{
+    (void)c;
+    begin_trans();
+    m_stats.commands += 1;
+    end_trans();
+}
+
+uint8_t TFT_eSPI::readcommand8(uint8_t cmd, uint8_t index)
+{
+    (void)cmd;
+    (void)index;
+    return 0;
+}
+
+void TFT_eSPI::begin_trans(void)
+{
+    // 嵌套调用（例如fillRect中的setAddrWindow）只算一次传输
+    if (0 == m_transDepth++)
+    {
+        m_stats.transactions += 1;
+    }
+}
+
+void TFT_eSPI::end_trans(void)
+{
+    --m_transDepth;
+}
+
+void TFT_eSPI::startWrite(void)
+{
+    if (!m_inTransaction)
+    {
+        m_inTransaction = true;
+        begin_trans();
+    }
+}
+
+void TFT_eSPI::endWrite(void)
+{
+    if (m_inTransaction)
+    {
+        m_inTransaction = false;
+        end_trans();
+    }
+}
+
+void TFT_eSPI::setAddrWindow(int32_t x, int32_t y, int32_t w, int32_t h)
+{
+    begin_trans();
+    m_winX0 = x;
+    m_winY0 = y;
+    m_winX1 = x + w - 1;
+    m_winY1 = y + h - 1;
+    m_curX = x;
+    m_curY = y;
+    m_stats.windows += 1;
+    m_stats.commands += TFT_WINDOW_CMD_NUM;
+    m_stats.bytes += TFT_WINDOW_DATA_NUM;
+    end_trans();
+}
+
+void TFT_eSPI::write_pixel(uint16_t color)
+{
+    // 窗口外（屏幕外）的像素同样占用总线 但不写入帧缓冲
+    if (m_curX >= 0 && m_curX < m_width && m_curY >= 0 && m_curY < m_height)
+    {
+        m_fb[m_curY * m_width + m_curX] = color;
+    }
+    m_stats.pixels += 1;
+    m_stats.bytes += 2;
+    if (++m_curX > m_winX1)
+    {
+        m_curX = m_winX0;
+        if (++m_curY > m_winY1)
+        {
+            m_curY = m_winY0;
+        }
+    }
+}
+
+void TFT_eSPI::pushColor(uint16_t color)
+{
+    begin_trans();
+    write_pixel(color);
+    end_trans();
+}
+
+void TFT_eSPI::pushColors(uint16_t *data, uint32_t len, bool swap)
+{
+    begin_trans();
+    for (uint32_t i = 0; i < len; ++i)
+    {
+        write_pixel(swap ? data[i] : swap16(data[i]));
+    }
+    end_trans();
+}
+
+void TFT_eSPI::pushColors(uint8_t *data, uint32_t len)
+{
+    // 按字节顺序发送 len为字节数
+    begin_trans();
+    for (uint32_t i = 0; i + 1 < len; i += 2)
+    {
+        write_pixel((uint16_t)(data[i] << 8 | data[i + 1]));
+    }
+    end_trans();
+}
+
+void TFT_eSPI::pushPixels(const void *data, uint32_t len)
+{
+    pushColors((uint16_t *)data, len, m_swapBytes);
+}
+
+void TFT_eSPI::drawPixel(int32_t x, int32_t y, uint32_t color)
+{
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+    {
+        return;
+    }
+    begin_trans();
+    setAddrWindow(x, y, 1, 1);
+    write_pixel(color);
+    end_trans();
+}
+
+void TFT_eSPI::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color)
+{
+    // 与原库一样先裁剪再发送
+    if (x < 0)
+    {
+        w += x;
+        x = 0;
+    }
+    if (y < 0)
+    {
+        h += y;
+        y = 0;
+    }
+    w = std::min<int32_t>(w, m_width - x);
+    h = std::min<int32_t>(h, m_height - y);
+    if (w < 1 || h < 1)
+    {
+        return;
+    }
+    begin_trans();
+    setAddrWindow(x, y, w, h);
+    for (int32_t i = 0; i < w * h; ++i)
+    {
+        write_pixel(color);
+    }
+    end_trans();
+}
+
+void TFT_eSPI::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data)
+{
+    int32_t dx = x < 0 ? -x : 0;
+    int32_t dy = y < 0 ? -y : 0;
+    int32_t dw = std::min<int32_t>(w - dx, m_width - x - dx);
+    int32_t dh = std::min<int32_t>(h - dy, m_height - y - dy);
+    if (dw < 1 || dh < 1)
+    {
+        return;
+    }
+    begin_trans();
+    setAddrWindow(x + dx, y + dy, dw, dh);
+    for (int32_t row = 0; row < dh; ++row)
+    {
+        const uint16_t *line = data + (row + dy) * w + dx;
+        for (int32_t col = 0; col < dw; ++col)
+        {
+            write_pixel(m_swapBytes ? line[col] : swap16(line[col]));
+        }
+    }
+    end_trans();
+}
+
+void TFT_eSPI::drawChar(int32_t x, int32_t y, uint16_t c, uint32_t color, uint32_t bg, uint8_t size)
+{
+    if (c < 32 || x >= m_width || y >= m_height || x + 6 * size - 1 < 0 || y + 8 * size - 1 < 0)
+    {
+        return;
+    }
+    bool fillbg = bg != color;
+    bool clip = x < 0 || x + 6 * size >= m_width || y < 0 || y + 8 * size >= m_height;
+    begin_trans();
+    if (1 == size && fillbg && !clip)
+    {
+        // 原库的快速路径：一个6*9的窗口逐点发送
+        setAddrWindow(x, y, 6, 9);
+        for (int8_t j = 0; j < 9; ++j)
+        {
+            for (int8_t k = 0; k < 6; ++k)
+            {
+                bool on = j < 8 && k < 5 && (font[c * 5 + k] >> j & 1);
+                write_pixel(on ? color : bg);
+            }
+        }
+    }
+    else
+    {
+        // 其他情况按点（放大时按size*size的方块）逐个发送
+        for (int8_t k = 0; k < 6; ++k)
+        {
+            uint8_t column = k < 5 ? font[c * 5 + k] : 0;
+            for (int8_t j = 0; j < 8; ++j)
+            {
+                if (column >> j & 1)
+                {
+                    fillRect(x + k * size, y + j * size, size, size, color);
+                }
+                else if (fillbg)
+                {
+                    fillRect(x + k * size, y + j * size, size, size, bg);
+                }
+            }
+        }
+    }
+    end_trans();
+}
+
+int16_t TFT_eSPI::drawChar(uint16_t uniCode, int32_t x, int32_t y, uint8_t font_num)
+{
+    // 只有GLCD字体 其他字体号按GLCD绘制（宽度与实际字体不同）
+    (void)font_num;
+    drawChar(x, y, uniCode, m_textColor, m_textBgColor, m_textSize);
+    return 6 * m_textSize;
+}
+
+bool TFT_eSPI::initDMA(bool ctrl_cs)
+{
+    (void)ctrl_cs;
+    DMA_Enabled = true;
+    return true;
+}
+
+void TFT_eSPI::pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *image, uint16_t *buffer)
+{
+    if (x >= m_width || y >= m_height || !DMA_Enabled)
+    {
+        return;
+    }
+    int32_t dx = x < 0 ? -x : 0;
+    int32_t dy = y < 0 ? -y : 0;
+    int32_t dw = std::min<int32_t>(w - dx, m_width - x - dx);
+    int32_t dh = std::min<int32_t>(h - dy, m_height - y - dy);
+    if (dw < 1 || dh < 1)
+    {
+        return;
+    }
+    // 与原库相同：没有DMA缓冲时使用图片本身 需要时原地交换字节 裁剪时压紧各行
+    if (nullptr == buffer)
+    {
+        buffer = image;
+    }
+    if (dw != w || dh != h || buffer != image || m_swapBytes)
+    {
+        for (int32_t row = 0; row < dh; ++row)
+        {
+            for (int32_t col = 0; col < dw; ++col)
+            {
+                uint16_t v = image[(row + dy) * w + col + dx];
+                buffer[row * dw + col] = m_swapBytes ? swap16(v) : v;
+            }
+        }
+    }
+    ++m_transDepth;
+    setAddrWindow(x + dx, y + dy, dw, dh);
+    --m_transDepth;
+    pushPixelsDMA(buffer, dw * dh);
+}
+
+void TFT_eSPI::pushPixelsDMA(uint16_t *image, uint32_t len)
+{
+    // DMA按内存中的字节顺序发送
+    // 每次DMA都是单独排队的传输
+    m_stats.transactions += 1;
+    m_stats.dma += 1;
+    ++m_transDepth;
+    pushColors(image, len, false);
+    --m_transDepth;
+}
+
+uint16_t TFT_eSPI::readPixel(int32_t x, int32_t y) const
+{
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+    {
+        return 0;
+    }
+    return m_fb[y * m_width + x];
+}
+
+void TFT_eSPI::resetStats(void)
+{
+    m_stats = {};
+}
+
+double TFT_eSPI::wireMicros(void) const
+{
+    double bits = (double)(m_stats.commands + m_stats.bytes) * 8;
+    return bits * 1e6 / m_spiHz + (double)m_stats.transactions * TFT_HOST_TRANS_NS / 1000;
+}
+
+// PNG：RGB 8bit 不压缩（zlib的stored块） 不依赖其他库
+static uint32_t png_crc(uint32_t crc, const uint8_t *data, size_t len)
+{
+    static uint32_t table[256];
+    if (0 == table[1])
+    {
+        for (uint32_t n = 0; n < 256; ++n)
+        {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k)
+            {
+                c = (c & 1) ? 0xEDB88320UL ^ (c >> 1) : c >> 1;
+            }
+            table[n] = c;
+        }
+    }
+    crc = ~crc;
+    for (size_t i = 0; i < len; ++i)
+    {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void put_be32(std::vector<uint8_t> &out, uint32_t v)
+{
+    out.push_back(v >> 24);
+    out.push_back(v >> 16);
+    out.push_back(v >> 8);
+    out.push_back(v);
+}
+
+static void png_chunk(FILE *fp, const char *type, const std::vector<uint8_t> &data)
+{
+    std::vector<uint8_t> buf;
+    put_be32(buf, data.size());
+    buf.insert(buf.end(), type, type + 4);
+    buf.insert(buf.end(), data.begin(), data.end());
+    put_be32(buf, png_crc(0, buf.data() + 4, buf.size() - 4));
+    fwrite(buf.data(), 1, buf.size(), fp);
+}
+
+bool TFT_eSPI::savePng(const char *path) const
+{
+    FILE *fp = fopen(path, "wb");
+    if (NULL == fp)
+    {
+        return false;
+    }
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    fwrite(signature, 1, sizeof(signature), fp);
+
+    std::vector<uint8_t> ihdr;
+    put_be32(ihdr, m_width);
+    put_be32(ihdr, m_height);
+    ihdr.insert(ihdr.end(), {8, 2, 0, 0, 0}); // 8bit RGB
+    png_chunk(fp, "IHDR", ihdr);
+
+    // 每行：滤波类型0 + RGB888（RGB565按高位补齐）
+    std::vector<uint8_t> raw;
+    raw.reserve(m_height * (1 + m_width * 3));
+    for (int32_t y = 0; y < m_height; ++y)
+    {
+        raw.push_back(0);
+        for (int32_t x = 0; x < m_width; ++x)
+        {
+            uint16_t c = m_fb[y * m_width + x];
+            uint8_t r = c >> 11, g = (c >> 5) & 0x3F, b = c & 0x1F;
+            raw.push_back(r << 3 | r >> 2);
+            raw.push_back(g << 2 | g >> 4);
+            raw.push_back(b << 3 | b >> 2);
+        }
+    }
+    std::vector<uint8_t> idat = {0x78, 0x01};
+    uint32_t a = 1, b = 0;
+    for (size_t pos = 0; pos < raw.size() || 0 == pos;)
+    {
+        size_t len = std::min<size_t>(raw.size() - pos, 65535);
+        idat.push_back(pos + len >= raw.size() ? 1 : 0);
+        idat.push_back(len);
+        idat.push_back(len >> 8);
+        idat.push_back(~len);
+        idat.push_back(~len >> 8);
+        idat.insert(idat.end(), raw.begin() + pos, raw.begin() + pos + len);
+        pos += len;
+        if (0 == len)
+        {
+            break;
+        }
+    }
+    for (uint8_t v : raw)
+    {
+        a = (a + v) % 65521;
+        b = (b + a) % 65521;
+    }
+    put_be32(idat, b << 16 | a);
+    png_chunk(fp, "IDAT", idat);
+    png_chunk(fp, "IEND", {});
+    return 0 == fclose(fp);
+}
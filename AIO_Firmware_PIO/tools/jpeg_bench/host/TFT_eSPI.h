@@ -0,0 +1,134 @@
+// 主机上的TFT_eSPI：画到RGB565帧缓冲中 并按SPI总线的开销统计发送量
+// 只提供固件（common.cpp 中的 tft）用到的接口 写入像素的字节序与ESP32上的TFT_eSPI相同：
+//   swapBytes为true（或pushColors的swap参数为true）时数值按原样显示
+//   否则按内存中的字节顺序发送（小端的主机上相当于交换高低字节）
+// pushImageDMA 与原库一样在swapBytes为true时原地交换源缓冲（未给出DMA缓冲时）
+// drawChar 只有GLCD字体（1号字体） 其他字体号也用GLCD字体按倍数放大绘制 结果与屏幕上的不同
+#ifndef HOST_TFT_ESPI_H
+#define HOST_TFT_ESPI_H
+
+#include "Arduino.h"
+#include <vector>
+
+#ifndef TFT_WIDTH
+#define TFT_WIDTH 240
+#endif
+#ifndef TFT_HEIGHT
+#define TFT_HEIGHT 240
+#endif
+// 与 lib/TFT_eSPI/User_Setup.h 相同
+#ifndef SPI_FREQUENCY
+#define SPI_FREQUENCY 80000000
+#endif
+// 每次传输（拉低CS或发起一次DMA）的固定开销（ns） 用于估计小块发送的代价
+#ifndef TFT_HOST_TRANS_NS
+#define TFT_HOST_TRANS_NS 2000
+#endif
+
+#define TFT_BLACK 0x0000
+#define TFT_WHITE 0xFFFF
+#define TFT_RED 0xF800
+#define TFT_GREEN 0x07E0
+#define TFT_BLUE 0x001F
+
+#define ST7789_DISPON 0x29
+#define TFT_MADCTL 0x36
+
+// 自上次resetStats以来的总线统计
+struct TftHostStats
+{
+    uint64_t windows;      // 设置地址窗口的次数（CASET/RASET/RAMWR）
+    uint64_t commands;     // 发送的命令字节数
+    uint64_t bytes;        // 发送的数据字节数（含地址窗口的参数）
+    uint64_t pixels;       // 发送的像素数（含窗口超出屏幕的部分）
+    uint64_t transactions; // 传输次数（startWrite/endWrite 或一次DMA）
+    uint64_t dma;          // DMA传输次数
+};
+
+class TFT_eSPI
+{
+public:
+    bool DMA_Enabled = false;
+
+    TFT_eSPI(int16_t w = TFT_WIDTH, int16_t h = TFT_HEIGHT);
+
+    void begin(void) { init(); }
+    void init(void);
+    void setRotation(uint8_t r);
+    int16_t width(void) const { return m_width; }
+    int16_t height(void) const { return m_height; }
+    void writecommand(uint8_t c);
+    uint8_t readcommand8(uint8_t cmd, uint8_t index = 0);
+
+    void setSwapBytes(bool swap) { m_swapBytes = swap; }
+    bool getSwapBytes(void) const { return m_swapBytes; }
+    void setTextColor(uint16_t fg, uint16_t bg)
+    {
+        m_textColor = fg;
+        m_textBgColor = bg;
+    }
+    void setTextSize(uint8_t size) { m_textSize = size > 0 ? size : 1; }
+    uint16_t color565(uint8_t r, uint8_t g, uint8_t b) const
+    {
+        return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+    }
+
+    void startWrite(void);
+    void endWrite(void);
+    void setAddrWindow(int32_t x, int32_t y, int32_t w, int32_t h);
+    void pushColor(uint16_t color);
+    void pushColors(uint16_t *data, uint32_t len, bool swap = true);
+    void pushColors(uint8_t *data, uint32_t len);
+    void pushPixels(const void *data, uint32_t len);
+
+    void drawPixel(int32_t x, int32_t y, uint32_t color);
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+    void fillScreen(uint32_t color) { fillRect(0, 0, m_width, m_height, color); }
+    void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color) { fillRect(x, y, w, 1, color); }
+    void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color) { fillRect(x, y, 1, h, color); }
+    void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data);
+    void drawChar(int32_t x, int32_t y, uint16_t c, uint32_t color, uint32_t bg, uint8_t size);
+    int16_t drawChar(uint16_t uniCode, int32_t x, int32_t y, uint8_t font);
+    int16_t drawChar(uint16_t uniCode, int32_t x, int32_t y) { return drawChar(uniCode, x, y, 1); }
+
+    bool initDMA(bool ctrl_cs = false);
+    void deInitDMA(void) { DMA_Enabled = false; }
+    void pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *image, uint16_t *buffer = nullptr);
+    void pushPixelsDMA(uint16_t *image, uint32_t len);
+    bool dmaBusy(void) { return false; } // 主机上立即完成
+    void dmaWait(void) {}
+
+    // 帧缓冲：按当前方向的行优先 每个像素为屏幕上显示的RGB565数值
+    const uint16_t *frameBuffer(void) const { return m_fb.data(); }
+    uint16_t readPixel(int32_t x, int32_t y) const;
+    bool savePng(const char *path) const;
+
+    const TftHostStats &stats(void) const { return m_stats; }
+    void resetStats(void);
+    // 按SPI_FREQUENCY估计的总线占用时间（us）：所有字节的位数 加上每次传输的固定开销
+    double wireMicros(void) const;
+    void setSpiFrequency(uint32_t hz) { m_spiHz = hz; }
+
+private:
+    std::vector<uint16_t> m_fb;
+    int16_t m_width;
+    int16_t m_height;
+    uint8_t m_rotation = 0;
+    bool m_swapBytes = false;
+    bool m_inTransaction = false; // startWrite之后
+    int m_transDepth = 0;
+    uint32_t m_spiHz = SPI_FREQUENCY;
+    uint16_t m_textColor = TFT_WHITE;
+    uint16_t m_textBgColor = TFT_BLACK;
+    uint8_t m_textSize = 1;
+    // 当前地址窗口与写入位置（与屏幕一样写满后回到窗口开头）
+    int32_t m_winX0 = 0, m_winY0 = 0, m_winX1 = 0, m_winY1 = 0;
+    int32_t m_curX = 0, m_curY = 0;
+    TftHostStats m_stats = {};
+
+    void begin_trans(void);
+    void end_trans(void);
+    void write_pixel(uint16_t color);
+};
+
+#endif
@@ -0,0 +1,16 @@
+// 主机上编译媒体播放器用的 common.h（只提供解码器用到的全局对象与宏）
+#ifndef HOST_COMMON_H
+#define HOST_COMMON_H
+
+#define GET_SYS_MILLIS xTaskGetTickCount // 获取系统毫秒数
+
+#include "Arduino.h"
+#include "driver/sd_card.h"
+#include <TFT_eSPI.h>
+
+#define SCREEN_HOR_RES 240 // 水平
+#define SCREEN_VER_RES 240 // 竖直
+
+extern TFT_eSPI *tft;
+
+#endif
@@ -0,0 +1,18 @@
+// 主机上的SD卡对象（固件 driver/sd_card.h 中媒体播放用到的部分）
+#ifndef HOST_SD_CARD_H
+#define HOST_SD_CARD_H
+
+#include "SD.h"
+
+#define FILENAME_MAX_LEN 100
+
+class SdCard
+{
+public:
+    File open(const String &path, const char *mode = FILE_READ) { return SD.open(path, mode); }
+    void deleteFile(const char *path) { remove(path); }
+};
+
+extern SdCard tf;
+
+#endif
@@ -0,0 +1,157 @@
+// 主机上的FreeRTOS：用std::thread实现播放器用到的任务、队列与信号量（由host/Arduino.h包含）
+// 只模拟行为：任务不绑定核、不区分优先级 一个tick为1ms
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdFAIL 0
+#define pdPASS 1
+#define portMAX_DELAY 0xFFFFFFFFUL
+#define portTICK_PERIOD_MS 1
+
+// 队列与信号量共用一个实现：信号量是元素大小为0的队列
+struct HostQueue
+{
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<std::vector<uint8_t>> items;
+    uint32_t length;
+    uint32_t item_size;
+    uint32_t count; // 信号量的计数
+};
+typedef HostQueue *QueueHandle_t;
+typedef HostQueue *SemaphoreHandle_t;
+typedef std::thread *TaskHandle_t;
+
+static inline bool host_wait(HostQueue *q, std::unique_lock<std::mutex> &lock, TickType_t ticks,
+                             bool (*ready)(HostQueue *))
+{
+    if (portMAX_DELAY == ticks)
+    {
+        q->cond.wait(lock, [q, ready] { return ready(q); });
+        return true;
+    }
+    return q->cond.wait_for(lock, std::chrono::milliseconds(ticks), [q, ready] { return ready(q); });
+}
+
+static inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    HostQueue *q = new HostQueue;
+    q->length = length;
+    q->item_size = item_size;
+    q->count = 0;
+    return q;
+}
+
+static inline BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lock(q->mutex);
+    if (!host_wait(q, lock, ticks, [](HostQueue *h) { return h->items.size() < h->length; }))
+    {
+        return pdFALSE;
+    }
+    const uint8_t *p = (const uint8_t *)item;
+    q->items.emplace_back(p, p + q->item_size);
+    q->cond.notify_all();
+    return pdTRUE;
+}
+
+static inline BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lock(q->mutex);
+    if (!host_wait(q, lock, ticks, [](HostQueue *h) { return !h->items.empty(); }))
+    {
+        return pdFALSE;
+    }
+    memcpy(item, q->items.front().data(), q->item_size);
+    q->items.pop_front();
+    q->cond.notify_all();
+    return pdTRUE;
+}
+
+static inline void vQueueDelete(QueueHandle_t q) { delete q; }
+
+static inline SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t init)
+{
+    HostQueue *q = xQueueCreate(max, 0);
+    q->count = init;
+    return q;
+}
+
+static inline SemaphoreHandle_t xSemaphoreCreateBinary(void) { return xSemaphoreCreateCounting(1, 0); }
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void) { return xSemaphoreCreateCounting(1, 1); }
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t q, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lock(q->mutex);
+    if (!host_wait(q, lock, ticks, [](HostQueue *h) { return h->count > 0; }))
+    {
+        return pdFALSE;
+    }
+    --q->count;
+    return pdTRUE;
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t q)
+{
+    std::lock_guard<std::mutex> lock(q->mutex);
+    if (q->count >= q->length)
+    {
+        return pdFALSE;
+    }
+    ++q->count;
+    q->cond.notify_all();
+    return pdTRUE;
+}
+
+static inline void vSemaphoreDelete(SemaphoreHandle_t q) { delete q; }
+
+// 任务函数最后调用 vTaskDelete(NULL) 之后返回即结束线程
+static inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t func, const char *name, uint32_t stack,
+                                                 void *param, UBaseType_t priority, TaskHandle_t *handle,
+                                                 BaseType_t core)
+{
+    std::thread *task = new std::thread(func, param);
+    task->detach();
+    if (NULL != handle)
+    {
+        *handle = task;
+    }
+    return pdPASS;
+}
+
+static inline void vTaskDelete(TaskHandle_t task)
+{
+    if (NULL != task)
+    {
+        delete task;
+    }
+}
+
+static inline void vTaskDelay(TickType_t ticks)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+static inline TickType_t xTaskGetTickCount(void)
+{
+    using namespace std::chrono;
+    return (TickType_t)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+#endif
@@ -0,0 +1,239 @@
+/*
+ * tjpgd 解码级别的主机端性能测试
+ *
+ * 用同一组jpeg分别以 级别1/级别2（查表解哈夫曼码） × 比较限幅/查表限幅 解码，
+ * 打印每种组合的平均耗时（us/帧）、实际使用的工作区字节数，并检查各组合的输出一致。
+ * 主机上的耗时只用于比较各组合的相对快慢，与ESP32上的绝对值无关。
+ *
+ * 在 AIO_Firmware_PIO 目录下编译运行：
+ * gcc -O2 -Ilib/TJpg_Decoder/src tools/jpeg_bench/jpeg_bench.c lib/TJpg_Decoder/src/tjpgd.c -o jpeg_bench
+ * ./jpeg_bench                 # 使用默认的测试图片（库自带的示例图片）
+ * ./jpeg_bench -n 50 a.jpg ... # 指定重复次数与图片
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "tjpgd.h"
+
+#define BENCH_DEFAULT_LOOPS 20
+#define BENCH_WORKSPACE_SIZE TJPGD_WORKSPACE_SIZE_LUT
+
+/* 默认的测试图片（相对于 AIO_Firmware_PIO 目录） */
+static const char *default_corpus[] = {
+    "lib/TJpg_Decoder/examples/SPIFFS/All_SPIFFS/Data/panda.jpg",
+    "lib/TJpg_Decoder/examples/SPIFFS/All_SPIFFS/Data/tiger.jpg",
+    "lib/TJpg_Decoder/examples/SPIFFS/All_SPIFFS/Data/Baboon40.jpg",
+    "lib/TFT_eSPI/examples/Generic/ESP32_SDcard_jpeg/Data/EagleEye.jpg",
+    "lib/TFT_eSPI/examples/Generic/ESP32_SDcard_jpeg/Data/lena20k.jpg",
+    "lib/TFT_eSPI/examples/Generic/ESP32_SDcard_jpeg/Data/Mouse480.jpg",
+};
+
+typedef struct
+{
+    uint8_t level;
+    uint8_t tblclip;
+    const char *name;
+} BenchMode;
+
+static const BenchMode modes[] = {
+    {1, 0, "level1"},
+    {1, 1, "level1+tblclip"},
+    {2, 0, "level2"},
+    {2, 1, "level2+tblclip"},
+};
+
+typedef struct
+{
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+    uint32_t sum; // 输出像素的校验和（用于确认各级别的输出一致）
+} BenchInput;
+
+static uint8_t workspace[BENCH_WORKSPACE_SIZE] __attribute__((aligned(4)));
+
+static size_t bench_input(JDEC *jd, uint8_t *buf, size_t len)
+{
+    BenchInput *in = (BenchInput *)jd->device;
+    if (len > in->size - in->pos)
+    {
+        len = in->size - in->pos;
+    }
+    if (buf)
+    {
+        memcpy(buf, in->data + in->pos, len);
+    }
+    in->pos += len;
+    return len;
+}
+
+static int bench_output(JDEC *jd, void *bitmap, JRECT *rect)
+{
+    BenchInput *in = (BenchInput *)jd->device;
+    const uint16_t *pix = (const uint16_t *)bitmap;
+    uint32_t num = (uint32_t)(rect->right - rect->left + 1) * (rect->bottom - rect->top + 1);
+    while (num--)
+    {
+        in->sum = in->sum * 31 + *pix++;
+    }
+    return 1;
+}
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static uint8_t *load_file(const char *path, size_t *size)
+{
+    FILE *fp = fopen(path, "rb");
+    if (NULL == fp)
+    {
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    *size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    uint8_t *data = (uint8_t *)malloc(*size);
+    if (NULL != data && fread(data, 1, *size, fp) != *size)
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(fp);
+    return data;
+}
+
+/* 解码一次 返回结果码 并输出校验和、尺寸与工作区使用量 */
+static JRESULT decode_once(const uint8_t *data, size_t size, const BenchMode *mode,
+                           uint32_t *sum, uint16_t *w, uint16_t *h, size_t *used)
+{
+    JDEC jd;
+    BenchInput in = {data, size, 0, 0};
+    jd.swap = 0;
+    jd.level = mode->level;
+    jd.tblclip = mode->tblclip;
+    JRESULT rc = jd_prepare(&jd, bench_input, workspace, sizeof(workspace), &in);
+    if (JDR_OK != rc)
+    {
+        return rc;
+    }
+    *used = sizeof(workspace) - jd.sz_pool;
+    *w = jd.width;
+    *h = jd.height;
+    rc = jd_decomp(&jd, bench_output, 0);
+    *sum = in.sum;
+    return rc;
+}
+
+int main(int argc, char **argv)
+{
+    int loops = BENCH_DEFAULT_LOOPS;
+    const char **files = default_corpus;
+    int file_num = sizeof(default_corpus) / sizeof(default_corpus[0]);
+    int mode_num = sizeof(modes) / sizeof(modes[0]);
+    int argi = 1;
+
+    if (argi + 1 < argc && 0 == strcmp(argv[argi], "-n"))
+    {
+        loops = atoi(argv[argi + 1]);
+        argi += 2;
+    }
+    if (argi < argc)
+    {
+        files = (const char **)&argv[argi];
+        file_num = argc - argi;
+    }
+    if (loops <= 0)
+    {
+        fprintf(stderr, "usage: %s [-n loops] [file.jpg ...]\n", argv[0]);
+        return 2;
+    }
+
+    double total_us[sizeof(modes) / sizeof(modes[0])] = {0};
+    int decoded = 0;
+    int failed = 0;
+
+    printf("%-28s %9s", "file", "size");
+    for (int m = 0; m < mode_num; ++m)
+    {
+        printf(" %15s", modes[m].name);
+    }
+    printf("   (us/frame, workspace bytes)\n");
+
+    for (int f = 0; f < file_num; ++f)
+    {
+        size_t size = 0;
+        uint8_t *data = load_file(files[f], &size);
+        const char *name = strrchr(files[f], '/') ? strrchr(files[f], '/') + 1 : files[f];
+        if (NULL == data)
+        {
+            printf("%-28s open failed\n", name);
+            ++failed;
+            continue;
+        }
+
+        uint32_t ref_sum = 0;
+        uint16_t w = 0, h = 0;
+        double us[sizeof(modes) / sizeof(modes[0])];
+        size_t used[sizeof(modes) / sizeof(modes[0])];
+        JRESULT rc = JDR_OK;
+        for (int m = 0; m < mode_num && JDR_OK == rc; ++m)
+        {
+            uint32_t sum = 0;
+            rc = decode_once(data, size, &modes[m], &sum, &w, &h, &used[m]); // 预热
+            if (JDR_OK != rc)
+            {
+                break;
+            }
+            if (0 == m)
+            {
+                ref_sum = sum;
+            }
+            else if (sum != ref_sum)
+            {
+                printf("%-28s output of %s differs\n", name, modes[m].name);
+                ++failed;
+            }
+            double start = now_us();
+            for (int i = 0; i < loops; ++i)
+            {
+                decode_once(data, size, &modes[m], &sum, &w, &h, &used[m]);
+            }
+            us[m] = (now_us() - start) / loops;
+        }
+        free(data);
+        if (JDR_OK != rc)
+        {
+            printf("%-28s decode failed (%d)\n", name, rc);
+            ++failed;
+            continue;
+        }
+
+        char dim[16];
+        snprintf(dim, sizeof(dim), "%ux%u", w, h);
+        printf("%-28s %9s", name, dim);
+        for (int m = 0; m < mode_num; ++m)
+        {
+            printf(" %8.0f %6zu", us[m], used[m]);
+            total_us[m] += us[m];
+        }
+        printf("\n");
+        ++decoded;
+    }
+
+    if (decoded > 0)
+    {
+        printf("%-28s %9s", "average", "");
+        for (int m = 0; m < mode_num; ++m)
+        {
+            printf(" %8.0f %6s", total_us[m] / decoded, "");
+        }
+        printf("\n");
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,441 @@
+/*
+ * 媒体播放解码路径的主机端性能测试
+ *
+ * 在电脑上运行固件中的 TJpg_Decoder/tjpgd.c 与媒体播放器的解码对象（MjpegPlayDocoder、RgbPlayDocoder
+ * 及其使用的帧索引、播放时钟、缓冲池 FreeRTOS与SD卡由host/中的替身提供） 测量以下播放路径：
+ *   jpeg    相册的方式：drawSdJpg 从文件边读边解码
+ *   mjpeg   MjpegPlayDocoder 串行播放（DMA输出）：读入环形缓冲、查找0xFFD9切帧、两段式 drawJpg 解码
+ *   mjpeg-pipe 同一视频的流水线播放：读卡任务切帧 解码任务解码并推屏（主机上为两个线程）
+ *   rgb565  RgbPlayDocoder 不使用DMA：整帧设置一次地址窗口后 pushColors（数据由mjpeg的每帧画面生成）
+ *   rgb-dma RgbPlayDocoder 使用DMA：每 RGB_STRIP_HEIGHT 行 pushImageDMA 一次（媒体播放器使用的方式）
+ * 每项打印每帧耗时的分布（p50/p95/max）、平均每帧读取的字节数与等效帧率，
+ * --json 输出机器可读的结果便于对比不同版本。主机上的耗时只用于比较代码改动前后的快慢。
+ * 画面经由主机上的TFT_eSPI（host/TFT_eSPI.h）写入帧缓冲 同时统计每帧设置地址窗口的次数、
+ * 传输的次数、发送的字节数 并按SPI_FREQUENCY估计总线占用时间（wire） --png 把每项的最后一帧保存为图片
+ *
+ * 在 tools/jpeg_bench 目录下 make bench 编译并运行（默认使用仓库中自带的示例图片与视频）
+ * ./media_bench [-n loops] [-l level] [-s scale] [--sd-kbps KB/s] [--sd-us us] [--json out.json] [--png dir] [file.jpg|file.mjpeg ...]
+ * -l 只作用于jpeg（视频使用播放器的 MJPEG_DECODE_LEVEL）
+ * -s 2 视频按播放器的低功耗模式以1/2分辨率解码 输出时每个像素放大为2*2
+ * --sd-kbps/--sd-us 按SD卡的读取速度（KB/s）与每次读取的固定延时（us）让读取的线程休眠 默认不模拟
+ *   本机文件几乎没有读取延时 需要模拟SD卡才能看出流水线播放把读卡与解码重叠的效果
+ */
+
+#include <TJpg_Decoder.h>
+#include <TFT_eSPI.h>
+#include "common.h"
+#include "../../src/app/media_player/docoder.h"
+#include <stdlib.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define BENCH_SCREEN_WIDTH 240
+#define BENCH_SCREEN_HEIGHT 240
+#define BENCH_DEFAULT_LOOPS 20
+
+// 默认的测试数据（相对于 AIO_Firmware_PIO 目录）
+static const char *default_corpus[] = {
+    "lib/TJpg_Decoder/examples/SPIFFS/All_SPIFFS/Data/panda.jpg",
+    "lib/TJpg_Decoder/examples/SPIFFS/All_SPIFFS/Data/tiger.jpg",
+    "lib/TFT_eSPI/examples/Generic/ESP32_SDcard_jpeg/Data/EagleEye.jpg",
+    "lib/TFT_eSPI/examples/Generic/ESP32_SDcard_jpeg/Data/lena20k.jpg",
+    "lib/Arduino_GFX/examples/ImgViewer/ImgViewerMjpeg/data/earth.mjpeg",
+};
+
+struct BenchResult
+{
+    std::string name;
+    std::string file;
+    std::vector<double> frame_us; // 每帧耗时
+    uint64_t read_bytes;
+    double scan_us;   // 查找帧结束标志的累计耗时（mjpeg）
+    double header_us; // 解析jpeg头的累计耗时
+    TftHostStats tft; // 屏幕总线的累计统计
+    double wire_us;   // 估计的总线累计占用时间
+    int level;        // 实际使用的解码级别（rgb为0）
+};
+
+// 代替屏幕（与 common.cpp 相同的全局对象 播放器的解码对象直接使用）
+TFT_eSPI *tft = new TFT_eSPI(BENCH_SCREEN_WIDTH, BENCH_SCREEN_HEIGHT);
+SdCard tf;
+static const char *s_png_dir = NULL;
+static uint8_t s_workspace[TJPGD_WORKSPACE_SIZE_LUT] __attribute__((aligned(4)));
+static int s_level = 2;
+static int s_scale = 1;
+
+static bool tft_output(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *bitmap)
+{
+    if (2 == s_scale)
+    {
+        // 与 MjpegPlayDocoder 的放大显示相同（MCU最大16*16）
+        static uint16_t zoom[32 * 32];
+        for (uint16_t row = 0; row < h; ++row)
+        {
+            uint16_t *line = zoom + row * 2 * w * 2;
+            for (uint16_t col = 0; col < w; ++col)
+            {
+                line[col * 2] = line[col * 2 + 1] = bitmap[row * w + col];
+            }
+            memcpy(line + w * 2, line, w * 4);
+        }
+        tft->pushImage(x * 2, y * 2, w * 2, h * 2, zoom);
+        return true;
+    }
+    tft->pushImage(x, y, w, h, bitmap);
+    return true;
+}
+
+static const char *base_name(const std::string &path)
+{
+    size_t pos = path.find_last_of('/');
+    return path.c_str() + (std::string::npos == pos ? 0 : pos + 1);
+}
+
+static bool has_suffix(const std::string &s, const char *suffix)
+{
+    size_t len = strlen(suffix);
+    return s.size() >= len && 0 == strcasecmp(s.c_str() + s.size() - len, suffix);
+}
+
+// 一项测试结束：记录总线统计 需要时保存最后一帧
+static void finish_result(BenchResult &r, std::vector<BenchResult> &results)
+{
+    r.tft = tft->stats();
+    r.wire_us = tft->wireMicros();
+    if (NULL != s_png_dir)
+    {
+        std::string png = std::string(s_png_dir) + "/" + r.name + "_" + base_name(r.file) + ".png";
+        if (!tft->savePng(png.c_str()))
+        {
+            fprintf(stderr, "%s: save failed\n", png.c_str());
+        }
+    }
+    results.push_back(r);
+}
+
+static double percentile(const std::vector<double> &sorted, double p)
+{
+    // 最近秩法
+    size_t rank = (size_t)(p * sorted.size() + 0.999999);
+    if (rank < 1)
+    {
+        rank = 1;
+    }
+    return sorted[std::min(rank, sorted.size()) - 1];
+}
+
+static void bench_jpeg(const std::string &path, int loops, std::vector<BenchResult> &results)
+{
+    BenchResult r = {"jpeg", path, {}, 0, 0, 0, {}, 0, 0};
+    // 视频的解码对象退出时会还原解码器的设置 每项重新设置
+    TJpgDec.setJpgScale(s_scale);
+    TJpgDec.setCallback(tft_output);
+    TJpgDec.setWorkspace(s_workspace, sizeof(s_workspace));
+    TJpgDec.setDecodeLevel(s_level);
+    TJpgDec.setStreamMode(false);
+    // 按块 pushImage 时屏幕按原样显示解码输出的数值 测试完还原（与屏幕驱动的默认值相同）
+    bool swap = tft->getSwapBytes();
+    tft->setSwapBytes(true);
+    File::s_readBytes = 0;
+    tft->resetStats();
+    JRESULT rc = JDR_OK;
+    for (int i = 0; i < loops && JDR_OK == rc; ++i)
+    {
+        unsigned long start = micros();
+        rc = TJpgDec.drawSdJpg(0, 0, path.c_str());
+        r.frame_us.push_back(micros() - start);
+        r.header_us += TJpgDec.prepareMicros;
+    }
+    tft->setSwapBytes(swap);
+    if (JDR_OK != rc)
+    {
+        fprintf(stderr, "%s: decode failed (%d)\n", path.c_str(), rc);
+        return;
+    }
+    r.read_bytes = File::s_readBytes;
+    r.level = TJpgDec.decodeLevel;
+    finish_result(r, results);
+}
+
+// 把文件复制到临时目录（播放器会在视频旁生成帧索引 不写入仓库中的示例目录）
+static bool copy_file(const std::string &src, const std::string &dst)
+{
+    FILE *in = fopen(src.c_str(), "rb");
+    FILE *out = NULL == in ? NULL : fopen(dst.c_str(), "wb");
+    bool isOk = NULL != out;
+    char buf[8192];
+    size_t len = 0;
+    while (isOk && (len = fread(buf, 1, sizeof(buf), in)) > 0)
+    {
+        isOk = len == fwrite(buf, 1, len, out);
+    }
+    if (NULL != in)
+    {
+        fclose(in);
+    }
+    if (NULL != out)
+    {
+        fclose(out);
+    }
+    return isOk;
+}
+
+// 运行固件中的 MjpegPlayDocoder（与媒体播放器相同 使用DMA输出） isPipeline为true时读卡与解码分别在两个任务中
+// rgb不为NULL时把显示的每一帧写入该文件（.rgb视频 高字节在前 写入的耗时不计入帧耗时 只用于串行播放）
+static void bench_mjpeg(const std::string &path, const std::string &tmp, bool isPipeline, FILE *rgb,
+                        std::vector<BenchResult> &results)
+{
+    BenchResult r = {isPipeline ? "mjpeg-pipe" : "mjpeg", path, {}, 0, 0, 0, {}, 0, 0};
+    char idx_path[FILENAME_MAX_LEN];
+    MjpegIndex::get_index_path(idx_path, tmp.c_str());
+    remove(idx_path); // 每项都从没有帧索引的首次播放开始
+    File file = SD.open(tmp.c_str(), FILE_READ);
+    if (!file)
+    {
+        fprintf(stderr, "%s: open failed\n", tmp.c_str());
+        return;
+    }
+    File::s_readBytes = 0;
+    tft->resetStats();
+
+    MjpegPlayDocoder *decoder = new MjpegPlayDocoder(&file, true, isPipeline, NULL);
+    decoder->video_set_low_power(2 == s_scale);
+    uint32_t shown = 0;
+    unsigned long last = micros();
+    while (!decoder->video_is_end())
+    {
+        if (!decoder->video_play_screen())
+        {
+            break;
+        }
+        // 播放器在帧之间处理按键 这里记录每次调用显示的帧数（流水线模式下一次可能显示了多帧 平均分配耗时）
+        uint32_t total = decoder->m_frameCount;
+        if (total == shown)
+        {
+            continue;
+        }
+        unsigned long now = micros();
+        for (uint32_t i = shown; i < total; ++i)
+        {
+            r.frame_us.push_back((double)(now - last) / (total - shown));
+        }
+        shown = total;
+        if (NULL != rgb && !isPipeline)
+        {
+            const uint16_t *fb = tft->frameBuffer();
+            for (int i = 0; i < BENCH_SCREEN_WIDTH * BENCH_SCREEN_HEIGHT; ++i)
+            {
+                uint8_t be[2] = {(uint8_t)(fb[i] >> 8), (uint8_t)fb[i]};
+                fwrite(be, 2, 1, rgb);
+            }
+        }
+        last = micros();
+    }
+    r.scan_us = decoder->m_scanMicros; // 主机上不按周期清零（见Makefile中的MJPEG_FPS_REPORT_FRAMES）
+    r.header_us = decoder->m_headerMicros;
+    r.read_bytes = File::s_readBytes;
+    r.level = TJpgDec.decodeLevel;
+    delete decoder;
+    file.close();
+    remove(idx_path);
+    if (!r.frame_us.empty())
+    {
+        finish_result(r, results);
+    }
+}
+
+// 运行固件中的 RgbPlayDocoder：isUseDMA为false时整帧设置一次地址窗口后 pushColors
+// 为true时按 RGB_STRIP_HEIGHT 行的条带交替 pushImageDMA（媒体播放器使用的方式）
+// path为生成画面的原视频（用于显示） rgb为生成的.rgb文件
+static void bench_rgb(const std::string &path, const std::string &rgb, bool isUseDMA,
+                      std::vector<BenchResult> &results)
+{
+    BenchResult r = {isUseDMA ? "rgb-dma" : "rgb565", path, {}, 0, 0, 0, {}, 0, 0};
+    File file = SD.open(rgb.c_str(), FILE_READ);
+    if (!file)
+    {
+        return;
+    }
+    File::s_readBytes = 0;
+    tft->resetStats();
+    RgbPlayDocoder *decoder = new RgbPlayDocoder(&file, isUseDMA, RGB_STRIP_HEIGHT, NULL);
+    while (!decoder->video_is_end())
+    {
+        unsigned long start = micros();
+        if (!decoder->video_play_screen())
+        {
+            break;
+        }
+        r.frame_us.push_back(micros() - start);
+    }
+    r.read_bytes = File::s_readBytes;
+    delete decoder;
+    file.close();
+    if (!r.frame_us.empty())
+    {
+        finish_result(r, results);
+    }
+}
+
+static void print_results(const std::vector<BenchResult> &results, FILE *json)
+{
+    printf("%-10s %-16s %6s %9s %9s %9s %9s %10s %8s %9s %7s %7s\n",
+           "case", "file", "frames", "p50(us)", "p95(us)", "max(us)", "head(us)", "B/frame", "fps",
+           "wire(us)", "win/f", "trans/f");
+    if (NULL != json)
+    {
+        fprintf(json, "[\n");
+    }
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchResult &r = results[i];
+        std::vector<double> sorted = r.frame_us;
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0;
+        for (double us : sorted)
+        {
+            sum += us;
+        }
+        size_t n = sorted.size();
+        double mean = sum / n;
+        double p50 = percentile(sorted, 0.50);
+        double p95 = percentile(sorted, 0.95);
+        double max = sorted.back();
+        double fps = mean > 0 ? 1e6 / mean : 0;
+        printf("%-10s %-16s %6zu %9.0f %9.0f %9.0f %9.1f %10.0f %8.1f %9.0f %7.0f %7.0f\n",
+               r.name.c_str(), base_name(r.file), n, p50, p95, max,
+               r.header_us / n, (double)r.read_bytes / n, fps,
+               r.wire_us / n, (double)r.tft.windows / n, (double)r.tft.transactions / n);
+        if (NULL != json)
+        {
+            fprintf(json,
+                    "  {\"case\": \"%s\", \"file\": \"%s\", \"level\": %d, \"scale\": %d, \"frames\": %zu, "
+                    "\"mean_us\": %.1f, \"p50_us\": %.1f, \"p95_us\": %.1f, \"max_us\": %.1f, "
+                    "\"header_us\": %.1f, \"scan_us\": %.1f, \"bytes_per_frame\": %.1f, \"fps\": %.2f, "
+                    "\"wire_us\": %.1f, \"windows_per_frame\": %.1f, \"spi_bytes_per_frame\": %.1f, "
+                    "\"transactions_per_frame\": %.1f, \"dma_per_frame\": %.1f}%s\n",
+                    r.name.c_str(), r.file.c_str(), r.level, s_scale, n, mean, p50, p95, max,
+                    r.header_us / n, r.scan_us / n, (double)r.read_bytes / n, fps,
+                    r.wire_us / n, (double)r.tft.windows / n, (double)(r.tft.commands + r.tft.bytes) / n,
+                    (double)r.tft.transactions / n, (double)r.tft.dma / n,
+                    i + 1 < results.size() ? "," : "");
+        }
+    }
+    if (NULL != json)
+    {
+        fprintf(json, "]\n");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int loops = BENCH_DEFAULT_LOOPS;
+    const char *json_path = NULL;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (0 == strcmp(argv[i], "-n") && i + 1 < argc)
+        {
+            loops = atoi(argv[++i]);
+        }
+        else if (0 == strcmp(argv[i], "-l") && i + 1 < argc)
+        {
+            s_level = atoi(argv[++i]);
+        }
+        else if (0 == strcmp(argv[i], "-s") && i + 1 < argc)
+        {
+            s_scale = atoi(argv[++i]);
+        }
+        else if (0 == strcmp(argv[i], "--sd-kbps") && i + 1 < argc)
+        {
+            File::s_modelKBps = atoi(argv[++i]);
+        }
+        else if (0 == strcmp(argv[i], "--sd-us") && i + 1 < argc)
+        {
+            File::s_modelCallUs = atoi(argv[++i]);
+        }
+        else if (0 == strcmp(argv[i], "--json") && i + 1 < argc)
+        {
+            json_path = argv[++i];
+        }
+        else if (0 == strcmp(argv[i], "--png") && i + 1 < argc)
+        {
+            s_png_dir = argv[++i];
+        }
+        else if ('-' == argv[i][0])
+        {
+            fprintf(stderr, "usage: %s [-n loops] [-l level] [-s scale] [--sd-kbps KB/s] [--sd-us us] [--json out.json] [--png dir] [file.jpg|file.mjpeg ...]\n", argv[0]);
+            return 2;
+        }
+        else
+        {
+            files.push_back(argv[i]);
+        }
+    }
+    if (files.empty())
+    {
+        files.assign(default_corpus, default_corpus + sizeof(default_corpus) / sizeof(default_corpus[0]));
+    }
+    if (loops <= 0)
+    {
+        loops = BENCH_DEFAULT_LOOPS;
+    }
+    if (1 != s_scale && 2 != s_scale)
+    {
+        s_scale = 1;
+    }
+
+    g_mediaBufPool.begin("media_bench");
+    const char *tmp_dir = getenv("TMPDIR");
+    std::string tmp = std::string(tmp_dir ? tmp_dir : "/tmp") + "/media_bench";
+
+    std::vector<BenchResult> results;
+    size_t expect = 0;
+    for (const std::string &path : files)
+    {
+        if (has_suffix(path, ".mjpeg"))
+        {
+            // mjpeg播放时把每帧画面写成.rgb视频 再用同样的画面测试rgb的两种输出方式
+            std::string clip = tmp + ".mjpeg";
+            std::string rgb = tmp + ".rgb";
+            FILE *out = fopen(rgb.c_str(), "wb");
+            expect += 4;
+            if (!copy_file(path, clip) || NULL == out)
+            {
+                fprintf(stderr, "%s: copy to %s failed\n", path.c_str(), tmp.c_str());
+                if (NULL != out)
+                {
+                    fclose(out);
+                }
+                continue;
+            }
+            bench_mjpeg(path, clip, false, out, results);
+            fclose(out);
+            bench_mjpeg(path, clip, true, NULL, results);
+            bench_rgb(path, rgb, false, results);
+            bench_rgb(path, rgb, true, results);
+            remove(clip.c_str());
+            remove(rgb.c_str());
+        }
+        else
+        {
+            ++expect;
+            bench_jpeg(path, loops, results);
+        }
+    }
+    g_mediaBufPool.end("media_bench");
+
+    FILE *json = NULL;
+    if (NULL != json_path && NULL == (json = fopen(json_path, "w")))
+    {
+        fprintf(stderr, "%s: open failed\n", json_path);
+        return 1;
+    }
+    print_results(results, json);
+    if (NULL != json)
+    {
+        fclose(json);
+    }
+    return results.size() == expect ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+/*
+ * tjpgd 表缓存（jd_prepare_cached）的主机端检查
+ *
+ * 用标准哈夫曼表的示例图片拼成去掉DHT段的mjpeg（与 aio_packer.py --strip-dht 的输出相同），
+ * 按播放器的方式逐帧以表缓存解码，检查：
+ *   - 每帧的输出与带DHT的原图用 jd_prepare 解码的结果一致
+ *   - 同一帧再解一次时所有表段（包括隐含的标准哈夫曼表）都被复用
+ * 失败时返回非0
+ *
+ * 在 AIO_Firmware_PIO 目录下编译运行（或 make check）：
+ * gcc -O2 -Ilib/TJpg_Decoder/src tools/jpeg_bench/tjpgd_check.c lib/TJpg_Decoder/src/tjpgd.c -o tjpgd_check
+ * ./tjpgd_check
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tjpgd.h"
+
+#define CHECK_WORKSPACE_SIZE TJPGD_WORKSPACE_SIZE_LUT
+
+/* 哈夫曼表为标准表的示例图片（相对于 AIO_Firmware_PIO 目录） 依次作为mjpeg中的帧 */
+static const char *check_corpus[] = {
+    "lib/TJpg_Decoder/examples/SPIFFS/All_SPIFFS/Data/tiger.jpg",
+    "lib/TFT_eSPI/examples/Sprite/Animated_dial/data/dial.jpg",
+};
+
+typedef struct
+{
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+    uint32_t sum; // 输出像素的校验和
+} CheckInput;
+
+static uint8_t workspace[CHECK_WORKSPACE_SIZE] __attribute__((aligned(4)));     // 表缓存所在的工作区
+static uint8_t ref_workspace[CHECK_WORKSPACE_SIZE] __attribute__((aligned(4))); // 参考解码用 不破坏缓存的表
+static int failed = 0;
+
+static size_t check_input(JDEC *jd, uint8_t *buf, size_t len)
+{
+    CheckInput *in = (CheckInput *)jd->device;
+    if (len > in->size - in->pos)
+    {
+        len = in->size - in->pos;
+    }
+    if (buf)
+    {
+        memcpy(buf, in->data + in->pos, len);
+    }
+    in->pos += len;
+    return len;
+}
+
+static int check_output(JDEC *jd, void *bitmap, JRECT *rect)
+{
+    CheckInput *in = (CheckInput *)jd->device;
+    const uint16_t *pix = (const uint16_t *)bitmap;
+    uint32_t num = (uint32_t)(rect->right - rect->left + 1) * (rect->bottom - rect->top + 1);
+    while (num--)
+    {
+        in->sum = in->sum * 31 + *pix++;
+    }
+    return 1;
+}
+
+static uint8_t *load_file(const char *path, size_t *size)
+{
+    FILE *fp = fopen(path, "rb");
+    if (NULL == fp)
+    {
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    *size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    uint8_t *data = (uint8_t *)malloc(*size);
+    if (NULL != data && fread(data, 1, *size, fp) != *size)
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(fp);
+    return data;
+}
+
+/* 原地去掉SOS之前的所有DHT段 返回新的长度（找不到SOS时返回0） */
+static size_t strip_dht(uint8_t *data, size_t size)
+{
+    size_t pos = 2;
+    while (pos + 4 <= size && 0xFF == data[pos])
+    {
+        uint8_t marker = data[pos + 1];
+        size_t seg_len = 2 + ((size_t)data[pos + 2] << 8 | data[pos + 3]);
+        if (0xDA == marker)
+        {
+            return size;
+        }
+        if (0xC4 == marker)
+        {
+            memmove(data + pos, data + pos + seg_len, size - pos - seg_len);
+            size -= seg_len;
+            continue;
+        }
+        pos += seg_len;
+    }
+    return 0;
+}
+
+/* 解码一帧 tc为NULL时不使用表缓存 */
+static JRESULT decode(const uint8_t *data, size_t size, JDCACHE *tc, uint32_t *sum)
+{
+    JDEC jd;
+    CheckInput in = {data, size, 0, 0};
+    jd.swap = 0;
+    jd.level = 2;
+    jd.tblclip = 1;
+    JRESULT rc = tc ? jd_prepare_cached(&jd, check_input, workspace, sizeof(workspace), &in, tc)
+                    : jd_prepare(&jd, check_input, ref_workspace, sizeof(ref_workspace), &in);
+    if (JDR_OK == rc)
+    {
+        rc = jd_decomp(&jd, check_output, 0);
+    }
+    *sum = in.sum;
+    return rc;
+}
+
+static void expect(int cond, const char *name, const char *what)
+{
+    printf("%-4s %-12s %s\n", cond ? "ok" : "FAIL", name, what);
+    if (!cond)
+    {
+        ++failed;
+    }
+}
+
+int main(void)
+{
+    int file_num = sizeof(check_corpus) / sizeof(check_corpus[0]);
+    JDCACHE tc;
+    memset(&tc, 0, sizeof(tc));
+
+    for (int f = 0; f < file_num; ++f)
+    {
+        size_t size = 0;
+        uint8_t *data = load_file(check_corpus[f], &size);
+        const char *name = strrchr(check_corpus[f], '/') + 1;
+        if (NULL == data)
+        {
+            expect(0, name, "open");
+            continue;
+        }
+        uint32_t ref_sum = 0;
+        uint32_t sum = 0;
+        JRESULT rc = decode(data, size, NULL, &ref_sum); // 带DHT 不使用缓存的参考输出
+        expect(JDR_OK == rc, name, "reference decode");
+
+        size_t stripped = strip_dht(data, size);
+        expect(stripped > 0 && stripped < size, name, "strip DHT");
+
+        // 第一帧：接在上一张图片之后 表段与上一帧相同的部分复用 其余重建
+        rc = decode(data, stripped, &tc, &sum);
+        expect(JDR_OK == rc && sum == ref_sum, name, "stripped frame 1 matches the reference");
+        printf("     %-12s frame 1: %u/%u table segments reused\n", "", tc.nhit, tc.nseg);
+
+        // 第二帧：与上一帧相同 所有表段都应复用
+        rc = decode(data, stripped, &tc, &sum);
+        expect(JDR_OK == rc && sum == ref_sum, name, "stripped frame 2 matches the reference");
+        printf("     %-12s frame 2: %u/%u table segments reused\n", "", tc.nhit, tc.nseg);
+        expect(tc.nseg > 0 && tc.nhit == tc.nseg, name, "stripped frame 2 reuses every table");
+        free(data);
+    }
+
+    printf("%s\n", failed ? "FAILED" : "PASSED");
+    return failed ? 1 : 0;
+}
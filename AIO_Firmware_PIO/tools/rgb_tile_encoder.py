@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+将ffmpeg导出的RGB565原始视频(.rgb)转换为分块差分格式(.trgb)
+
+每帧只保存与上一帧相比发生变化的块（同一行中连续的变化块合并为一个块段），
+块段内的像素使用RLE编码。画面大部分静止的视频体积小很多，播放时SD卡读取量
+与屏幕刷新量都随之减少。文件格式见 src/app/media_player/docoder.h 中的 TileVideoHead。
+
+用法：
+ffmpeg -i input.mp4 -vf "fps=20,scale=-1:240:flags=lanczos,crop=240:in_h:(in_w-240)/2:0" -c:v rawvideo -pix_fmt rgb565be 240_20fps.rgb
+python rgb_tile_encoder.py 240_20fps.rgb 240_20fps.trgb --fps 20
+"""
+
+import argparse
+import struct
+import sys
+
+TILE_VIDEO_MAGIC = 0x42475254  # "TRGB"
+TILE_VIDEO_VERSION = 1
+TILE_FRAME_KEY = 0x01
+
+RLE_MAX_NUM = 128   # 一个RLE包最多包含的像素数
+RLE_REPEAT = 0x80
+
+
+def rle_encode(pixels):
+    """pixels 为逐个像素(2字节)的列表 返回RLE编码后的数据"""
+    out = bytearray()
+    literal = []
+
+    def flush_literal():
+        while literal:
+            chunk = literal[:RLE_MAX_NUM]
+            del literal[:RLE_MAX_NUM]
+            out.append(len(chunk) - 1)
+            out.extend(b''.join(chunk))
+
+    i = 0
+    total = len(pixels)
+    while i < total:
+        run = 1
+        while i + run < total and run < RLE_MAX_NUM and pixels[i + run] == pixels[i]:
+            run += 1
+        if run >= 2:
+            # 两个以上相同像素用重复包更省空间（3字节 <= 2*run字节）
+            flush_literal()
+            out.append(RLE_REPEAT | (run - 1))
+            out.extend(pixels[i])
+        else:
+            literal.append(pixels[i])
+        i += run
+    flush_literal()
+    return bytes(out)
+
+
+def run_pixels(frame, width, tile, x, y, count):
+    """取出块段矩形内逐行排列的像素"""
+    row_bytes = width * 2
+    left = x * tile * 2
+    right = left + count * tile * 2
+    pixels = []
+    for row in range(y * tile, (y + 1) * tile):
+        line = frame[row * row_bytes + left: row * row_bytes + right]
+        pixels.extend(line[k:k + 2] for k in range(0, len(line), 2))
+    return pixels
+
+
+def tile_changed(frame, prev, width, tile, x, y):
+    row_bytes = width * 2
+    left = x * tile * 2
+    right = left + tile * 2
+    for row in range(y * tile, (y + 1) * tile):
+        start = row * row_bytes
+        if frame[start + left: start + right] != prev[start + left: start + right]:
+            return True
+    return False
+
+
+def encode_frame(frame, prev, width, height, tile, is_key):
+    tiles_x = width // tile
+    tiles_y = height // tile
+    runs = []
+    for y in range(tiles_y):
+        x = 0
+        while x < tiles_x:
+            if not is_key and not tile_changed(frame, prev, width, tile, x, y):
+                x += 1
+                continue
+            start = x
+            while x < tiles_x and (is_key or tile_changed(frame, prev, width, tile, x, y)):
+                x += 1
+            runs.append((start, y, x - start))
+
+    body = bytearray()
+    for (x, y, count) in runs:
+        body.extend(struct.pack('<BBB', x, y, count))
+        body.extend(rle_encode(run_pixels(frame, width, tile, x, y, count)))
+    head = struct.pack('<IHBB', len(body), len(runs), TILE_FRAME_KEY if is_key else 0, 0)
+    return head + bytes(body), sum(r[2] for r in runs)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='RGB565(.rgb) -> 分块差分视频(.trgb)')
+    parser.add_argument('input', help='ffmpeg导出的rgb565be原始视频')
+    parser.add_argument('output', help='输出的.trgb文件')
+    parser.add_argument('--width', type=int, default=240)
+    parser.add_argument('--height', type=int, default=240)
+    parser.add_argument('--fps', type=int, default=0, help='视频帧率（0不控制播放速度）')
+    parser.add_argument('--tile', type=int, default=16, help='块的边长')
+    parser.add_argument('--keyint', type=int, default=0, help='关键帧间隔（0表示只有第一帧）')
+    args = parser.parse_args()
+
+    if args.width % args.tile or args.height % args.tile:
+        sys.exit('width/height must be multiples of tile size')
+    if args.width // args.tile > 255 or args.height // args.tile > 255 or not 0 < args.tile <= 64:
+        sys.exit('invalid tile size')
+    if not 0 <= args.fps <= 255:
+        sys.exit('fps must be 0~255')
+
+    frame_size = args.width * args.height * 2
+    total_tiles = (args.width // args.tile) * (args.height // args.tile)
+    frame_num = 0
+    tile_num = 0
+    with open(args.input, 'rb') as fin, open(args.output, 'wb') as fout:
+        fout.write(struct.pack('<IHHHBBI', TILE_VIDEO_MAGIC, TILE_VIDEO_VERSION,
+                               args.width, args.height, args.tile, args.fps, 0))
+        prev = None
+        while True:
+            frame = fin.read(frame_size)
+            if len(frame) < frame_size:
+                break
+            is_key = prev is None or (args.keyint > 0 and frame_num % args.keyint == 0)
+            data, tiles = encode_frame(frame, prev, args.width, args.height, args.tile, is_key)
+            fout.write(data)
+            prev = frame
+            frame_num += 1
+            tile_num += tiles
+        # 回写总帧数
+        fout.seek(12)
+        fout.write(struct.pack('<I', frame_num))
+        out_size = fout.seek(0, 2)
+
+    if frame_num:
+        print('%d frames, %.1f%% tiles changed, %d -> %d bytes (%.1f%%)' % (
+            frame_num, 100.0 * tile_num / (frame_num * total_tiles),
+            frame_num * frame_size, out_size, 100.0 * out_size / (frame_num * frame_size)))
+
+
+if __name__ == '__main__':
+    main()